@@ -0,0 +1,177 @@
+/*
+ * Функции разбора аргументов для fastcall/vectorcall точек входа
+ */
+
+#ifndef PY_WIDGETS_ARGS_H
+#define PY_WIDGETS_ARGS_H
+
+#include <Python.h>
+#include <limits.h>
+#include <stdint.h>
+#include <string.h>
+#include <QString>
+
+// Все функции возвращают 1 при успехе и 0 при ошибке (с выставленным исключением),
+//  как конвертеры для PyArg_ParseTuple
+
+static inline int PyWidgets_CheckArgsCount(const char* name, Py_ssize_t nargs, Py_ssize_t expected) {
+    if (nargs != expected) {
+        PyErr_Format(PyExc_TypeError, "%s() takes exactly %zd argument(s) (%zd given)",
+            name, expected, nargs);
+        return 0;
+    }
+    return 1;
+}
+
+// Объект библиотеки мог быть удален Qt (вместе с родителем), пока обертка жива
+static inline int PyWidgets_CheckAlive(const void* impl) {
+    if (impl == NULL) {
+        PyErr_SetString(PyExc_RuntimeError, "underlying Qt object has been deleted");
+        return 0;
+    }
+    return 1;
+}
+
+static inline int PyWidgets_CheckNoKwargs(const char* name, Py_ssize_t kwargsCount) {
+    if (kwargsCount != 0) {
+        PyErr_Format(PyExc_TypeError, "%s() takes no keyword arguments", name);
+        return 0;
+    }
+    return 1;
+}
+
+static inline int PyWidgets_ToInt(PyObject* obj, int* result) {
+    long value = PyLong_AsLong(obj);
+    if (value == -1 && PyErr_Occurred()) {
+        return 0;
+    }
+    if (value > INT_MAX || value < INT_MIN) {
+        PyErr_SetString(PyExc_OverflowError, "signed integer is out of int range");
+        return 0;
+    }
+    *result = (int) value;
+    return 1;
+}
+
+static inline int PyWidgets_ToDouble(PyObject* obj, double* result) {
+    double value = PyFloat_AsDouble(obj);
+    if (value == -1.0 && PyErr_Occurred()) {
+        return 0;
+    }
+    *result = value;
+    return 1;
+}
+
+static inline int PyWidgets_ToBool(PyObject* obj, bool* result) {
+    int value = PyObject_IsTrue(obj);
+    if (value < 0) {
+        return 0;
+    }
+    *result = value != 0;
+    return 1;
+}
+
+static inline int PyWidgets_ToString(PyObject* obj, const char** result) {
+    if (!PyUnicode_Check(obj)) {
+        PyErr_Format(PyExc_TypeError, "expected str, got %.200s", Py_TYPE(obj)->tp_name);
+        return 0;
+    }
+    Py_ssize_t size = 0;
+    const char* value = PyUnicode_AsUTF8AndSize(obj, &size);
+    if (value == NULL) {
+        return 0;
+    }
+    if ((Py_ssize_t) strlen(value) != size) {
+        PyErr_SetString(PyExc_ValueError, "embedded null character");
+        return 0;
+    }
+    *result = value;
+    return 1;
+}
+
+static inline int PyWidgets_CheckUnicode(PyObject* obj) {
+    if (!PyUnicode_Check(obj)) {
+        PyErr_Format(PyExc_TypeError, "expected str, got %.200s", Py_TYPE(obj)->tp_name);
+        return 0;
+    }
+    return 1;
+}
+
+// str -> QString за один проход прямо из внутреннего представления строки Python
+//  (PEP 393), без кодирования в UTF-8 и обратного декодирования в Qt: латиница копируется
+//  с расширением байтов, строки из BMP - как есть, остальное - через UCS-4
+static inline int PyWidgets_UnicodeToQString(PyObject* str, QString* result) {
+#if PY_VERSION_HEX < 0x030C0000
+    if (PyUnicode_READY(str) < 0) {
+        return 0;
+    }
+#endif
+    Py_ssize_t length = PyUnicode_GET_LENGTH(str);
+    if (length > INT_MAX) {
+        PyErr_SetString(PyExc_OverflowError, "string is too long");
+        return 0;
+    }
+    const void* data = PyUnicode_DATA(str);
+    switch (PyUnicode_KIND(str)) {
+    case PyUnicode_1BYTE_KIND:
+        *result = QString::fromLatin1((const char*) data, (int) length);
+        break;
+    case PyUnicode_2BYTE_KIND:
+        // Не fromUtf16: тот пропускает BOM в начале строки
+        *result = QString((const QChar*) data, (int) length);
+        break;
+    default:
+        *result = QString::fromUcs4((const uint*) data, (int) length);
+        break;
+    }
+    return 1;
+}
+
+// Строки с длиной от MIN до MAX запоминаются: повторная установка того же объекта str
+//  (заголовок, шаблон текста) обходится без преобразования. Кэш держит строки живыми,
+//  поэтому длина ограничена сверху: всего он удерживает не больше
+//  SIZE * MAX * (4 + 2) байт (str UCS-4 и QString), около 1.5 МБ
+#define PY_WIDGETS_STRING_CACHE_MIN_LENGTH 256
+#define PY_WIDGETS_STRING_CACHE_MAX_LENGTH 4096
+#define PY_WIDGETS_STRING_CACHE_SIZE 64
+
+// Кэш по адресу объекта. Запись держит ссылку на строку, поэтому адрес не может достаться
+//  другой строке, пока запись жива, а str неизменяема. Обращения - под GIL
+struct PyWidgetsStringCacheEntry {
+    PyObject* key;
+    QString value;
+};
+
+// Кэш свой у каждого интерпретатора и лежит в состоянии модуля (PyWidgetsClasses.h).
+//  NULL, если модуль в этом интерпретаторе не загружен
+static PyWidgetsStringCacheEntry* PyWidgets_GetStringCache();
+
+static inline int PyWidgets_ToQString(PyObject* obj, QString* result) {
+    if (!PyWidgets_CheckUnicode(obj)) {
+        return 0;
+    }
+    Py_ssize_t length = PyUnicode_GET_LENGTH(obj);
+    if (length < PY_WIDGETS_STRING_CACHE_MIN_LENGTH || length > PY_WIDGETS_STRING_CACHE_MAX_LENGTH) {
+        return PyWidgets_UnicodeToQString(obj, result);
+    }
+    PyWidgetsStringCacheEntry* cache = PyWidgets_GetStringCache();
+    if (cache == NULL) {
+        return PyWidgets_UnicodeToQString(obj, result);
+    }
+    // Объекты выровнены по 16 байт, младшие биты адреса всегда нулевые
+    PyWidgetsStringCacheEntry& entry = cache[((uintptr_t) obj >> 4) % PY_WIDGETS_STRING_CACHE_SIZE];
+    if (entry.key != obj) {
+        QString value;
+        if (!PyWidgets_UnicodeToQString(obj, &value)) {
+            return 0;
+        }
+        Py_INCREF(obj);
+        Py_XSETREF(entry.key, obj);
+        entry.value = value;
+    }
+    // QString разделяет данные неявно, копия - это счетчик ссылок
+    *result = entry.value;
+    return 1;
+}
+
+#endif // PY_WIDGETS_ARGS_H
@@ -6,99 +6,741 @@
 #define PY_WIDGETS_CLASSES_H
 
 #include <Python.h>
+#include <structmember.h>
+#include <atomic>
+#include <cstring>
+#include <type_traits>
+#include "PyWidgetsArgs.h"
 #include "PyWidgetsMacroses.h"
+#include "PyWidgetsListSource.h"
+#include "PyWidgetsSignals.h"
+#include "PyWidgetsState.h"
+#include "PyWidgetsTableColumns.h"
+#include "PyWidgetsThreads.h"
 #include "widgets.h"
 
+// Имя модуля задает его .cpp до включения заголовков: под этим именем модуль кладет себя
+//  в словарь интерпретатора, где его находит PyWidgets_FindState
+#ifndef PY_WIDGETS_MODULE_NAME
+#error "PY_WIDGETS_MODULE_NAME must be defined before including PyWidgetsClasses.h"
+#endif
+
+// Статические типы были неизменяемыми, а типы без tp_new не создавались из Python.
+//  У типов из спецификации это задают флаги, появившиеся в 3.10; для 3.9 tp_new
+//  снимается в PyWidgets_ExecModule
+#if PY_VERSION_HEX >= 0x030A0000
+#define PY_WIDGETS_TPFLAGS_IMMUTABLE Py_TPFLAGS_IMMUTABLETYPE
+#define PY_WIDGETS_TPFLAGS_NO_NEW Py_TPFLAGS_DISALLOW_INSTANTIATION
+#else
+#define PY_WIDGETS_TPFLAGS_IMMUTABLE 0
+#define PY_WIDGETS_TPFLAGS_NO_NEW 0
+#endif
+
+// Компактный тег типа обертки, по которому за O(1) находится запись в таблице типов модуля
+enum PyWidgetsTypeTag : unsigned char {
+    PyWidgetsTag_Unknown = 0,
+    PyWidgetsTag_Application,
+    PyWidgetsTag_Widget,
+    PyWidgetsTag_VBoxLayout,
+    PyWidgetsTag_Label,
+    PyWidgetsTag_PushButton,
+    PyWidgetsTag_ListView,
+    PyWidgetsTag_TableView,
+    PyWidgetsTag_Image,
+    PyWidgetsTag_Plot,
+    PyWidgetsTag_LogView,
+    PyWidgetsTag_Count
+};
+
+// Общее начало всех оберток из PY_CLASS_WRAPPER
+struct PyWidgetsObject {
+    PyObject_HEAD
+    PyWidgetsTypeTag tag;
+    // Объект библиотеки держит ссылку на обертку, пока у него есть обработчики сигналов:
+    //  они вызываются с этой оберткой и берут вызываемые объекты из callbacks. В 3.13t -
+    //  все время привязки (PY_WIDGETS_BINDING_HOLDS_REF)
+    bool isKeptAlive;
+    PyObject* callbacks;  // список вызываемых объектов или NULL
+    PyObject* weakreflist;
+    uint64_t handle;      // без GIL выдается при привязке, см. PyApplication_IsUpdateByHandle
+};
+
+// Ссылка снимается, когда объект библиотеки удален или обертка собрана сборщиком мусора.
+//  Без GIL сборщик работает в любом потоке, поэтому флаг меняется в критической секции
+static void PyWidgets_ReleaseKeepAlive(PyWidgetsObject* self) {
+    bool wasKeptAlive;
+    PY_WIDGETS_BEGIN_CRITICAL_SECTION(self);
+    wasKeptAlive = self->isKeptAlive;
+    self->isKeptAlive = false;
+    PY_WIDGETS_END_CRITICAL_SECTION();
+    if (wasKeptAlive) {
+        Py_DECREF(self);
+    }
+}
+
+// Запоминает обработчик в обертке и возвращает его индекс для PyWidgets_GetCallback, -1 при ошибке.
+//  Обработчики Qt хранят только этот индекс и слабую ссылку на обертку (PyWidgets_NewOwnerRef),
+//  поэтому циклы через обработчики видны сборщику мусора (см. Py_Traverse##ClassName)
+static Py_ssize_t PyWidgets_AddCallback(PyWidgetsObject* self, PyObject* callable) {
+    Py_ssize_t index = -1;
+    PY_WIDGETS_BEGIN_CRITICAL_SECTION(self);
+    if ((self->callbacks != NULL || (self->callbacks = PyList_New(0)) != NULL) &&
+        PyList_Append(self->callbacks, callable) == 0)
+    {
+        if (!self->isKeptAlive) {
+            self->isKeptAlive = true;
+            Py_INCREF(self);
+        }
+        index = PyList_GET_SIZE(self->callbacks) - 1;
+    }
+    PY_WIDGETS_END_CRITICAL_SECTION();
+    return index;
+}
+
+// Объект без родителя принадлежит обертке, а через него и все его потомки. Поэтому ссылки,
+//  которыми эти объекты держат свои обертки (isKeptAlive), для сборщика мусора исходят
+//  от нее - иначе не собрать цикл "окно -> кнопка -> обработчик -> окно".
+//  Дерево Qt обходится только из его потока: в другом оно может меняться
+static int PyWidgets_VisitOwnedWrappers(PyWidgetsObject* self, Object* root, visitproc visit, void* arg) {
+    if (Object_HasParent(root) || root->GetQObject()->thread() != QThread::currentThread()) {
+        return 0;
+    }
+    if (self->isKeptAlive) {
+        Py_VISIT((PyObject*)self);
+    }
+    int result = 0;
+    auto visitWrapper = [&result, visit, arg](Object* object) {
+        PyWidgetsObject* wrapper = (PyWidgetsObject*)Object_GetBinding(object);
+        if (result == 0 && wrapper != NULL && wrapper->isKeptAlive) {
+            result = visit((PyObject*)wrapper, arg);
+        }
+    };
+    Object_ForEachDescendant(root->GetQObject(), visitWrapper);
+    return result;
+}
+
+// Новая ссылка или NULL, если обработчики уже очищены сборщиком мусора. Без GIL сборщик
+//  может очистить их, пока обработчик выполняется, поэтому заимствованной ссылки мало
+static PyObject* PyWidgets_GetCallback(PyWidgetsObject* self, Py_ssize_t index) {
+    PyObject* callable = NULL;
+    PY_WIDGETS_BEGIN_CRITICAL_SECTION(self);
+    if (self->callbacks != NULL && index < PyList_GET_SIZE(self->callbacks)) {
+        callable = PyList_GET_ITEM(self->callbacks, index);
+        Py_INCREF(callable);
+    }
+    PY_WIDGETS_END_CRITICAL_SECTION();
+    return callable;
+}
+
+// Сборщик мусора может очистить и освободить обертку раньше, чем удален объект библиотеки,
+//  поэтому обработчики Qt держат ее по слабой ссылке. Саму ссылку отпускает под GIL
+//  последняя копия обработчика, которую Qt разрушает без GIL. NULL при ошибке
+static std::shared_ptr<PyObject> PyWidgets_NewOwnerRef(PyWidgetsObject* owner) {
+    PyObject* weakref = PyWeakref_NewRef((PyObject*)owner, NULL);
+    if (weakref == NULL) {
+        return nullptr;
+    }
+    std::shared_ptr<PyObject> holder = PyWidgets_HoldRef(weakref);
+    Py_DECREF(weakref);
+    return holder;
+}
+
+// Обертка по слабой ссылке и ее обработчик index - новые ссылки; false, если обертки
+//  или обработчиков уже нет. Под GIL
+static bool PyWidgets_LookupCallback(PyObject* ownerRef, Py_ssize_t index, PyObject** owner, PyObject** callable) {
+    *callable = NULL;
+#if PY_VERSION_HEX >= 0x030D0000
+    if (PyWeakref_GetRef(ownerRef, owner) <= 0) {
+        return false;
+    }
+#else
+    *owner = PyWeakref_GetObject(ownerRef);
+    if (*owner == Py_None) {
+        return false;
+    }
+    Py_INCREF(*owner);
+#endif
+    *callable = PyWidgets_GetCallback((PyWidgetsObject*)*owner, index);
+    if (*callable == NULL) {
+        Py_CLEAR(*owner);
+        return false;
+    }
+    return true;
+}
+
+// Типизированные приведения pImpl, заполняются в REGISTER_TYPE.
+//  impl - указатель на класс библиотеки, соответствующий тегу
+struct PyWidgetsTypeInfo {
+    PyTypeObject* type;
+    void* (*getImpl)(PyObject* self);
+    Object* (*asObject)(void* impl);
+    QWidget* (*asQWidget)(void* impl);  // возвращает NULL, если класс не является виджетом
+    void* (*fromObject)(Object* object);
+    PyObject* (*wrap)(void* impl);      // обертка над существующим объектом (новая ссылка)
+    const char* typeName;               // ClassName::TypeName
+    PyObject* className;                // интернированная строка с ClassName::TypeName
+    bool isWidget;
+};
+
+// Состояние модуля. У каждого интерпретатора свой экземпляр модуля, а с ним свои типы,
+//  списки свободных оберток и объекты Python в кэшах. Заполняется в PyWidgets_ExecModule
+struct PyWidgetsModuleState {
+    PyTypeObject* objectType;
+    PyTypeObject* commandBufferType;
+    PyTypeObject* templateType;
+    PyTypeObject* eventLoopSelectorType;
+    PyTypeObject* taskType;
+    PyTypeObject* timerType;
+    PyWidgetsTypeInfo types[PyWidgetsTag_Count];
+    // Освобожденные обертки точного типа копятся здесь и переиспользуются без аллокатора
+    PyObject* freeList[PyWidgetsTag_Count][PY_WIDGETS_FREELIST_SIZE];
+    int freeCount[PyWidgetsTag_Count];
+    PyWidgetsStringCacheEntry* stringCache;  // PY_WIDGETS_STRING_CACHE_SIZE записей
+    PyWidgetsStateNames stateNames;
+    PyObject* asyncio;
+    PyObject* tasks;                         // см. PyWidgets_StartTask
+    PyObject* selectorKeyType;               // selectors.SelectorKey
+};
+
+// Растет, когда модуль создается или удаляется в каком-либо интерпретаторе, и тем
+//  сбрасывает кэши PyWidgets_FindState во всех потоках
+static std::atomic<uint64_t> PyWidgets_StateGeneration(1);
+
+struct PyWidgetsStateCache {
+    int64_t interpreterId;  // номера интерпретаторов, в отличие от адресов, не переиспользуются
+    uint64_t generation;
+    PyWidgetsModuleState* state;
+};
+
+static thread_local PyWidgetsStateCache PyWidgets_StateCache = {-1, 0, NULL};
+
+// Состояние модуля в интерпретаторе текущего потока или NULL, если модуль в нем не загружен.
+//  Поиск в словаре интерпретатора дорог для каждого вызова, поэтому результат кэшируется в потоке
+static PyWidgetsModuleState* PyWidgets_FindState() {
+    PyInterpreterState* interpreter = PyInterpreterState_Get();
+    int64_t interpreterId = PyInterpreterState_GetID(interpreter);
+    uint64_t generation = PyWidgets_StateGeneration.load(std::memory_order_acquire);
+    PyWidgetsStateCache& cache = PyWidgets_StateCache;
+    if (cache.interpreterId != interpreterId || cache.generation != generation) {
+        PyObject* dict = PyInterpreterState_GetDict(interpreter);
+        PyObject* module = (dict != NULL) ? PyDict_GetItemString(dict, PY_WIDGETS_MODULE_NAME) : NULL;
+        cache.interpreterId = interpreterId;
+        cache.generation = generation;
+        cache.state = (module != NULL) ? (PyWidgetsModuleState*)PyModule_GetState(module) : NULL;
+    }
+    return cache.state;
+}
+
+static PyWidgetsModuleState* PyWidgets_GetState() {
+    PyWidgetsModuleState* state = PyWidgets_FindState();
+    if (state == NULL) {
+        PyErr_SetString(PyExc_RuntimeError, PY_WIDGETS_MODULE_NAME " is not imported in this interpreter");
+    }
+    return state;
+}
+
+// Функциям модуля состояние передается с самим модулем
+static inline PyWidgetsModuleState* PyWidgets_GetModuleState(PyObject* module) {
+    return (PyWidgetsModuleState*)PyModule_GetState(module);
+}
+
+// Записи кэша меняются при каждом промахе без блокировки, поэтому без GIL он не используется
+static PyWidgetsStringCacheEntry* PyWidgets_GetStringCache() {
+    PyWidgetsModuleState* state = PY_WIDGETS_FREE_THREADED ? NULL : PyWidgets_FindState();
+    return (state != NULL) ? state->stringCache : NULL;
+}
+
+static PyWidgetsStateNames* PyWidgets_GetStateNamesStorage() {
+    PyWidgetsModuleState* state = PyWidgets_GetState();
+    return (state != NULL) ? &state->stateNames : NULL;
+}
+
+// Объекты Qt живут в GUI-потоке основного интерпретатора: обработчики Qt берут GIL через
+//  PyGILState, который знает только его. Другие интерпретаторы меняют виджеты по handle
+//  через post_set_* (см. Object.handle)
+static int PyWidgets_CheckMainInterpreter(const char* name) {
+    if (PyInterpreterState_Get() != PyInterpreterState_Main()) {
+        PyErr_Format(PyExc_RuntimeError, "%s objects can only be created in the main interpreter", name);
+        return 0;
+    }
+    return 1;
+}
+
+// Новая ссылка на обертку, привязанную к объекту, или NULL без исключения. Без GIL обертку
+//  может в это время освобождать другой поток: тогда она уже не в счет, и объект получит новую
+static PyObject* PyWidgets_GetBoundWrapper(Object* object) {
+    PyWidgets_LockBindings();
+    PyObject* existing = (PyObject*)Object_GetBinding(object);
+    if (existing != NULL && !PyWidgets_TryIncRef(existing)) {
+        existing = NULL;
+    }
+    PyWidgets_UnlockBindings();
+    return existing;
+}
+
+// Обертка над объектом библиотеки, пришедшим из кода Qt (новая ссылка; None для NULL).
+//  Если у объекта уже есть обертка, возвращается она, иначе создается обертка его класса
+static PyObject* PyWidgets_FromObject(Object* object) {
+    if (object == NULL) {
+        Py_RETURN_NONE;
+    }
+    PyObject* existing = PyWidgets_GetBoundWrapper(object);
+    if (existing != NULL) {
+        return existing;
+    }
+    PyWidgetsModuleState* state = PyWidgets_GetState();
+    if (state == NULL) {
+        return NULL;
+    }
+    const char* typeName = Object_GetClassName(object);
+    for (int tag = PyWidgetsTag_Unknown + 1; tag < PyWidgetsTag_Count; ++tag) {
+        if (strcmp(state->types[tag].typeName, typeName) == 0) {
+            return state->types[tag].wrap(state->types[tag].fromObject(object));
+        }
+    }
+    PyErr_Format(PyExc_TypeError, "no wrapper type for %.200s", typeName);
+    return NULL;
+}
+
+static inline QWidget* PyWidgets_AsQWidget(QWidget* widget) {
+    return widget;
+}
+
+static inline QWidget* PyWidgets_AsQWidget(...) {
+    return NULL;
+}
+
+static PyObject* PyWidgetsObject_GetClassName(PyWidgetsObject* self);
+static PyObject* PyWidgetsObject_Connect(PyObject* self, PyObject* const* args, Py_ssize_t nargs);
+static PyObject* PyWidgetsObject_GetParent(PyObject* self);
+static PyObject* PyWidgetsObject_GetChildren(PyObject* self);
+static PyObject* PyWidgetsObject_GetHandle(PyObject* self);
+
+static PyMethodDef PyWidgetsObject_methods[] = {
+    {"get_class_name", (PyCFunction)PyWidgetsObject_GetClassName, METH_NOARGS, "Returns class name"},
+    {"parent", PY_GUI_METHOD(PyWidgetsObject_GetParent), METH_NOARGS, "Returns parent object or None"},
+    {"children", PY_GUI_METHOD(PyWidgetsObject_GetChildren), METH_NOARGS, "Returns list of child objects"},
+    {"connect", PY_GUI_METHOD(PyWidgetsObject_Connect), METH_FASTCALL,
+        "Connects callable to the signal given by name or signature; callable gets signal arguments"},
+    {"handle", PY_GUI_METHOD(PyWidgetsObject_GetHandle), METH_NOARGS,
+        "Returns int that post_set_* accept instead of the object, also in other interpreters;"
+        " updates by the handle are dropped once the object is deleted"},
+    {NULL}
+};
+
+static PyMemberDef PyWidgetsObject_members[] = {
+    {"__weaklistoffset__", T_PYSSIZET, offsetof(PyWidgetsObject, weakreflist), READONLY, NULL},
+    {NULL}
+};
+
+static PyType_Slot PyWidgetsObject_slots[] = {
+    {Py_tp_doc, (void*)"Base class of all widget objects"},
+    {Py_tp_methods, (void*)PyWidgetsObject_methods},
+    {Py_tp_members, (void*)PyWidgetsObject_members},
+    {0, NULL}
+};
+
+// Абстрактный базовый тип pywidgets.Object: одна проверка PyObject_TypeCheck
+//  отличает любую обертку от чужих объектов, после чего тип определяется по тегу
+static PyType_Spec Py_SpecObject = {
+    "pywidgets.Object",
+    sizeof(PyWidgetsObject),
+    0,
+    Py_TPFLAGS_DEFAULT | Py_TPFLAGS_BASETYPE | PY_WIDGETS_TPFLAGS_IMMUTABLE | PY_WIDGETS_TPFLAGS_NO_NEW,
+    PyWidgetsObject_slots
+};
+
+// Если модуль не загружен в этом интерпретаторе, его оберток здесь тоже нет
+static inline const PyWidgetsTypeInfo* PyWidgets_GetTypeInfo(PyObject* obj) {
+    PyWidgetsModuleState* state = PyWidgets_FindState();
+    if (state == NULL || !PyObject_TypeCheck(obj, state->objectType)) {
+        return NULL;
+    }
+    return &state->types[((PyWidgetsObject*)obj)->tag];
+}
+
+// Имя класса не зависит от экземпляра, поэтому возвращаем общую для типа строку,
+//  не обращаясь к pImpl и ничего не выделяя
+static PyObject* PyWidgetsObject_GetClassName(PyWidgetsObject* self) {
+    PyWidgetsModuleState* state = PyWidgets_GetState();
+    if (state == NULL) {
+        return NULL;
+    }
+    PyObject* className = state->types[self->tag].className;
+    Py_INCREF(className);
+    return className;
+}
+
+static int PyWidgets_ToObject(PyObject* obj, Object** result) {
+    const PyWidgetsTypeInfo* info = PyWidgets_GetTypeInfo(obj);
+    if (info == NULL || info->asObject == NULL) {
+        PyErr_Format(PyExc_TypeError, "expected pywidgets.Object, got %.200s", Py_TYPE(obj)->tp_name);
+        return 0;
+    }
+    void* impl = info->getImpl(obj);
+    if (!PyWidgets_CheckAlive(impl)) {
+        return 0;
+    }
+    *result = info->asObject(impl);
+    return 1;
+}
+
+static int PyWidgets_ToQWidget(PyObject* obj, QWidget** result) {
+    const PyWidgetsTypeInfo* info = PyWidgets_GetTypeInfo(obj);
+    if (info == NULL || !info->isWidget) {
+        PyErr_Format(PyExc_TypeError, "expected widget, got %.200s", Py_TYPE(obj)->tp_name);
+        return 0;
+    }
+    void* impl = info->getImpl(obj);
+    if (!PyWidgets_CheckAlive(impl)) {
+        return 0;
+    }
+    *result = info->asQWidget(impl);
+    return 1;
+}
+
+// Список оберток в порядке objects
+static PyObject* PyWidgets_FromObjects(const std::vector<Object*>& objects) {
+    PyObject* list = PyList_New(objects.size());
+    if (list == NULL) {
+        return NULL;
+    }
+    for (size_t i = 0; i < objects.size(); ++i) {
+        PyObject* item = PyWidgets_FromObject(objects[i]);
+        if (item == NULL) {
+            Py_DECREF(list);
+            return NULL;
+        }
+        PyList_SET_ITEM(list, i, item);
+    }
+    return list;
+}
+
+// Для объектов, у которых уже есть обертки, возвращаются они же
+static PyObject* PyWidgetsObject_GetParent(PyObject* self) {
+    Object* object = NULL;
+    if (!PyWidgets_ToObject(self, &object)) {
+        return NULL;
+    }
+    return PyWidgets_FromObject(Object_GetParent(object));
+}
+
+static PyObject* PyWidgetsObject_GetChildren(PyObject* self) {
+    Object* object = NULL;
+    if (!PyWidgets_ToObject(self, &object)) {
+        return NULL;
+    }
+    return PyWidgets_FromObjects(Object_GetChildren(object));
+}
+
+static PyObject* PyWidgetsObject_GetHandle(PyObject* self) {
+    Object* object = NULL;
+    if (!PyWidgets_ToObject(self, &object)) {
+        return NULL;
+    }
+    return PyLong_FromUnsignedLongLong(Object_GetHandle(object));
+}
+
+static void PyWidgets_FinishCallback(PyObject* result);
+
+// Запускает awaitable, который вернул обработчик-корутинная функция, задачей в работающем
+//  в этом потоке цикле asyncio (см. Application.new_event_loop). Цикл хранит задачи по слабым
+//  ссылкам, поэтому до завершения их держит множество
+static void PyWidgets_StartTask(PyObject* awaitable) {
+    PyWidgetsModuleState* state = PyWidgets_GetState();
+    if (state == NULL ||
+        (state->asyncio == NULL && (state->asyncio = PyImport_ImportModule("asyncio")) == NULL) ||
+        (state->tasks == NULL && (state->tasks = PySet_New(NULL)) == NULL))
+    {
+        PyErr_Print();
+        return;
+    }
+    PyObject* asyncio = state->asyncio;
+    PyObject* tasks = state->tasks;
+    PyObject* loop = PyObject_CallMethod(asyncio, "get_running_loop", NULL);
+    if (loop == NULL) {
+        PyErr_Clear();
+        PyErr_SetString(PyExc_RuntimeError,
+            "coroutine handler requires a running asyncio loop, see Application.new_event_loop()");
+        PyErr_Print();
+        // Иначе при сборке корутины еще и предупреждение "was never awaited"
+        if (PyCoro_CheckExact(awaitable)) {
+            PyWidgets_FinishCallback(PyObject_CallMethod(awaitable, "close", NULL));
+        }
+        return;
+    }
+    PyObject* task = PyObject_CallMethod(asyncio, "ensure_future", "O", awaitable);
+    PyObject* discard = (task != NULL) ? PyObject_GetAttrString(tasks, "discard") : NULL;
+    if (discard == NULL || PySet_Add(tasks, task) < 0) {
+        PyErr_Print();
+    } else {
+        PyWidgets_FinishCallback(PyObject_CallMethod(task, "add_done_callback", "O", discard));
+    }
+    Py_XDECREF(discard);
+    Py_XDECREF(task);
+    Py_DECREF(loop);
+}
+
+// Результат Python-обработчика, вызванного из кода Qt. Пробросить исключение некуда,
+//  поэтому оно печатается; awaitable запускается задачей asyncio, так что обработчиком
+//  может быть и корутинная функция. Вызывающий должен держать GIL: цикл событий работает
+//  без него, см. PyApplication_Exec
+static void PyWidgets_FinishCallback(PyObject* result) {
+    if (result == NULL) {
+        PyErr_Print();
+    } else {
+        PyTypeObject* type = Py_TYPE(result);
+        if (PyCoro_CheckExact(result) || (type->tp_as_async != NULL && type->tp_as_async->am_await != NULL)) {
+            PyWidgets_StartTask(result);
+        }
+        Py_DECREF(result);
+    }
+    // Обработчик мог поставить работу в цикл asyncio, который сейчас ждет в select()
+    EventPoller_InterruptWait();
+}
+
+static void PyWidgets_CallCallback(PyObject* callable, PyObject* args) {
+    PyWidgets_FinishCallback(PyObject_CallObject(callable, args));
+}
+
+// Сигнал ищется и план преобразования аргументов строится один раз при подключении
+static PyObject* PyWidgetsObject_Connect(PyObject* self, PyObject* const* args, Py_ssize_t nargs) {
+    Object* object = NULL;
+    const char* name;
+    if (!PyWidgets_CheckArgsCount("connect", nargs, 2) || !PyWidgets_ToObject(self, &object) ||
+        !PyWidgets_ToString(args[0], &name))
+    {
+        return NULL;
+    }
+    PyObject* callable = args[1];
+    if (!PyCallable_Check(callable)) {
+        PyErr_SetString(PyExc_TypeError, "connect() argument 2 must be callable");
+        return NULL;
+    }
+    const SignalSignature* signal = Object_FindSignal(object, name);
+    if (signal == NULL) {
+        PyErr_Format(PyExc_ValueError, "%.200s has no signal '%.200s'", Py_TYPE(self)->tp_name, name);
+        return NULL;
+    }
+    const PyWidgetsSignalPlan* plan = PyWidgets_GetSignalPlan(signal);
+
+    PyWidgetsObject* owner = (PyWidgetsObject*)self;
+    std::shared_ptr<PyObject> ownerRef = PyWidgets_NewOwnerRef(owner);
+    Py_ssize_t index = (ownerRef != nullptr) ? PyWidgets_AddCallback(owner, callable) : -1;
+    if (index < 0) {
+        return NULL;
+    }
+    bool isConnected = Object_Connect(object, signal, [plan, ownerRef, index](Object*, void** values) {
+        PyGILState_STATE gil = PyGILState_Ensure();
+        PyObject* owner;
+        PyObject* callable;
+        if (PyWidgets_LookupCallback(ownerRef.get(), index, &owner, &callable)) {
+            PyObject* callbackArgs = PyWidgets_MarshalSignal(plan, values);
+            if (callbackArgs == NULL) {
+                PyErr_Print();
+            } else {
+                PyWidgets_CallCallback(callable, callbackArgs);
+                Py_DECREF(callbackArgs);
+            }
+            Py_DECREF(callable);
+            Py_DECREF(owner);
+        }
+        PyGILState_Release(gil);
+    });
+    if (!isConnected) {
+        Py_INCREF(Py_None);
+        PyList_SetItem(owner->callbacks, index, Py_None);
+        PyErr_Format(PyExc_RuntimeError, "failed to connect to '%.200s'", name);
+        return NULL;
+    }
+    Py_RETURN_NONE;
+}
+
+//----------------------------------------------------------------------------------------
+
 struct PyApplication;
 
-static PyObject* PyApplication_GetClassName(PyApplication* self);
 static PyObject* PyApplication_Exec(PyApplication* self);
+static PyObject* PyApplication_Post(PyApplication* self, PyObject* const* args, Py_ssize_t nargs);
+static PyObject* PyApplication_PostSetText(PyApplication* self, PyObject* const* args, Py_ssize_t nargs);
+static PyObject* PyApplication_PostSetWindowTitle(PyApplication* self, PyObject* const* args, Py_ssize_t nargs);
+static PyObject* PyApplication_PostSetSize(PyApplication* self, PyObject* const* args, Py_ssize_t nargs);
+static PyObject* PyApplication_PostSetVisible(PyApplication* self, PyObject* const* args, Py_ssize_t nargs);
+static PyObject* PyApplication_FlushUpdates(PyApplication* self);
+static PyObject* PyApplication_UpdateStats(PyApplication* self);
+static PyObject* PyApplication_NewEventLoop(PyApplication* self);
+// Определены в PyWidgetsTasks.h вместе с типом Task
+static PyObject* PyApplication_Submit(PyApplication* self, PyObject* const* args, Py_ssize_t nargs, PyObject* kwnames);
+static PyObject* PyApplication_TaskStats(PyApplication* self);
+// Определены в PyWidgetsTimers.h вместе с типом Timer
+static PyObject* PyApplication_SetInterval(PyApplication* self, PyObject* const* args, Py_ssize_t nargs);
+static PyObject* PyApplication_SetTimeout(PyApplication* self, PyObject* const* args, Py_ssize_t nargs);
+static PyObject* PyApplication_RequestFrame(PyApplication* self, PyObject* const* args, Py_ssize_t nargs);
+static PyObject* PyApplication_SchedulerStats(PyApplication* self);
 
 static PyMethodDef PyApplication_methods[] = {
-    {"get_class_name", (PyCFunction)PyApplication_GetClassName, METH_NOARGS, "Return class name"},
     {"exec", (PyCFunction)PyApplication_Exec, METH_NOARGS, "Runs application"},
+    {"post", (PyCFunction)PyApplication_Post, METH_FASTCALL,
+        "Calls callable in the GUI thread; safe to call from any thread"},
+    {"post_set_text", (PyCFunction)PyApplication_PostSetText, METH_FASTCALL,
+        "Sets texts from (Label, PushButton or handle, str) pairs in the GUI thread; safe to call from any thread"},
+    {"post_set_window_title", (PyCFunction)PyApplication_PostSetWindowTitle, METH_FASTCALL,
+        "Sets titles from (Widget or handle, str) pairs in the GUI thread; safe to call from any thread"},
+    {"post_set_size", (PyCFunction)PyApplication_PostSetSize, METH_FASTCALL,
+        "Sets sizes from (Widget or handle, width, height) tuples in the GUI thread; safe to call from any thread"},
+    {"post_set_visible", (PyCFunction)PyApplication_PostSetVisible, METH_FASTCALL,
+        "Sets visibility from (Widget or handle, bool) pairs in the GUI thread; safe to call from any thread"},
+    {"flush_updates", PY_GUI_METHOD(PyApplication_FlushUpdates), METH_NOARGS,
+        "Applies queued property updates now instead of on the next event loop turn"},
+    {"update_stats", (PyCFunction)PyApplication_UpdateStats, METH_NOARGS,
+        "Returns dict with numbers of posted, coalesced, cancelled, unchanged, applied and dropped property updates"},
+    {"new_event_loop", PY_GUI_METHOD(PyApplication_NewEventLoop), METH_NOARGS,
+        "Returns an asyncio event loop that runs inside the Qt event loop, so the GUI stays live while it waits"},
+    {"submit", (PyCFunction)(void(*)(void))PyApplication_Submit, METH_FASTCALL | METH_KEYWORDS,
+        "submit(fn, *args, on_done=None) runs fn in the thread pool and returns Task; on_done(task) is called"
+        " in the GUI thread. Safe to call from any thread"},
+    {"task_stats", (PyCFunction)PyApplication_TaskStats, METH_NOARGS,
+        "Returns dict with task pool counters, queue depth and wait, run and delivery latencies"},
+    {"set_interval", PY_GUI_METHOD(PyApplication_SetInterval), METH_FASTCALL,
+        "set_interval(ms, callback, widget=None) calls callback() every ms milliseconds, aligned to display"
+        " frames and throttled while the window of widget (or every window) is hidden; returns Timer"},
+    {"set_timeout", PY_GUI_METHOD(PyApplication_SetTimeout), METH_FASTCALL,
+        "set_timeout(ms, callback, widget=None) calls callback() once after ms milliseconds; returns Timer"},
+    {"request_frame", PY_GUI_METHOD(PyApplication_RequestFrame), METH_FASTCALL,
+        "request_frame(callback, widget=None) calls callback(frame_time) once on the next display frame;"
+        " frame_time is in time.monotonic() seconds. Returns Timer"},
+    {"scheduler_stats", PY_GUI_METHOD(PyApplication_SchedulerStats), METH_NOARGS,
+        "Returns dict with numbers of ticks, fires, coalesced, throttled and overrun timer callbacks"},
     {NULL}
 };
-static PyObject* PyApplication_new(PyTypeObject* type, PyObject* args, PyObject* kwds);
+static PyObject* PyApplication_Create(PyTypeObject* type, PyObject* const* args, Py_ssize_t nargs);
 
-PY_CLASS_WRAPPER(Application, PyApplication_methods, PyApplication_new)
+PY_CLASS_WRAPPER(Application, PyApplication_methods, PyApplication_Create)
 
-static PyObject* PyApplication_new(PyTypeObject* type, PyObject* args, PyObject* kwds) {
-    PyApplication* self = (PyApplication*)type->tp_alloc(type, 0);
+static PyObject* PyApplication_Create(PyTypeObject* type, PyObject* const* args, Py_ssize_t nargs) {
+    if (!PyWidgets_CheckArgsCount("Application", nargs, 0)) {
+        return NULL;
+    }
+    PyApplication* self = Py_AllocApplication(type);
     if (self != NULL) {
-        self->pImpl = Application_New();
+        Py_BindApplication(self, Application_New());
     }
 
     return (PyObject*)self;
 }
 
-static PyObject* PyApplication_GetClassName(PyApplication* self) {
-    return PyUnicode_FromFormat("%s", Object_GetClassName((Object*) self->pImpl));
+// Цикл событий работает без GIL, чтобы Python-потоки могли выполняться параллельно;
+//  обработчики берут GIL сами
+static PyObject* PyApplication_Exec(PyApplication* self) {
+    if (!PyWidgets_CheckAlive(self->pImpl)) {
+        return NULL;
+    }
+    int status = 0;
+    Py_BEGIN_ALLOW_THREADS
+    status = Application_Exec(self->pImpl);
+    Py_END_ALLOW_THREADS
+    return PyLong_FromLong(status);
+}
+
+static PyObject* PyApplication_Post(PyApplication* self, PyObject* const* args, Py_ssize_t nargs) {
+    if (!PyWidgets_CheckAlive(self->pImpl) ||
+        !PyWidgets_CheckArgsCount("post", nargs, 1))
+    {
+        return NULL;
+    }
+    PyObject* callable = args[0];
+    if (!PyCallable_Check(callable)) {
+        PyErr_SetString(PyExc_TypeError, "post() argument must be callable");
+        return NULL;
+    }
+    std::shared_ptr<PyObject> holder = PyWidgets_HoldRef(callable);
+    Application_Post(self->pImpl, [holder]() {
+        PyGILState_STATE gil = PyGILState_Ensure();
+        PyWidgets_CallCallback(holder.get(), NULL);
+        PyGILState_Release(gil);
+    });
+    Py_RETURN_NONE;
 }
 
-static PyObject* PyApplication_Exec(PyApplication* self) {
-    return PyLong_FromLong(Application_Exec(self->pImpl));
+// Определена в PyWidgetsEventLoop.h вместе с селектором
+static PyObject* PyWidgets_NewEventLoop(PyObject* app);
+
+static PyObject* PyApplication_NewEventLoop(PyApplication* self) {
+    if (!PyWidgets_CheckAlive(self->pImpl)) {
+        return NULL;
+    }
+    return PyWidgets_NewEventLoop((PyObject*)self);
 }
 
 //----------------------------------------------------------------------------------------
 
 struct PyWidget;
 
-static PyObject* PyWidget_new(PyTypeObject* type, PyObject* args, PyObject* kwds);
-static PyObject* PyWidget_GetClassName(PyWidget* self);
-static PyObject* PyWidget_SetWindowTitle(PyWidget* self, PyObject* args);
-static PyObject* PyWidget_SetSize(PyWidget* self, PyObject* args);
-static PyObject* PyWidget_Visible(PyWidget* self, PyObject* args);
-static PyObject* PyWidget_SetLayout(PyWidget* self, PyObject* args);
+static PyObject* PyWidget_Create(PyTypeObject* type, PyObject* const* args, Py_ssize_t nargs);
+static PyObject* PyWidget_SetWindowTitle(PyWidget* self, PyObject* const* args, Py_ssize_t nargs);
+static PyObject* PyWidget_SetSize(PyWidget* self, PyObject* const* args, Py_ssize_t nargs);
+static PyObject* PyWidget_Visible(PyWidget* self, PyObject* const* args, Py_ssize_t nargs);
+static PyObject* PyWidget_SetLayout(PyWidget* self, PyObject* const* args, Py_ssize_t nargs);
+static PyObject* PyWidget_ApplyState(PyWidget* self, PyObject* const* args, Py_ssize_t nargs);
 
 static PyMethodDef PyWidget_methods[] = {
-    {"get_class_name", (PyCFunction)PyWidget_GetClassName, METH_NOARGS, "Returns class name"},
-    {"set_window_title", (PyCFunction)PyWidget_SetWindowTitle, METH_VARARGS, "Sets window title"},
-    {"set_size", (PyCFunction)PyWidget_SetSize, METH_VARARGS, "Sets window width and height"},
-    {"set_visible", (PyCFunction)PyWidget_Visible, METH_VARARGS, "Sets window visibility"},
-    {"set_layout", (PyCFunction)PyWidget_SetLayout, METH_VARARGS, "Sets layout"},
+    {"set_window_title", PY_GUI_METHOD(PyWidget_SetWindowTitle), METH_FASTCALL, "Sets window title"},
+    {"set_size", PY_GUI_METHOD(PyWidget_SetSize), METH_FASTCALL, "Sets window width and height"},
+    {"set_visible", PY_GUI_METHOD(PyWidget_Visible), METH_FASTCALL, "Sets window visibility"},
+    {"set_layout", PY_GUI_METHOD(PyWidget_SetLayout), METH_FASTCALL, "Sets layout"},
+    {"apply_state", PY_GUI_METHOD(PyWidget_ApplyState), METH_FASTCALL,
+        "Brings the widget and its children to a declarative state tree, touching only what changed"
+        " since the previous call; returns counts of created, removed, moved and updated items"},
     {NULL}
 };
 
-PY_CLASS_WRAPPER(Widget, PyWidget_methods, PyWidget_new)
+PY_CLASS_WRAPPER(Widget, PyWidget_methods, PyWidget_Create)
 
-static PyObject* PyWidget_new(PyTypeObject* type, PyObject* args, PyObject* kwds) {
-    PyWidget* self = (PyWidget*)type->tp_alloc(type, 0);
+static PyObject* PyWidget_Create(PyTypeObject* type, PyObject* const* args, Py_ssize_t nargs) {
+    if (!PyWidgets_CheckArgsCount("Widget", nargs, 0)) {
+        return NULL;
+    }
+    PyWidget* self = Py_AllocWidget(type);
     if (self != NULL) {
-        self->pImpl = Widget_New(NULL);
+        Py_BindWidget(self, Widget_New(NULL));
     }
 
     return (PyObject*)self;
 }
 
-static PyObject* PyWidget_GetClassName(PyWidget* self) {
-    return PyUnicode_FromFormat("%s", Object_GetClassName((Object*) self->pImpl));
-}
-
-static PyObject* PyWidget_SetWindowTitle(PyWidget* self, PyObject* args) {
-    const char* title;
-    if (!PyArg_ParseTuple(args, "s", &title)) {
+static PyObject* PyWidget_SetWindowTitle(PyWidget* self, PyObject* const* args, Py_ssize_t nargs) {
+    QString title;
+    if (!PyWidgets_CheckAlive(self->pImpl) ||
+        !PyWidgets_CheckArgsCount("set_window_title", nargs, 1) ||
+        !PyWidgets_ToQString(args[0], &title))
+    {
         return NULL;
     }
     Widget_SetWindowTitle(self->pImpl, title);
     Py_RETURN_NONE;
 }
 
-static PyObject* PyWidget_SetSize(PyWidget* self, PyObject* args) {
+static PyObject* PyWidget_SetSize(PyWidget* self, PyObject* const* args, Py_ssize_t nargs) {
     int width = 0, height = 0;
-    if (!PyArg_ParseTuple(args, "ii", &width, &height)) {
+    if (!PyWidgets_CheckAlive(self->pImpl) ||
+        !PyWidgets_CheckArgsCount("set_size", nargs, 2) ||
+        !PyWidgets_ToInt(args[0], &width) || !PyWidgets_ToInt(args[1], &height))
+    {
         return NULL;
     }
     Widget_SetSize(self->pImpl, width, height);
     Py_RETURN_NONE;
 }
 
-static PyObject* PyWidget_Visible(PyWidget* self, PyObject* args) {
-    PyObject* isVisible = NULL;
-    if (!PyArg_ParseTuple(args, "O", &isVisible)) {
+static PyObject* PyWidget_Visible(PyWidget* self, PyObject* const* args, Py_ssize_t nargs) {
+    bool isVisible = false;
+    if (!PyWidgets_CheckAlive(self->pImpl) ||
+        !PyWidgets_CheckArgsCount("set_visible", nargs, 1) ||
+        !PyWidgets_ToBool(args[0], &isVisible))
+    {
         return NULL;
     }
-    Widget_SetVisible(self->pImpl, PyObject_IsTrue(isVisible));
+    Widget_SetVisible(self->pImpl, isVisible);
     Py_RETURN_NONE;
 }
 
@@ -106,87 +748,83 @@ static PyObject* PyWidget_Visible(PyWidget* self, PyObject* args) {
 
 struct PyVBoxLayout;
 
-static PyObject* PyVBoxLayout_new(PyTypeObject* type, PyObject* args, PyObject* kwds);
-static PyObject* PyVBoxLayout_GetClassName(PyVBoxLayout* self);
-static PyObject* PyVBoxLayout_AddWidget(PyVBoxLayout* self, PyObject* args);
+static PyObject* PyVBoxLayout_Create(PyTypeObject* type, PyObject* const* args, Py_ssize_t nargs);
+static PyObject* PyVBoxLayout_AddWidget(PyVBoxLayout* self, PyObject* const* args, Py_ssize_t nargs);
 
 static PyMethodDef PyVBoxLayout_methods[] = {
-    {"get_class_name", (PyCFunction)PyVBoxLayout_GetClassName, METH_NOARGS, "Returns class name"},
-    {"add_widget", (PyCFunction)PyVBoxLayout_AddWidget, METH_VARARGS, "Adds widget"},
+    {"add_widget", PY_GUI_METHOD(PyVBoxLayout_AddWidget), METH_FASTCALL, "Adds widget"},
     {NULL}
 };
 
-PY_CLASS_WRAPPER(VBoxLayout, PyVBoxLayout_methods, PyVBoxLayout_new)
-
-static PyObject* PyVBoxLayout_new(PyTypeObject* type, PyObject* args, PyObject* kwds) {
-    PyVBoxLayout* self = (PyVBoxLayout*)type->tp_alloc(type, 0);
+PY_CLASS_WRAPPER(VBoxLayout, PyVBoxLayout_methods, PyVBoxLayout_Create)
 
+static PyObject* PyVBoxLayout_Create(PyTypeObject* type, PyObject* const* args, Py_ssize_t nargs) {
     PyWidget* parent = NULL;
-    if (!PyArg_ParseTuple(args, "O", &parent)) {
+    if (!PyWidgets_CheckArgsCount("VBoxLayout", nargs, 1) || !Py_ConvertWidget(args[0], &parent)) {
         return NULL;
     }
-    Py_INCREF(parent);
+
+    PyVBoxLayout* self = Py_AllocVBoxLayout(type);
     if (self != NULL) {
-        self->pImpl = VBoxLayout_New(parent->pImpl);
+        Py_BindVBoxLayout(self, VBoxLayout_New(parent->pImpl));
     }
 
     return (PyObject*)self;
 }
 
-static PyObject* PyVBoxLayout_GetClassName(PyVBoxLayout* self) {
-    return PyUnicode_FromFormat("%s", Object_GetClassName((Object*) self->pImpl));
-}
-
 //----------------------------------------------------------------------------------------
 
-static PyObject* PyWidget_SetLayout(PyWidget* self, PyObject* args) {
+static PyObject* PyWidget_SetLayout(PyWidget* self, PyObject* const* args, Py_ssize_t nargs) {
     PyVBoxLayout* layout = NULL;
-    if (!PyArg_ParseTuple(args, "O", &layout)) {
+    if (!PyWidgets_CheckAlive(self->pImpl) ||
+        !PyWidgets_CheckArgsCount("set_layout", nargs, 1) || !Py_ConvertVBoxLayout(args[0], &layout))
+    {
         return NULL;
     }
-    Py_INCREF(layout);
-    Widget_SetLayout(self->pImpl, (Layout*) layout->pImpl);
+    Widget_SetLayout(self->pImpl, layout->pImpl);
     Py_RETURN_NONE;
 }
 
+static PyObject* PyWidget_ApplyState(PyWidget* self, PyObject* const* args, Py_ssize_t nargs) {
+    if (!PyWidgets_CheckAlive(self->pImpl) || !PyWidgets_CheckArgsCount("apply_state", nargs, 1)) {
+        return NULL;
+    }
+    return PyWidgets_ApplyState("apply_state", self->pImpl, args[0]);
+}
+
 //----------------------------------------------------------------------------------------
 
 struct PyLabel;
 
-static PyObject* PyLabel_new(PyTypeObject* type, PyObject* args, PyObject* kwds);
-static PyObject* PyLabel_GetClassName(PyLabel* self);
-static PyObject* PyLabel_SetText(PyLabel* self, PyObject* args);
+static PyObject* PyLabel_Create(PyTypeObject* type, PyObject* const* args, Py_ssize_t nargs);
+static PyObject* PyLabel_SetText(PyLabel* self, PyObject* const* args, Py_ssize_t nargs);
 
 static PyMethodDef PyLabel_methods[] = {
-    {"get_class_name", (PyCFunction)PyLabel_GetClassName, METH_NOARGS, "Returns class name"},
-    {"set_text", (PyCFunction)PyLabel_SetText, METH_VARARGS, "Sets text"},
+    {"set_text", PY_GUI_METHOD(PyLabel_SetText), METH_FASTCALL, "Sets text"},
     {NULL}
 };
 
-PY_CLASS_WRAPPER(Label, PyLabel_methods, PyLabel_new)
-
-static PyObject* PyLabel_new(PyTypeObject* type, PyObject* args, PyObject* kwds) {
-    PyLabel* self = (PyLabel*)type->tp_alloc(type, 0);
+PY_CLASS_WRAPPER(Label, PyLabel_methods, PyLabel_Create)
 
+static PyObject* PyLabel_Create(PyTypeObject* type, PyObject* const* args, Py_ssize_t nargs) {
     PyWidget* parent = NULL;
-    if (!PyArg_ParseTuple(args, "O", &parent)) {
+    if (!PyWidgets_CheckArgsCount("Label", nargs, 1) || !Py_ConvertWidget(args[0], &parent)) {
         return NULL;
     }
-    Py_INCREF(parent);
+
+    PyLabel* self = Py_AllocLabel(type);
     if (self != NULL) {
-        self->pImpl = Label_New(parent->pImpl);
+        Py_BindLabel(self, Label_New(parent->pImpl));
     }
 
     return (PyObject*)self;
 }
 
-static PyObject* PyLabel_GetClassName(PyLabel* self) {
-    return PyUnicode_FromFormat("%s", Object_GetClassName((Object*) self->pImpl));
-}
-
-static PyObject* PyLabel_SetText(PyLabel* self, PyObject* args) {
-    const char* text;
-    if (!PyArg_ParseTuple(args, "s", &text)) {
+static PyObject* PyLabel_SetText(PyLabel* self, PyObject* const* args, Py_ssize_t nargs) {
+    QString text;
+    if (!PyWidgets_CheckAlive(self->pImpl) ||
+        !PyWidgets_CheckArgsCount("set_text", nargs, 1) || !PyWidgets_ToQString(args[0], &text))
+    {
         return NULL;
     }
     Label_SetText(self->pImpl, text);
@@ -197,78 +835,973 @@ static PyObject* PyLabel_SetText(PyLabel* self, PyObject* args) {
 
 struct PyPushButton;
 
-static PyObject* PyPushButton_new(PyTypeObject* type, PyObject* args, PyObject* kwds);
-static PyObject* PyPushButton_GetClassName(PyPushButton* self);
-static PyObject* PyPushButton_SetText(PyPushButton* self, PyObject* args);
-static PyObject* PyPushButton_SetOnClicked(PyPushButton* self, PyObject* args);
+static PyObject* PyPushButton_Create(PyTypeObject* type, PyObject* const* args, Py_ssize_t nargs);
+static PyObject* PyPushButton_SetText(PyPushButton* self, PyObject* const* args, Py_ssize_t nargs);
+static PyObject* PyPushButton_SetOnClicked(PyPushButton* self, PyObject* const* args, Py_ssize_t nargs);
+static PyObject* PyPushButton_SetOnClickedBatched(PyPushButton* self, PyObject* const* args, Py_ssize_t nargs);
+static PyObject* PyPushButton_Click(PyPushButton* self);
 
 static PyMethodDef PyPushButton_methods[] = {
-    {"get_class_name", (PyCFunction)PyPushButton_GetClassName, METH_NOARGS, "Returns class name"},
-    {"set_text", (PyCFunction)PyPushButton_SetText, METH_VARARGS, "Sets text"},
-    {"set_on_clicked", (PyCFunction)PyPushButton_SetOnClicked, METH_VARARGS, "Sets onClick callback"},
+    {"set_text", PY_GUI_METHOD(PyPushButton_SetText), METH_FASTCALL, "Sets text"},
+    {"set_on_clicked", PY_GUI_METHOD(PyPushButton_SetOnClicked), METH_FASTCALL, "Sets onClick callback"},
+    {"set_on_clicked_batched", PY_GUI_METHOD(PyPushButton_SetOnClickedBatched), METH_FASTCALL,
+        "Sets onClick callback that gets a list of senders once per event loop iteration;"
+        " the optional second argument drops repeated clicks within one batch"},
+    {"click", PY_GUI_METHOD(PyPushButton_Click), METH_NOARGS, "Performs a click"},
     {NULL}
 };
 
-PY_CLASS_WRAPPER(PushButton, PyPushButton_methods, PyPushButton_new)
-
-static PyObject* PyPushButton_new(PyTypeObject* type, PyObject* args, PyObject* kwds) {
-    PyPushButton* self = (PyPushButton*)type->tp_alloc(type, 0);
+PY_CLASS_WRAPPER(PushButton, PyPushButton_methods, PyPushButton_Create)
 
+static PyObject* PyPushButton_Create(PyTypeObject* type, PyObject* const* args, Py_ssize_t nargs) {
     PyWidget* parent = NULL;
-    if (!PyArg_ParseTuple(args, "O", &parent)) {
+    if (!PyWidgets_CheckArgsCount("PushButton", nargs, 1) || !Py_ConvertWidget(args[0], &parent)) {
         return NULL;
     }
-    Py_INCREF(parent);
+
+    PyPushButton* self = Py_AllocPushButton(type);
     if (self != NULL) {
-        self->pImpl = PushButton_New(parent->pImpl);
+        Py_BindPushButton(self, PushButton_New(parent->pImpl));
     }
 
     return (PyObject*)self;
 }
 
-static PyObject* PyPushButton_GetClassName(PyPushButton* self) {
-    return PyUnicode_FromFormat("%s", Object_GetClassName((Object*) self->pImpl));
-}
-
-static PyObject* PyPushButton_SetText(PyPushButton* self, PyObject* args) {
-    const char* text;
-    if (!PyArg_ParseTuple(args, "s", &text)) {
+static PyObject* PyPushButton_SetText(PyPushButton* self, PyObject* const* args, Py_ssize_t nargs) {
+    QString text;
+    if (!PyWidgets_CheckAlive(self->pImpl) ||
+        !PyWidgets_CheckArgsCount("set_text", nargs, 1) || !PyWidgets_ToQString(args[0], &text))
+    {
         return NULL;
     }
     PushButton_SetText(self->pImpl, text);
     Py_RETURN_NONE;
 }
 
-static PyObject* PyPushButton_SetOnClicked(PyPushButton* self, PyObject* args) {
-    PyObject* callable = NULL;
-    if (!PyArg_ParseTuple(args, "O", &callable)) {
+static PyObject* PyPushButton_SetOnClicked(PyPushButton* self, PyObject* const* args, Py_ssize_t nargs) {
+    if (!PyWidgets_CheckAlive(self->pImpl) ||
+        !PyWidgets_CheckArgsCount("set_on_clicked", nargs, 1))
+    {
         return NULL;
     }
+    PyObject* callable = args[0];
     if (!PyCallable_Check(callable)) {
+        PyErr_SetString(PyExc_TypeError, "set_on_clicked() argument must be callable");
+        return NULL;
+    }
+    PyWidgetsObject* owner = (PyWidgetsObject*)self;
+    std::shared_ptr<PyObject> ownerRef = PyWidgets_NewOwnerRef(owner);
+    Py_ssize_t index = (ownerRef != nullptr) ? PyWidgets_AddCallback(owner, callable) : -1;
+    if (index < 0) {
         return NULL;
     }
-    Py_INCREF(callable);
-    PyObject* callbackArg = Py_BuildValue("(O)", self);
-    PushButton_SetOnClicked(self->pImpl, [callbackArg, callable](Object*) {
-        PyObject_CallObject(callable, callbackArg);
+    PushButton_SetOnClicked(self->pImpl, [ownerRef, index](Object*) {
+        PyGILState_STATE gil = PyGILState_Ensure();
+        PyObject* owner;
+        PyObject* callable;
+        if (PyWidgets_LookupCallback(ownerRef.get(), index, &owner, &callable)) {
+            PyWidgets_FinishCallback(PyObject_CallFunctionObjArgs(callable, owner, NULL));
+            Py_DECREF(callable);
+            Py_DECREF(owner);
+        }
+        PyGILState_Release(gil);
     });
     Py_RETURN_NONE;
 }
 
+static PyObject* PyPushButton_SetOnClickedBatched(PyPushButton* self, PyObject* const* args, Py_ssize_t nargs) {
+    if (!PyWidgets_CheckAlive(self->pImpl)) {
+        return NULL;
+    }
+    bool deduplicate = false;
+    if (nargs != 1 && !PyWidgets_CheckArgsCount("set_on_clicked_batched", nargs, 2)) {
+        return NULL;
+    }
+    if (nargs == 2 && !PyWidgets_ToBool(args[1], &deduplicate)) {
+        return NULL;
+    }
+    PyObject* callable = args[0];
+    if (!PyCallable_Check(callable)) {
+        PyErr_SetString(PyExc_TypeError, "set_on_clicked_batched() argument must be callable");
+        return NULL;
+    }
+    PyWidgetsObject* owner = (PyWidgetsObject*)self;
+    std::shared_ptr<PyObject> ownerRef = PyWidgets_NewOwnerRef(owner);
+    Py_ssize_t index = (ownerRef != nullptr) ? PyWidgets_AddCallback(owner, callable) : -1;
+    if (index < 0) {
+        return NULL;
+    }
+    std::shared_ptr<SignalBatch> batch = SignalBatch_New([ownerRef, index](const std::vector<Object*>& senders) {
+        PyGILState_STATE gil = PyGILState_Ensure();
+        PyObject* owner;
+        PyObject* callable;
+        if (PyWidgets_LookupCallback(ownerRef.get(), index, &owner, &callable)) {
+            PyObject* list = PyWidgets_FromObjects(senders);
+            if (list != NULL) {
+                PyWidgets_FinishCallback(PyObject_CallFunctionObjArgs(callable, list, NULL));
+                Py_DECREF(list);
+            } else {
+                PyErr_Print();
+            }
+            Py_DECREF(callable);
+            Py_DECREF(owner);
+        }
+        PyGILState_Release(gil);
+    }, deduplicate);
+    PushButton_SetOnClickedBatched(self->pImpl, batch);
+    Py_RETURN_NONE;
+}
+
+static PyObject* PyPushButton_Click(PyPushButton* self) {
+    if (!PyWidgets_CheckAlive(self->pImpl)) {
+        return NULL;
+    }
+    PushButton_Click(self->pImpl);
+    Py_RETURN_NONE;
+}
+
 //----------------------------------------------------------------------------------------
 
-static PyObject* PyVBoxLayout_AddWidget(PyVBoxLayout* self, PyObject* args) {
-    PyLabel* label = NULL;
-    if (PyArg_ParseTuple(args, "O", &label)) {
-        Layout_AddWidget((Layout*) self->pImpl, (Widget*) label->pImpl);
-        Py_RETURN_NONE;
+static PyObject* PyVBoxLayout_AddWidget(PyVBoxLayout* self, PyObject* const* args, Py_ssize_t nargs) {
+    QWidget* widget = NULL;
+    if (!PyWidgets_CheckAlive(self->pImpl) ||
+        !PyWidgets_CheckArgsCount("add_widget", nargs, 1) || !PyWidgets_ToQWidget(args[0], &widget))
+    {
+        return NULL;
     }
-    PyPushButton* pushButton = NULL;
-    if (PyArg_ParseTuple(args, "O", &pushButton)) {
-        Layout_AddWidget((Layout*) self->pImpl, (Widget*) pushButton->pImpl);
-        Py_RETURN_NONE;
+    Layout_AddWidget(self->pImpl, widget);
+    Py_RETURN_NONE;
+}
+
+//----------------------------------------------------------------------------------------
+
+struct PyListView;
+
+static PyObject* PyListView_Create(PyTypeObject* type, PyObject* const* args, Py_ssize_t nargs);
+static PyObject* PyListView_SetItems(PyListView* self, PyObject* const* args, Py_ssize_t nargs);
+static PyObject* PyListView_RowsChanged(PyListView* self, PyObject* const* args, Py_ssize_t nargs);
+static PyObject* PyListView_RowsInserted(PyListView* self, PyObject* const* args, Py_ssize_t nargs);
+static PyObject* PyListView_RowsRemoved(PyListView* self, PyObject* const* args, Py_ssize_t nargs);
+static PyObject* PyListView_Reset(PyListView* self);
+
+static PyMethodDef PyListView_methods[] = {
+    {"set_items", PY_GUI_METHOD(PyListView_SetItems), METH_FASTCALL,
+        "Shows str() of sequence items or numbers of a one-dimensional buffer; rows are read lazily"},
+    {"rows_changed", PY_GUI_METHOD(PyListView_RowsChanged), METH_FASTCALL,
+        "Redraws rows first..last (inclusive) after items changed in place"},
+    {"rows_inserted", PY_GUI_METHOD(PyListView_RowsInserted), METH_FASTCALL,
+        "Notifies that rows first..last (inclusive) were inserted into items"},
+    {"rows_removed", PY_GUI_METHOD(PyListView_RowsRemoved), METH_FASTCALL,
+        "Notifies that rows first..last (inclusive) were removed from items"},
+    {"reset", PY_GUI_METHOD(PyListView_Reset), METH_NOARGS, "Rereads the number of items"},
+    {NULL}
+};
+
+PY_CLASS_WRAPPER(ListView, PyListView_methods, PyListView_Create)
+
+static PyObject* PyListView_Create(PyTypeObject* type, PyObject* const* args, Py_ssize_t nargs) {
+    PyWidget* parent = NULL;
+    if (!PyWidgets_CheckArgsCount("ListView", nargs, 1) || !Py_ConvertWidget(args[0], &parent)) {
+        return NULL;
     }
-    return NULL;
+
+    PyListView* self = Py_AllocListView(type);
+    if (self != NULL) {
+        Py_BindListView(self, ListView_New(parent->pImpl));
+    }
+
+    return (PyObject*)self;
+}
+
+// Источник держит сильную ссылку на items: строки читаются, пока жив объект библиотеки,
+//  даже если обертки уже нет
+static PyObject* PyListView_SetItems(PyListView* self, PyObject* const* args, Py_ssize_t nargs) {
+    if (!PyWidgets_CheckAlive(self->pImpl) ||
+        !PyWidgets_CheckArgsCount("set_items", nargs, 1))
+    {
+        return NULL;
+    }
+    ListSource* source = PyWidgets_NewListSource(args[0]);
+    if (source == NULL) {
+        return NULL;
+    }
+    ListView_SetSource(self->pImpl, source);
+    Py_RETURN_NONE;
+}
+
+// Разбирает пару (first, last) для уведомлений об изменении строк
+static int PyListView_ToRowRange(const char* name, PyObject* const* args, Py_ssize_t nargs,
+    int* first, int* last)
+{
+    return PyWidgets_CheckArgsCount(name, nargs, 2) &&
+        PyWidgets_ToInt(args[0], first) && PyWidgets_ToInt(args[1], last);
+}
+
+static PyObject* PyListView_RowsChanged(PyListView* self, PyObject* const* args, Py_ssize_t nargs) {
+    int first = 0, last = 0;
+    if (!PyWidgets_CheckAlive(self->pImpl) ||
+        !PyListView_ToRowRange("rows_changed", args, nargs, &first, &last))
+    {
+        return NULL;
+    }
+    ListView_RowsChanged(self->pImpl, first, last);
+    Py_RETURN_NONE;
+}
+
+static PyObject* PyListView_RowsInserted(PyListView* self, PyObject* const* args, Py_ssize_t nargs) {
+    int first = 0, last = 0;
+    if (!PyWidgets_CheckAlive(self->pImpl) ||
+        !PyListView_ToRowRange("rows_inserted", args, nargs, &first, &last))
+    {
+        return NULL;
+    }
+    ListView_RowsInserted(self->pImpl, first, last);
+    Py_RETURN_NONE;
+}
+
+static PyObject* PyListView_RowsRemoved(PyListView* self, PyObject* const* args, Py_ssize_t nargs) {
+    int first = 0, last = 0;
+    if (!PyWidgets_CheckAlive(self->pImpl) ||
+        !PyListView_ToRowRange("rows_removed", args, nargs, &first, &last))
+    {
+        return NULL;
+    }
+    ListView_RowsRemoved(self->pImpl, first, last);
+    Py_RETURN_NONE;
+}
+
+static PyObject* PyListView_Reset(PyListView* self) {
+    if (!PyWidgets_CheckAlive(self->pImpl)) {
+        return NULL;
+    }
+    ListView_Reset(self->pImpl);
+    Py_RETURN_NONE;
+}
+
+//----------------------------------------------------------------------------------------
+
+struct PyTableView;
+
+static PyObject* PyTableView_Create(PyTypeObject* type, PyObject* const* args, Py_ssize_t nargs);
+static PyObject* PyTableView_SetColumns(PyTableView* self, PyObject* const* args, Py_ssize_t nargs);
+static PyObject* PyTableView_Sort(PyTableView* self, PyObject* const* args, Py_ssize_t nargs);
+static PyObject* PyTableView_FilterRange(PyTableView* self, PyObject* const* args, Py_ssize_t nargs);
+static PyObject* PyTableView_FilterContains(PyTableView* self, PyObject* const* args, Py_ssize_t nargs);
+static PyObject* PyTableView_ClearFilter(PyTableView* self);
+static PyObject* PyTableView_Refresh(PyTableView* self);
+static PyObject* PyTableView_RowCount(PyTableView* self);
+static PyObject* PyTableView_SourceRow(PyTableView* self, PyObject* const* args, Py_ssize_t nargs);
+
+static PyMethodDef PyTableView_methods[] = {
+    {"set_columns", PY_GUI_METHOD(PyTableView_SetColumns), METH_FASTCALL,
+        "Shows columns given as (name, int64 or float64 buffer) or (name, int64 offsets, UTF-8 bytes);"
+        " offsets are copied, values and bytes are not"},
+    {"sort", PY_GUI_METHOD(PyTableView_Sort), METH_FASTCALL,
+        "Stable sort by column, descending if the second argument is true; column -1 restores the order"},
+    {"filter_range", PY_GUI_METHOD(PyTableView_FilterRange), METH_FASTCALL,
+        "Keeps rows whose numeric column value is within [low, high]"},
+    {"filter_contains", PY_GUI_METHOD(PyTableView_FilterContains), METH_FASTCALL,
+        "Keeps rows whose string column contains the text"},
+    {"clear_filter", PY_GUI_METHOD(PyTableView_ClearFilter), METH_NOARGS, "Shows all rows"},
+    {"refresh", PY_GUI_METHOD(PyTableView_Refresh), METH_NOARGS,
+        "Reapplies filter and sort after values changed in place"},
+    {"row_count", PY_GUI_METHOD(PyTableView_RowCount), METH_NOARGS, "Returns number of shown rows"},
+    {"source_row", PY_GUI_METHOD(PyTableView_SourceRow), METH_FASTCALL,
+        "Returns index in the column buffers of the shown row"},
+    {NULL}
+};
+
+PY_CLASS_WRAPPER(TableView, PyTableView_methods, PyTableView_Create)
+
+static PyObject* PyTableView_Create(PyTypeObject* type, PyObject* const* args, Py_ssize_t nargs) {
+    PyWidget* parent = NULL;
+    if (!PyWidgets_CheckArgsCount("TableView", nargs, 1) || !Py_ConvertWidget(args[0], &parent)) {
+        return NULL;
+    }
+
+    PyTableView* self = Py_AllocTableView(type);
+    if (self != NULL) {
+        Py_BindTableView(self, TableView_New(parent->pImpl));
+    }
+
+    return (PyObject*)self;
+}
+
+static PyObject* PyTableView_SetColumns(PyTableView* self, PyObject* const* args, Py_ssize_t nargs) {
+    std::vector<TableColumn> columns;
+    if (!PyWidgets_CheckAlive(self->pImpl) ||
+        !PyWidgets_CheckArgsCount("set_columns", nargs, 1) || !PyWidgets_ToTableColumns(args[0], &columns))
+    {
+        return NULL;
+    }
+    TableView_SetColumns(self->pImpl, std::move(columns));
+    Py_RETURN_NONE;
+}
+
+// Разбирает номер столбца и проверяет его тип; isString < 0 - любой тип
+static int PyTableView_ToColumn(PyTableView* self, PyObject* obj, int isString, int* result) {
+    if (!PyWidgets_ToInt(obj, result)) {
+        return 0;
+    }
+    const TableColumn* column = self->pImpl->GetModel()->GetColumn(*result);
+    if (column == NULL) {
+        PyErr_Format(PyExc_IndexError, "column %d out of range", *result);
+        return 0;
+    }
+    if (isString >= 0 && (column->type == TableColumnType_String) != (isString != 0)) {
+        PyErr_Format(PyExc_TypeError, "column %d must be %s", *result, isString ? "a string column" : "numeric");
+        return 0;
+    }
+    return 1;
+}
+
+// Сортировка и фильтр выполняются в GUI-потоке: параллельно работают только их части
+static PyObject* PyTableView_Sort(PyTableView* self, PyObject* const* args, Py_ssize_t nargs) {
+    int column = -1;
+    bool descending = false;
+    if (!PyWidgets_CheckAlive(self->pImpl)) {
+        return NULL;
+    }
+    if (nargs != 1 && !PyWidgets_CheckArgsCount("sort", nargs, 2)) {
+        return NULL;
+    }
+    if (!PyWidgets_ToInt(args[0], &column) || (nargs == 2 && !PyWidgets_ToBool(args[1], &descending))) {
+        return NULL;
+    }
+    if (column >= 0 && !PyTableView_ToColumn(self, args[0], -1, &column)) {
+        return NULL;
+    }
+    TableView_Sort(self->pImpl, column, descending);
+    Py_RETURN_NONE;
+}
+
+static PyObject* PyTableView_FilterRange(PyTableView* self, PyObject* const* args, Py_ssize_t nargs) {
+    int column = 0;
+    double low = 0, high = 0;
+    if (!PyWidgets_CheckAlive(self->pImpl) ||
+        !PyWidgets_CheckArgsCount("filter_range", nargs, 3) ||
+        !PyTableView_ToColumn(self, args[0], 0, &column))
+    {
+        return NULL;
+    }
+    // Целые границы для столбца int64 передаются как есть: double округлил бы большие значения
+    const TableColumn* target = self->pImpl->GetModel()->GetColumn(column);
+    if (target != NULL && target->type == TableColumnType_Int64 && PyLong_Check(args[1]) && PyLong_Check(args[2])) {
+        int lowOverflow = 0, highOverflow = 0;
+        long long lowInt = PyLong_AsLongLongAndOverflow(args[1], &lowOverflow);
+        long long highInt = PyLong_AsLongLongAndOverflow(args[2], &highOverflow);
+        // Границы за пределами int64 сужаются до них; пустой диапазон - low > high
+        if (lowOverflow != 0) {
+            lowInt = (lowOverflow < 0) ? LLONG_MIN : LLONG_MAX;
+        }
+        if (highOverflow != 0) {
+            highInt = (highOverflow < 0) ? LLONG_MIN : LLONG_MAX;
+        }
+        if (lowOverflow > 0 || highOverflow < 0) {
+            lowInt = 1;
+            highInt = 0;
+        }
+        TableView_FilterRangeInt64(self->pImpl, column, lowInt, highInt);
+        Py_RETURN_NONE;
+    }
+    if (!PyWidgets_ToDouble(args[1], &low) || !PyWidgets_ToDouble(args[2], &high)) {
+        return NULL;
+    }
+    TableView_FilterRange(self->pImpl, column, low, high);
+    Py_RETURN_NONE;
+}
+
+static PyObject* PyTableView_FilterContains(PyTableView* self, PyObject* const* args, Py_ssize_t nargs) {
+    int column = 0;
+    const char* text;
+    if (!PyWidgets_CheckAlive(self->pImpl) ||
+        !PyWidgets_CheckArgsCount("filter_contains", nargs, 2) ||
+        !PyTableView_ToColumn(self, args[0], 1, &column) || !PyWidgets_ToString(args[1], &text))
+    {
+        return NULL;
+    }
+    TableView_FilterContains(self->pImpl, column, QByteArray(text));
+    Py_RETURN_NONE;
+}
+
+static PyObject* PyTableView_ClearFilter(PyTableView* self) {
+    if (!PyWidgets_CheckAlive(self->pImpl)) {
+        return NULL;
+    }
+    TableView_ClearFilter(self->pImpl);
+    Py_RETURN_NONE;
+}
+
+static PyObject* PyTableView_Refresh(PyTableView* self) {
+    if (!PyWidgets_CheckAlive(self->pImpl)) {
+        return NULL;
+    }
+    TableView_Refresh(self->pImpl);
+    Py_RETURN_NONE;
+}
+
+static PyObject* PyTableView_RowCount(PyTableView* self) {
+    if (!PyWidgets_CheckAlive(self->pImpl)) {
+        return NULL;
+    }
+    return PyLong_FromLong(self->pImpl->GetModel()->rowCount());
+}
+
+static PyObject* PyTableView_SourceRow(PyTableView* self, PyObject* const* args, Py_ssize_t nargs) {
+    int row = 0;
+    if (!PyWidgets_CheckAlive(self->pImpl) ||
+        !PyWidgets_CheckArgsCount("source_row", nargs, 1) || !PyWidgets_ToInt(args[0], &row))
+    {
+        return NULL;
+    }
+    int sourceRow = self->pImpl->GetModel()->GetSourceRow(row);
+    if (sourceRow < 0) {
+        PyErr_Format(PyExc_IndexError, "row %d out of range", row);
+        return NULL;
+    }
+    return PyLong_FromLong(sourceRow);
+}
+
+//----------------------------------------------------------------------------------------
+
+struct PyImage;
+
+static PyObject* PyImage_Create(PyTypeObject* type, PyObject* const* args, Py_ssize_t nargs);
+static PyObject* PyImage_SetFrame(PyImage* self, PyObject* const* args, Py_ssize_t nargs);
+static PyObject* PyImage_Stats(PyImage* self);
+
+static PyMethodDef PyImage_methods[] = {
+    {"set_frame", PY_LOCKED_METHOD(PyImage_SetFrame), METH_FASTCALL,
+        "Shows frame (buffer, width, height, format='rgb888') without copying the buffer;"
+        " the buffer must not change until the next frame"},
+    {"stats", PY_LOCKED_METHOD(PyImage_Stats), METH_NOARGS,
+        "Returns dict with numbers of submitted, shown and dropped frames"},
+    {NULL}
+};
+
+PY_CLASS_WRAPPER(Image, PyImage_methods, PyImage_Create)
+
+static PyObject* PyImage_Create(PyTypeObject* type, PyObject* const* args, Py_ssize_t nargs) {
+    PyWidget* parent = NULL;
+    if (!PyWidgets_CheckArgsCount("Image", nargs, 1) || !Py_ConvertWidget(args[0], &parent)) {
+        return NULL;
+    }
+
+    PyImage* self = Py_AllocImage(type);
+    if (self != NULL) {
+        Py_BindImage(self, Image_New(parent->pImpl));
+    }
+
+    return (PyObject*)self;
+}
+
+struct PyImageFormat {
+    const char* name;
+    QImage::Format format;
+    int bytesPerPixel;
+};
+
+// Форматы, в которых строка кадра - просто width * bytesPerPixel байт
+static const PyImageFormat PyImage_Formats[] = {
+    {"rgb888", QImage::Format_RGB888, 3},
+    {"rgba8888", QImage::Format_RGBA8888, 4},
+    {"rgbx8888", QImage::Format_RGBX8888, 4},
+    {"argb32", QImage::Format_ARGB32, 4},
+    {"rgb32", QImage::Format_RGB32, 4},
+    {"grayscale8", QImage::Format_Grayscale8, 1},
+};
+
+static const PyImageFormat* PyImage_ToFormat(PyObject* obj) {
+    const char* name;
+    if (!PyWidgets_ToString(obj, &name)) {
+        return NULL;
+    }
+    for (const PyImageFormat& format : PyImage_Formats) {
+        if (strcmp(format.name, name) == 0) {
+            return &format;
+        }
+    }
+    PyErr_Format(PyExc_ValueError, "unknown image format '%.50s'", name);
+    return NULL;
+}
+
+// Буфер захватывается, а не копируется, и отпускается, когда кадр заменен следующим.
+//  Пока он захвачен, экспортер не даст его перевыделить (bytearray нельзя изменить в размере).
+//  Метод выполняется в вызвавшем потоке, а разбор аргументов может выполнить код Python,
+//  который отпустит GIL или критическую секцию, и GUI-поток успеет удалить объект. Поэтому
+//  pImpl проверяется непосредственно перед вызовом библиотеки - так же в методах Plot и LogView
+static PyObject* PyImage_SetFrame(PyImage* self, PyObject* const* args, Py_ssize_t nargs) {
+    int width = 0, height = 0;
+    const PyImageFormat* format = &PyImage_Formats[0];
+    if (nargs != 3 && !PyWidgets_CheckArgsCount("set_frame", nargs, 4)) {
+        return NULL;
+    }
+    if (!PyWidgets_ToInt(args[1], &width) || !PyWidgets_ToInt(args[2], &height) ||
+        (nargs == 4 && (format = PyImage_ToFormat(args[3])) == NULL))
+    {
+        return NULL;
+    }
+    if (width <= 0 || height <= 0 || width > INT_MAX / format->bytesPerPixel) {
+        PyErr_Format(PyExc_ValueError, "invalid frame size %dx%d", width, height);
+        return NULL;
+    }
+    std::shared_ptr<PyWidgetsBuffer> buffer = PyWidgets_AcquireBuffer(args[0]);
+    if (buffer == nullptr) {
+        return NULL;
+    }
+    int bytesPerLine = width * format->bytesPerPixel;
+    if (buffer->view.len / bytesPerLine < height) {
+        PyErr_Format(PyExc_ValueError, "buffer of %zd bytes is too small for %dx%d %s frame",
+            buffer->view.len, width, height, format->name);
+        return NULL;
+    }
+    if (!PyWidgets_CheckAlive(self->pImpl)) {
+        return NULL;
+    }
+    Image_SetFrame(self->pImpl, (const uchar*)buffer->view.buf, width, height, bytesPerLine,
+        format->format, buffer);
+    Py_RETURN_NONE;
+}
+
+static PyObject* PyImage_Stats(PyImage* self) {
+    if (!PyWidgets_CheckAlive(self->pImpl)) {
+        return NULL;
+    }
+    ImageStats stats = Image_GetStats(self->pImpl);
+    return Py_BuildValue("{sKsKsK}",
+        "submitted", (unsigned long long)stats.submitted,
+        "shown", (unsigned long long)stats.shown,
+        "dropped", (unsigned long long)stats.dropped);
+}
+
+//----------------------------------------------------------------------------------------
+
+struct PyPlot;
+
+static PyObject* PyPlot_Create(PyTypeObject* type, PyObject* const* args, Py_ssize_t nargs);
+static PyObject* PyPlot_SetSeries(PyPlot* self, PyObject* const* args, Py_ssize_t nargs);
+static PyObject* PyPlot_Append(PyPlot* self, PyObject* const* args, Py_ssize_t nargs);
+static PyObject* PyPlot_SetCapacity(PyPlot* self, PyObject* const* args, Py_ssize_t nargs);
+static PyObject* PyPlot_Clear(PyPlot* self);
+static PyObject* PyPlot_Size(PyPlot* self);
+
+static PyMethodDef PyPlot_methods[] = {
+    {"set_series", PY_LOCKED_METHOD(PyPlot_SetSeries), METH_FASTCALL,
+        "Replaces the series with values from a float64 buffer, keeping the last capacity points"},
+    {"append", PY_LOCKED_METHOD(PyPlot_Append), METH_FASTCALL,
+        "Appends a number or values from a float64 buffer, dropping the oldest points over capacity"},
+    {"set_capacity", PY_LOCKED_METHOD(PyPlot_SetCapacity), METH_FASTCALL,
+        "Sets how many last points are kept"},
+    {"clear", PY_LOCKED_METHOD(PyPlot_Clear), METH_NOARGS, "Removes all points"},
+    {"size", PY_LOCKED_METHOD(PyPlot_Size), METH_NOARGS, "Returns number of kept points"},
+    {NULL}
+};
+
+PY_CLASS_WRAPPER(Plot, PyPlot_methods, PyPlot_Create)
+
+static PyObject* PyPlot_Create(PyTypeObject* type, PyObject* const* args, Py_ssize_t nargs) {
+    PyWidget* parent = NULL;
+    if (!PyWidgets_CheckArgsCount("Plot", nargs, 1) || !Py_ConvertWidget(args[0], &parent)) {
+        return NULL;
+    }
+
+    PyPlot* self = Py_AllocPlot(type);
+    if (self != NULL) {
+        Py_BindPlot(self, Plot_New(parent->pImpl));
+    }
+
+    return (PyObject*)self;
+}
+
+// Значения копируются в кольцо графика сразу, поэтому буфер не захватывается дольше вызова
+//  и его можно тут же переиспользовать. Одно число принимается без протокола буфера
+static PyObject* PyPlot_AddValues(PyPlot* self, const char* name, PyObject* const* args, Py_ssize_t nargs,
+    void (*add)(Plot* plot, const double* values, size_t count))
+{
+    if (!PyWidgets_CheckArgsCount(name, nargs, 1)) {
+        return NULL;
+    }
+    if (!PyObject_CheckBuffer(args[0])) {
+        double value = 0;
+        if (!PyWidgets_ToDouble(args[0], &value) || !PyWidgets_CheckAlive(self->pImpl)) {
+            return NULL;
+        }
+        add(self->pImpl, &value, 1);
+        Py_RETURN_NONE;
+    }
+    Py_buffer view;
+    if (PyObject_GetBuffer(args[0], &view, PyBUF_C_CONTIGUOUS | PyBUF_FORMAT) < 0) {
+        return NULL;
+    }
+    if (!PyWidgets_IsFloat64Buffer(view)) {
+        PyBuffer_Release(&view);
+        PyErr_SetString(PyExc_TypeError, "expected one-dimensional float64 buffer");
+        return NULL;
+    }
+    if (!PyWidgets_CheckAlive(self->pImpl)) {
+        PyBuffer_Release(&view);
+        return NULL;
+    }
+    add(self->pImpl, (const double*)view.buf, (size_t)PyWidgets_GetBufferLength(view));
+    PyBuffer_Release(&view);
+    Py_RETURN_NONE;
+}
+
+static PyObject* PyPlot_SetSeries(PyPlot* self, PyObject* const* args, Py_ssize_t nargs) {
+    return PyPlot_AddValues(self, "set_series", args, nargs, Plot_SetSeries);
+}
+
+static PyObject* PyPlot_Append(PyPlot* self, PyObject* const* args, Py_ssize_t nargs) {
+    return PyPlot_AddValues(self, "append", args, nargs, Plot_Append);
+}
+
+static PyObject* PyPlot_SetCapacity(PyPlot* self, PyObject* const* args, Py_ssize_t nargs) {
+    if (!PyWidgets_CheckArgsCount("set_capacity", nargs, 1)) {
+        return NULL;
+    }
+    Py_ssize_t capacity = PyNumber_AsSsize_t(args[0], PyExc_OverflowError);
+    if (capacity == -1 && PyErr_Occurred()) {
+        return NULL;
+    }
+    if (capacity <= 0) {
+        PyErr_SetString(PyExc_ValueError, "capacity must be positive");
+        return NULL;
+    }
+    if (!PyWidgets_CheckAlive(self->pImpl)) {
+        return NULL;
+    }
+    Plot_SetCapacity(self->pImpl, (size_t)capacity);
+    Py_RETURN_NONE;
+}
+
+static PyObject* PyPlot_Clear(PyPlot* self) {
+    if (!PyWidgets_CheckAlive(self->pImpl)) {
+        return NULL;
+    }
+    Plot_Clear(self->pImpl);
+    Py_RETURN_NONE;
+}
+
+static PyObject* PyPlot_Size(PyPlot* self) {
+    if (!PyWidgets_CheckAlive(self->pImpl)) {
+        return NULL;
+    }
+    return PyLong_FromSize_t(Plot_GetSize(self->pImpl));
+}
+
+//----------------------------------------------------------------------------------------
+
+struct PyLogView;
+
+static PyObject* PyLogView_Create(PyTypeObject* type, PyObject* const* args, Py_ssize_t nargs);
+static PyObject* PyLogView_Append(PyLogView* self, PyObject* const* args, Py_ssize_t nargs);
+static PyObject* PyLogView_AppendMany(PyLogView* self, PyObject* const* args, Py_ssize_t nargs);
+static PyObject* PyLogView_SetMaxLines(PyLogView* self, PyObject* const* args, Py_ssize_t nargs);
+static PyObject* PyLogView_Clear(PyLogView* self);
+static PyObject* PyLogView_LineCount(PyLogView* self);
+
+static PyMethodDef PyLogView_methods[] = {
+    {"append", PY_LOCKED_METHOD(PyLogView_Append), METH_FASTCALL, "Appends a line"},
+    {"append_many", PY_LOCKED_METHOD(PyLogView_AppendMany), METH_FASTCALL, "Appends a sequence of lines"},
+    {"set_max_lines", PY_LOCKED_METHOD(PyLogView_SetMaxLines), METH_FASTCALL,
+        "Sets how many last lines are kept"},
+    {"clear", PY_LOCKED_METHOD(PyLogView_Clear), METH_NOARGS, "Removes all lines"},
+    {"line_count", PY_LOCKED_METHOD(PyLogView_LineCount), METH_NOARGS,
+        "Returns number of kept lines, including not yet shown"},
+    {NULL}
+};
+
+PY_CLASS_WRAPPER(LogView, PyLogView_methods, PyLogView_Create)
+
+static PyObject* PyLogView_Create(PyTypeObject* type, PyObject* const* args, Py_ssize_t nargs) {
+    PyWidget* parent = NULL;
+    if (!PyWidgets_CheckArgsCount("LogView", nargs, 1) || !Py_ConvertWidget(args[0], &parent)) {
+        return NULL;
+    }
+
+    PyLogView* self = Py_AllocLogView(type);
+    if (self != NULL) {
+        Py_BindLogView(self, LogView_New(parent->pImpl));
+    }
+
+    return (PyObject*)self;
+}
+
+// Строки журнала не повторяются, поэтому идут мимо кэша PyWidgets_ToQString
+static PyObject* PyLogView_Append(PyLogView* self, PyObject* const* args, Py_ssize_t nargs) {
+    QString line;
+    if (!PyWidgets_CheckAlive(self->pImpl) || !PyWidgets_CheckArgsCount("append", nargs, 1) ||
+        !PyWidgets_CheckUnicode(args[0]) || !PyWidgets_UnicodeToQString(args[0], &line))
+    {
+        return NULL;
+    }
+    LogView_Append(self->pImpl, line);
+    Py_RETURN_NONE;
+}
+
+// Все строки проверяются до добавления, поэтому при ошибке журнал не меняется.
+//  Пачка берет блокировку журнала один раз
+static PyObject* PyLogView_AppendMany(PyLogView* self, PyObject* const* args, Py_ssize_t nargs) {
+    if (!PyWidgets_CheckArgsCount("append_many", nargs, 1)) {
+        return NULL;
+    }
+    PyObject* sequence = PySequence_Fast(args[0], "expected a sequence of str");
+    if (sequence == NULL) {
+        return NULL;
+    }
+    Py_ssize_t count = PySequence_Fast_GET_SIZE(sequence);
+    PyObject** items = PySequence_Fast_ITEMS(sequence);
+    std::vector<QString> lines;
+    lines.reserve(count);
+    for (Py_ssize_t i = 0; i < count; ++i) {
+        lines.push_back(QString());
+        if (!PyWidgets_CheckUnicode(items[i]) || !PyWidgets_UnicodeToQString(items[i], &lines.back())) {
+            Py_DECREF(sequence);
+            return NULL;
+        }
+    }
+    Py_DECREF(sequence);
+    if (!PyWidgets_CheckAlive(self->pImpl)) {
+        return NULL;
+    }
+    LogView_AppendMany(self->pImpl, lines);
+    Py_RETURN_NONE;
+}
+
+static PyObject* PyLogView_SetMaxLines(PyLogView* self, PyObject* const* args, Py_ssize_t nargs) {
+    int maxLines = 0;
+    if (!PyWidgets_CheckArgsCount("set_max_lines", nargs, 1) || !PyWidgets_ToInt(args[0], &maxLines)) {
+        return NULL;
+    }
+    if (maxLines <= 0) {
+        PyErr_SetString(PyExc_ValueError, "max_lines must be positive");
+        return NULL;
+    }
+    if (!PyWidgets_CheckAlive(self->pImpl)) {
+        return NULL;
+    }
+    LogView_SetMaxLines(self->pImpl, maxLines);
+    Py_RETURN_NONE;
+}
+
+static PyObject* PyLogView_Clear(PyLogView* self) {
+    if (!PyWidgets_CheckAlive(self->pImpl)) {
+        return NULL;
+    }
+    LogView_Clear(self->pImpl);
+    Py_RETURN_NONE;
+}
+
+static PyObject* PyLogView_LineCount(PyLogView* self) {
+    if (!PyWidgets_CheckAlive(self->pImpl)) {
+        return NULL;
+    }
+    return PyLong_FromLong(LogView_GetLineCount(self->pImpl));
+}
+
+//----------------------------------------------------------------------------------------
+
+// Разбирает последовательность кортежей из itemSize элементов в обновления и ставит их
+//  в очередь Application_PostUpdates одной пачкой
+static PyObject* PyApplication_PostUpdates(const char* name, PyObject* items, Py_ssize_t itemSize,
+    int (*convert)(PyObject* const* item, PropertyUpdate* update))
+{
+    PyObject* sequence = PySequence_Fast(items, "expected a sequence of tuples");
+    if (sequence == NULL) {
+        return NULL;
+    }
+    Py_ssize_t count = PySequence_Fast_GET_SIZE(sequence);
+    PyObject** elements = PySequence_Fast_ITEMS(sequence);
+    std::vector<PropertyUpdate> updates;
+    updates.reserve(count);
+    for (Py_ssize_t i = 0; i < count; ++i) {
+        PyObject* item = elements[i];
+        if (!PyTuple_Check(item) || PyTuple_GET_SIZE(item) != itemSize) {
+            PyErr_Format(PyExc_TypeError, "%s() items must be tuples of %zd elements", name, itemSize);
+            Py_DECREF(sequence);
+            return NULL;
+        }
+        PropertyUpdate update = {};
+        if (!convert(&PyTuple_GET_ITEM(item, 0), &update)) {
+            Py_DECREF(sequence);
+            return NULL;
+        }
+        updates.push_back(update);
+    }
+    Py_DECREF(sequence);
+
+    Application_PostUpdates(updates);
+    Py_RETURN_NONE;
+}
+
+// Объект задан числом из Object.handle(): так обновления ставят интерпретаторы без оберток.
+//  Подходит ли свойство к объекту, выясняется при постановке в очередь
+static int PyApplication_ToHandleUpdate(PyObject* obj, UpdateProperty property, const QString& text,
+    int x, int y, PropertyUpdate* update)
+{
+    unsigned long long handle = PyLong_AsUnsignedLongLong(obj);
+    if (handle == (unsigned long long)-1 && PyErr_Occurred()) {
+        return 0;
+    }
+    *update = Update_ByHandle(handle, property, text, x, y);
+    return 1;
+}
+
+// Без GIL GUI-поток может удалять объект, пока другой поток ставит ему обновление, поэтому
+//  такой поток задает объект handle, выданным при привязке обертки, и к самому объекту
+//  не обращается: обновление удаленного к тому времени объекта отбрасывается
+static bool PyApplication_IsUpdateByHandle() {
+    return PY_WIDGETS_FREE_THREADED && !Application_IsGuiThread();
+}
+
+static int PyApplication_ToTextUpdate(PyObject* const* item, PropertyUpdate* update) {
+    QString text;
+    if (!PyWidgets_ToQString(item[1], &text)) {
+        return 0;
+    }
+    if (PyLong_Check(item[0])) {
+        return PyApplication_ToHandleUpdate(item[0], UpdateProperty_LabelText, text, 0, 0, update);
+    }
+    const PyWidgetsTypeInfo* info = PyWidgets_GetTypeInfo(item[0]);
+    PyWidgetsTypeTag tag = (info != NULL) ? ((PyWidgetsObject*)item[0])->tag : PyWidgetsTag_Unknown;
+    if (tag != PyWidgetsTag_Unknown && !PyWidgets_CheckAlive(info->getImpl(item[0]))) {
+        return 0;
+    }
+    if ((tag == PyWidgetsTag_Label || tag == PyWidgetsTag_PushButton) && PyApplication_IsUpdateByHandle()) {
+        *update = Update_ByHandle(((PyWidgetsObject*)item[0])->handle, UpdateProperty_LabelText, text, 0, 0);
+    } else if (tag == PyWidgetsTag_Label) {
+        *update = Update_LabelText(((PyLabel*)item[0])->pImpl, text);
+    } else if (tag == PyWidgetsTag_PushButton) {
+        *update = Update_PushButtonText(((PyPushButton*)item[0])->pImpl, text);
+    } else {
+        PyErr_Format(PyExc_TypeError, "expected Label or PushButton, got %.200s", Py_TYPE(item[0])->tp_name);
+        return 0;
+    }
+    return 1;
+}
+
+static int PyApplication_ToWindowTitleUpdate(PyObject* const* item, PropertyUpdate* update) {
+    PyWidget* widget = NULL;
+    QString title;
+    if (!PyWidgets_ToQString(item[1], &title)) {
+        return 0;
+    }
+    if (PyLong_Check(item[0])) {
+        return PyApplication_ToHandleUpdate(item[0], UpdateProperty_WindowTitle, title, 0, 0, update);
+    }
+    if (!Py_ConvertWidget(item[0], &widget)) {
+        return 0;
+    }
+    *update = PyApplication_IsUpdateByHandle() ?
+        Update_ByHandle(widget->handle, UpdateProperty_WindowTitle, title, 0, 0) : Update_WindowTitle(widget->pImpl, title);
+    return 1;
+}
+
+static int PyApplication_ToSizeUpdate(PyObject* const* item, PropertyUpdate* update) {
+    PyWidget* widget = NULL;
+    int width = 0, height = 0;
+    if (!PyWidgets_ToInt(item[1], &width) || !PyWidgets_ToInt(item[2], &height)) {
+        return 0;
+    }
+    if (PyLong_Check(item[0])) {
+        return PyApplication_ToHandleUpdate(item[0], UpdateProperty_Size, QString(), width, height, update);
+    }
+    if (!Py_ConvertWidget(item[0], &widget)) {
+        return 0;
+    }
+    *update = PyApplication_IsUpdateByHandle() ?
+        Update_ByHandle(widget->handle, UpdateProperty_Size, QString(), width, height) : Update_Size(widget->pImpl, width, height);
+    return 1;
+}
+
+static int PyApplication_ToVisibleUpdate(PyObject* const* item, PropertyUpdate* update) {
+    PyWidget* widget = NULL;
+    bool isVisible = false;
+    if (!PyWidgets_ToBool(item[1], &isVisible)) {
+        return 0;
+    }
+    if (PyLong_Check(item[0])) {
+        return PyApplication_ToHandleUpdate(item[0], UpdateProperty_Visible, QString(), isVisible, 0, update);
+    }
+    if (!Py_ConvertWidget(item[0], &widget)) {
+        return 0;
+    }
+    *update = PyApplication_IsUpdateByHandle() ?
+        Update_ByHandle(widget->handle, UpdateProperty_Visible, QString(), isVisible, 0) : Update_Visible(widget->pImpl, isVisible);
+    return 1;
+}
+
+static PyObject* PyApplication_PostSetText(PyApplication* self, PyObject* const* args, Py_ssize_t nargs) {
+    if (!PyWidgets_CheckArgsCount("post_set_text", nargs, 1)) {
+        return NULL;
+    }
+    return PyApplication_PostUpdates("post_set_text", args[0], 2, PyApplication_ToTextUpdate);
+}
+
+static PyObject* PyApplication_PostSetWindowTitle(PyApplication* self, PyObject* const* args, Py_ssize_t nargs) {
+    if (!PyWidgets_CheckArgsCount("post_set_window_title", nargs, 1)) {
+        return NULL;
+    }
+    return PyApplication_PostUpdates("post_set_window_title", args[0], 2, PyApplication_ToWindowTitleUpdate);
+}
+
+static PyObject* PyApplication_PostSetSize(PyApplication* self, PyObject* const* args, Py_ssize_t nargs) {
+    if (!PyWidgets_CheckArgsCount("post_set_size", nargs, 1)) {
+        return NULL;
+    }
+    return PyApplication_PostUpdates("post_set_size", args[0], 3, PyApplication_ToSizeUpdate);
+}
+
+static PyObject* PyApplication_PostSetVisible(PyApplication* self, PyObject* const* args, Py_ssize_t nargs) {
+    if (!PyWidgets_CheckArgsCount("post_set_visible", nargs, 1)) {
+        return NULL;
+    }
+    return PyApplication_PostUpdates("post_set_visible", args[0], 2, PyApplication_ToVisibleUpdate);
+}
+
+// Те же post_set_* на уровне модуля. С объектами, заданными handle, их можно вызывать
+//  и из интерпретатора, в котором нет ни Application, ни оберток
+static PyObject* PyWidgets_PostSetText(PyObject* module, PyObject* const* args, Py_ssize_t nargs) {
+    return PyApplication_PostSetText(NULL, args, nargs);
+}
+
+static PyObject* PyWidgets_PostSetWindowTitle(PyObject* module, PyObject* const* args, Py_ssize_t nargs) {
+    return PyApplication_PostSetWindowTitle(NULL, args, nargs);
+}
+
+static PyObject* PyWidgets_PostSetSize(PyObject* module, PyObject* const* args, Py_ssize_t nargs) {
+    return PyApplication_PostSetSize(NULL, args, nargs);
+}
+
+static PyObject* PyWidgets_PostSetVisible(PyObject* module, PyObject* const* args, Py_ssize_t nargs) {
+    return PyApplication_PostSetVisible(NULL, args, nargs);
+}
+
+// Применяет очередь в вызывающем потоке, поэтому только из GUI-потока
+static PyObject* PyApplication_FlushUpdates(PyApplication* self) {
+    if (!PyWidgets_CheckAlive(self->pImpl)) {
+        return NULL;
+    }
+    if (QThread::currentThread() != self->pImpl->GetQObject()->thread()) {
+        PyErr_SetString(PyExc_RuntimeError, "flush_updates() must be called from the GUI thread");
+        return NULL;
+    }
+    Application_FlushUpdates();
+    Py_RETURN_NONE;
+}
+
+static PyObject* PyApplication_UpdateStats(PyApplication* self) {
+    if (!PyWidgets_CheckAlive(self->pImpl)) {
+        return NULL;
+    }
+    UpdateStats stats = Application_GetUpdateStats();
+    return Py_BuildValue("{sKsKsKsKsKsK}",
+        "posted", (unsigned long long)stats.posted,
+        "coalesced", (unsigned long long)stats.coalesced,
+        "cancelled", (unsigned long long)stats.cancelled,
+        "unchanged", (unsigned long long)stats.unchanged,
+        "applied", (unsigned long long)stats.applied,
+        "dropped", (unsigned long long)stats.dropped);
 }
 
 #endif // PY_WIDGETS_CLASSES_H
@@ -0,0 +1,642 @@
+/*
+ * Буфер команд: операции функционального API записываются в компактный нативный
+ *  массив и выполняются одним вызовом flush()
+ */
+
+#ifndef PY_WIDGETS_COMMAND_BUFFER_H
+#define PY_WIDGETS_COMMAND_BUFFER_H
+
+#include <algorithm>
+#include <chrono>
+#include <unordered_map>
+#include <vector>
+#include <QPointer>
+#include "PyWidgetsClasses.h"
+
+enum CommandOp : unsigned char {
+    CommandOp_ApplicationNew,
+    CommandOp_ApplicationExec,
+    CommandOp_WidgetNew,
+    CommandOp_VBoxLayoutNew,
+    CommandOp_LabelNew,
+    CommandOp_PushButtonNew,
+    CommandOp_WidgetSetWindowTitle,
+    CommandOp_WidgetSetSize,
+    CommandOp_WidgetSetVisible,
+    CommandOp_WidgetSetLayout,
+    CommandOp_LayoutAddWidget,
+    CommandOp_LabelSetText,
+    CommandOp_PushButtonSetText,
+    CommandOp_ObjectGetClassName
+};
+
+// Команда занимает 16 байт: слот объекта, к которому она применяется (или который создает),
+//  и два аргумента - номер слота, число или номер строки в CommandBuffer::strings
+struct Command {
+    CommandOp op;
+    int target;
+    int arg1;
+    int arg2;
+};
+
+// Слот - объект, на который ссылаются команды: переданная в буфер обертка
+//  или объект, создаваемый одной из команд. Между flush объект может быть удален,
+//  например вместе с родителем, - тогда qobject обнуляется, и impl недействителен
+struct CommandSlot {
+    PyWidgetsTypeTag tag;
+    void* impl;                 // NULL, пока создающая команда не выполнена
+    QPointer<QObject> qobject;
+    QPointer<QWidget> widget;   // NULL, если объект не виджет
+    PyObject* wrapper;          // сильная ссылка на обертку или NULL
+};
+
+struct CommandBuffer {
+    std::vector<Command> commands;
+    std::vector<CommandSlot> objects;
+    std::vector<QString> strings;   // уже преобразованные аргументы-строки
+    std::unordered_map<PyObject*, int> importedObjects;
+
+    // Статистика выполнения flush
+    unsigned long long flushCount = 0;
+    unsigned long long executedCount = 0;
+    long long lastFlushNs = 0;
+    long long maxFlushNs = 0;
+    long long totalFlushNs = 0;
+};
+
+//----------------------------------------------------------------------------------------
+
+struct PyCommandBuffer {
+    PyObject_HEAD
+    CommandBuffer* pImpl;
+};
+
+// Таблица типов модуля, которому принадлежит буфер. Наследников у буфера нет, поэтому
+//  модуль известен его типу
+static const PyWidgetsTypeInfo* PyCommandBuffer_GetTypes(PyCommandBuffer* self) {
+    return ((PyWidgetsModuleState*)PyType_GetModuleState(Py_TYPE(self)))->types;
+}
+
+static PyObject* PyCommandBuffer_new(PyTypeObject* type, PyObject* args, PyObject* kwds) {
+    if (!PyWidgets_CheckArgsCount("CommandBuffer", PyTuple_GET_SIZE(args), 0) ||
+        !PyWidgets_CheckMainInterpreter("CommandBuffer"))
+    {
+        return NULL;
+    }
+    PyCommandBuffer* self = (PyCommandBuffer*)type->tp_alloc(type, 0);
+    if (self != NULL) {
+        self->pImpl = new CommandBuffer();
+    }
+
+    return (PyObject*)self;
+}
+
+static int PyCommandBuffer_Traverse(PyCommandBuffer* self, visitproc visit, void* arg) {
+    Py_VISIT(Py_TYPE(self));
+    if (self->pImpl != NULL) {
+        for (const CommandSlot& slot : self->pImpl->objects) {
+            Py_VISIT(slot.wrapper);
+        }
+    }
+    return 0;
+}
+
+// Обертки могут держать буфер через обработчики сигналов. Слоты остаются: команды
+//  по-прежнему ссылаются на их объекты
+static int PyCommandBuffer_Clear(PyCommandBuffer* self) {
+    if (self->pImpl == NULL) {
+        return 0;
+    }
+    self->pImpl->importedObjects.clear();
+    for (CommandSlot& slot : self->pImpl->objects) {
+        Py_CLEAR(slot.wrapper);
+    }
+    return 0;
+}
+
+// Созданными командами объектами без родителя, у которых нет обертки, владеет буфер
+//  (как обертка - своим объектом); остальными - Qt или их обертки. Обертка могла
+//  появиться и в обход get(), например через parent() или children()
+static void PyCommandBuffer_Dealloc(PyCommandBuffer* self) {
+    PyTypeObject* type = Py_TYPE(self);
+    PyObject_GC_UnTrack(self);
+    if (self->pImpl != NULL) {
+        // Сначала собираем владеемые объекты: удаление обертками может унести дочерние
+        std::vector<QPointer<QObject>> owned;
+        for (const CommandSlot& slot : self->pImpl->objects) {
+            if (slot.wrapper == NULL && !slot.qobject.isNull()) {
+                Object* object = PyCommandBuffer_GetTypes(self)[slot.tag].asObject(slot.impl);
+                if (Object_GetBinding(object) == NULL && !Object_HasParent(object)) {
+                    owned.push_back(slot.qobject);
+                }
+            }
+        }
+        PyCommandBuffer_Clear(self);
+        for (const QPointer<QObject>& qobject : owned) {
+            Object* object = dynamic_cast<Object*>(qobject.data());
+            if (object != NULL) {
+                Object_Release(object);
+            }
+        }
+        delete self->pImpl;
+    }
+    type->tp_free((PyObject*)self);
+    Py_DECREF(type);
+}
+
+// Разбирает аргумент-объект: номер слота, полученный от создающей команды, или обертку,
+//  которая при первом упоминании получает свой слот
+static int PyCommandBuffer_ToSlot(PyCommandBuffer* self, PyObject* obj, int* result) {
+    CommandBuffer* buffer = self->pImpl;
+    if (PyLong_Check(obj)) {
+        long index = PyLong_AsLong(obj);
+        if (index == -1 && PyErr_Occurred()) {
+            return 0;
+        }
+        if (index < 0 || index >= (long) buffer->objects.size()) {
+            PyErr_Format(PyExc_IndexError, "invalid CommandBuffer handle %ld", index);
+            return 0;
+        }
+        *result = (int) index;
+        return 1;
+    }
+
+    const PyWidgetsTypeInfo* info = PyWidgets_GetTypeInfo(obj);
+    if (info == NULL || info->getImpl == NULL) {
+        PyErr_Format(PyExc_TypeError, "expected pywidgets.Object or handle, got %.200s",
+            Py_TYPE(obj)->tp_name);
+        return 0;
+    }
+    auto it = buffer->importedObjects.find(obj);
+    if (it != buffer->importedObjects.end()) {
+        *result = it->second;
+        return 1;
+    }
+    void* impl = info->getImpl(obj);
+    if (!PyWidgets_CheckAlive(impl)) {
+        return 0;
+    }
+    CommandSlot slot = {((PyWidgetsObject*)obj)->tag, impl, info->asObject(impl)->GetQObject(),
+        info->asQWidget(impl), obj};
+    Py_INCREF(obj);
+    *result = (int) buffer->objects.size();
+    buffer->objects.push_back(slot);
+    buffer->importedObjects[obj] = *result;
+    return 1;
+}
+
+static int PyCommandBuffer_ToTypedSlot(PyCommandBuffer* self, PyObject* obj, PyWidgetsTypeTag tag,
+    int* result)
+{
+    if (!PyCommandBuffer_ToSlot(self, obj, result)) {
+        return 0;
+    }
+    PyWidgetsTypeTag slotTag = self->pImpl->objects[*result].tag;
+    if (slotTag != tag) {
+        const PyWidgetsTypeInfo* types = PyCommandBuffer_GetTypes(self);
+        PyErr_Format(PyExc_TypeError, "expected %U, got %U", types[tag].className, types[slotTag].className);
+        return 0;
+    }
+    return 1;
+}
+
+static int PyCommandBuffer_ToWidgetSlot(PyCommandBuffer* self, PyObject* obj, int* result) {
+    if (!PyCommandBuffer_ToSlot(self, obj, result)) {
+        return 0;
+    }
+    PyWidgetsTypeTag slotTag = self->pImpl->objects[*result].tag;
+    const PyWidgetsTypeInfo& info = PyCommandBuffer_GetTypes(self)[slotTag];
+    if (!info.isWidget) {
+        PyErr_Format(PyExc_TypeError, "expected widget, got %U", info.className);
+        return 0;
+    }
+    return 1;
+}
+
+// Строка преобразуется в QString сразу при записи: flush передает ее в Qt без
+//  промежуточного UTF-8
+static int PyCommandBuffer_ToStringArg(PyCommandBuffer* self, PyObject* obj, int* index) {
+    std::vector<QString>& strings = self->pImpl->strings;
+    if (strings.size() >= INT_MAX) {
+        PyErr_SetString(PyExc_OverflowError, "CommandBuffer text storage is full");
+        return 0;
+    }
+    QString text;
+    if (!PyWidgets_ToQString(obj, &text)) {
+        return 0;
+    }
+    *index = (int) strings.size();
+    strings.push_back(text);
+    return 1;
+}
+
+static void PyCommandBuffer_Record(PyCommandBuffer* self, CommandOp op, int target, int arg1 = 0,
+    int arg2 = 0)
+{
+    Command command = {op, target, arg1, arg2};
+    self->pImpl->commands.push_back(command);
+}
+
+// Резервирует слот под объект, который создаст команда op, и возвращает его номер
+static PyObject* PyCommandBuffer_RecordNew(PyCommandBuffer* self, CommandOp op, PyWidgetsTypeTag tag,
+    int parent = -1)
+{
+    CommandBuffer* buffer = self->pImpl;
+    int target = (int) buffer->objects.size();
+    CommandSlot slot = {tag, NULL, NULL, NULL, NULL};
+    buffer->objects.push_back(slot);
+    PyCommandBuffer_Record(self, op, target, parent);
+    return PyLong_FromLong(target);
+}
+
+//----------------------------------------------------------------------------------------
+
+static PyObject* PyCommandBuffer_ApplicationNew(PyCommandBuffer* self, PyObject* noargs) {
+    return PyCommandBuffer_RecordNew(self, CommandOp_ApplicationNew, PyWidgetsTag_Application);
+}
+
+static PyObject* PyCommandBuffer_WidgetNew(PyCommandBuffer* self, PyObject* noargs) {
+    return PyCommandBuffer_RecordNew(self, CommandOp_WidgetNew, PyWidgetsTag_Widget);
+}
+
+static PyObject* PyCommandBuffer_NewWithParent(PyCommandBuffer* self, const char* name,
+    PyObject* const* args, Py_ssize_t nargs, CommandOp op, PyWidgetsTypeTag tag)
+{
+    int parent = 0;
+    if (!PyWidgets_CheckArgsCount(name, nargs, 1) ||
+        !PyCommandBuffer_ToTypedSlot(self, args[0], PyWidgetsTag_Widget, &parent))
+    {
+        return NULL;
+    }
+    return PyCommandBuffer_RecordNew(self, op, tag, parent);
+}
+
+static PyObject* PyCommandBuffer_VBoxLayoutNew(PyCommandBuffer* self, PyObject* const* args, Py_ssize_t nargs) {
+    return PyCommandBuffer_NewWithParent(self, "vbox_layout_new", args, nargs,
+        CommandOp_VBoxLayoutNew, PyWidgetsTag_VBoxLayout);
+}
+
+static PyObject* PyCommandBuffer_LabelNew(PyCommandBuffer* self, PyObject* const* args, Py_ssize_t nargs) {
+    return PyCommandBuffer_NewWithParent(self, "label_new", args, nargs,
+        CommandOp_LabelNew, PyWidgetsTag_Label);
+}
+
+static PyObject* PyCommandBuffer_PushButtonNew(PyCommandBuffer* self, PyObject* const* args, Py_ssize_t nargs) {
+    return PyCommandBuffer_NewWithParent(self, "push_button_new", args, nargs,
+        CommandOp_PushButtonNew, PyWidgetsTag_PushButton);
+}
+
+static PyObject* PyCommandBuffer_ApplicationExec(PyCommandBuffer* self, PyObject* const* args, Py_ssize_t nargs) {
+    int app = 0;
+    if (!PyWidgets_CheckArgsCount("application_exec", nargs, 1) ||
+        !PyCommandBuffer_ToTypedSlot(self, args[0], PyWidgetsTag_Application, &app))
+    {
+        return NULL;
+    }
+    PyCommandBuffer_Record(self, CommandOp_ApplicationExec, app);
+    Py_RETURN_NONE;
+}
+
+static PyObject* PyCommandBuffer_WidgetSetWindowTitle(PyCommandBuffer* self, PyObject* const* args, Py_ssize_t nargs) {
+    int widget = 0, text = 0;
+    if (!PyWidgets_CheckArgsCount("widget_set_window_title", nargs, 2) ||
+        !PyCommandBuffer_ToTypedSlot(self, args[0], PyWidgetsTag_Widget, &widget) ||
+        !PyCommandBuffer_ToStringArg(self, args[1], &text))
+    {
+        return NULL;
+    }
+    PyCommandBuffer_Record(self, CommandOp_WidgetSetWindowTitle, widget, text);
+    Py_RETURN_NONE;
+}
+
+static PyObject* PyCommandBuffer_WidgetSetSize(PyCommandBuffer* self, PyObject* const* args, Py_ssize_t nargs) {
+    int widget = 0, width = 0, height = 0;
+    if (!PyWidgets_CheckArgsCount("widget_set_size", nargs, 3) ||
+        !PyCommandBuffer_ToTypedSlot(self, args[0], PyWidgetsTag_Widget, &widget) ||
+        !PyWidgets_ToInt(args[1], &width) || !PyWidgets_ToInt(args[2], &height))
+    {
+        return NULL;
+    }
+    PyCommandBuffer_Record(self, CommandOp_WidgetSetSize, widget, width, height);
+    Py_RETURN_NONE;
+}
+
+static PyObject* PyCommandBuffer_WidgetSetVisible(PyCommandBuffer* self, PyObject* const* args, Py_ssize_t nargs) {
+    int widget = 0;
+    bool isVisible = false;
+    if (!PyWidgets_CheckArgsCount("widget_set_visible", nargs, 2) ||
+        !PyCommandBuffer_ToTypedSlot(self, args[0], PyWidgetsTag_Widget, &widget) ||
+        !PyWidgets_ToBool(args[1], &isVisible))
+    {
+        return NULL;
+    }
+    PyCommandBuffer_Record(self, CommandOp_WidgetSetVisible, widget, isVisible);
+    Py_RETURN_NONE;
+}
+
+static PyObject* PyCommandBuffer_WidgetSetLayout(PyCommandBuffer* self, PyObject* const* args, Py_ssize_t nargs) {
+    int widget = 0, layout = 0;
+    if (!PyWidgets_CheckArgsCount("widget_set_layout", nargs, 2) ||
+        !PyCommandBuffer_ToTypedSlot(self, args[0], PyWidgetsTag_Widget, &widget) ||
+        !PyCommandBuffer_ToTypedSlot(self, args[1], PyWidgetsTag_VBoxLayout, &layout))
+    {
+        return NULL;
+    }
+    PyCommandBuffer_Record(self, CommandOp_WidgetSetLayout, widget, layout);
+    Py_RETURN_NONE;
+}
+
+static PyObject* PyCommandBuffer_LayoutAddWidget(PyCommandBuffer* self, PyObject* const* args, Py_ssize_t nargs) {
+    int layout = 0, widget = 0;
+    if (!PyWidgets_CheckArgsCount("layout_add_widget", nargs, 2) ||
+        !PyCommandBuffer_ToTypedSlot(self, args[0], PyWidgetsTag_VBoxLayout, &layout) ||
+        !PyCommandBuffer_ToWidgetSlot(self, args[1], &widget))
+    {
+        return NULL;
+    }
+    PyCommandBuffer_Record(self, CommandOp_LayoutAddWidget, layout, widget);
+    Py_RETURN_NONE;
+}
+
+static PyObject* PyCommandBuffer_LabelSetText(PyCommandBuffer* self, PyObject* const* args, Py_ssize_t nargs) {
+    int label = 0, text = 0;
+    if (!PyWidgets_CheckArgsCount("label_set_text", nargs, 2) ||
+        !PyCommandBuffer_ToTypedSlot(self, args[0], PyWidgetsTag_Label, &label) ||
+        !PyCommandBuffer_ToStringArg(self, args[1], &text))
+    {
+        return NULL;
+    }
+    PyCommandBuffer_Record(self, CommandOp_LabelSetText, label, text);
+    Py_RETURN_NONE;
+}
+
+static PyObject* PyCommandBuffer_PushButtonSetText(PyCommandBuffer* self, PyObject* const* args, Py_ssize_t nargs) {
+    int button = 0, text = 0;
+    if (!PyWidgets_CheckArgsCount("push_button_set_text", nargs, 2) ||
+        !PyCommandBuffer_ToTypedSlot(self, args[0], PyWidgetsTag_PushButton, &button) ||
+        !PyCommandBuffer_ToStringArg(self, args[1], &text))
+    {
+        return NULL;
+    }
+    PyCommandBuffer_Record(self, CommandOp_PushButtonSetText, button, text);
+    Py_RETURN_NONE;
+}
+
+static PyObject* PyCommandBuffer_ObjectGetClassName(PyCommandBuffer* self, PyObject* const* args, Py_ssize_t nargs) {
+    int object = 0;
+    if (!PyWidgets_CheckArgsCount("object_get_class_name", nargs, 1) ||
+        !PyCommandBuffer_ToSlot(self, args[0], &object))
+    {
+        return NULL;
+    }
+    PyCommandBuffer_Record(self, CommandOp_ObjectGetClassName, object);
+    Py_RETURN_NONE;
+}
+
+//----------------------------------------------------------------------------------------
+
+// На время выполнения буфера отключаем перерисовку окон, которых касаются команды
+static void PyCommandBuffer_SuspendUpdates(std::vector<QWidget*>& suspended, QWidget* widget) {
+    QWidget* window = widget->window();
+    if (window->updatesEnabled()) {
+        window->setUpdatesEnabled(false);
+        suspended.push_back(window);
+    }
+}
+
+static void PyCommandBuffer_ResumeUpdates(std::vector<QWidget*>& suspended) {
+    for (QWidget* window : suspended) {
+        window->setUpdatesEnabled(true);
+    }
+    suspended.clear();
+}
+
+static void PyCommandBuffer_SetCreated(CommandSlot& slot, void* impl, Object* object, QWidget* widget) {
+    slot.impl = impl;
+    slot.qobject = object->GetQObject();
+    slot.widget = widget;
+}
+
+// Объекты, с которыми работает команда, должны быть созданы и еще не удалены
+static int PyCommandBuffer_CheckSlot(const CommandSlot& slot) {
+    return PyWidgets_CheckAlive(slot.qobject.isNull() ? NULL : slot.impl);
+}
+
+static int PyCommandBuffer_CheckCommand(const std::vector<CommandSlot>& objects, const Command& command) {
+    switch (command.op) {
+    case CommandOp_ApplicationNew:
+    case CommandOp_WidgetNew:
+        return 1;
+    case CommandOp_VBoxLayoutNew:
+    case CommandOp_LabelNew:
+    case CommandOp_PushButtonNew:
+        return PyCommandBuffer_CheckSlot(objects[command.arg1]);
+    case CommandOp_WidgetSetLayout:
+    case CommandOp_LayoutAddWidget:
+        return PyCommandBuffer_CheckSlot(objects[command.target]) &&
+            PyCommandBuffer_CheckSlot(objects[command.arg1]);
+    default:
+        return PyCommandBuffer_CheckSlot(objects[command.target]);
+    }
+}
+
+// Выполняет все записанные команды. Возвращает список результатов команд,
+//  возвращающих значение (application_exec, object_get_class_name).
+//  Команды, оставшиеся невыполненными после ошибки, отбрасываются
+static PyObject* PyCommandBuffer_Flush(PyCommandBuffer* self, PyObject* noargs) {
+    CommandBuffer* buffer = self->pImpl;
+    PyObject* results = PyList_New(0);
+    if (results == NULL) {
+        return NULL;
+    }
+
+    auto start = std::chrono::steady_clock::now();
+    std::vector<QWidget*> suspended;
+    for (const CommandSlot& slot : buffer->objects) {
+        if (!slot.widget.isNull()) {
+            PyCommandBuffer_SuspendUpdates(suspended, slot.widget);
+        }
+    }
+
+    // Забираем команды из буфера: обработчики, вызванные во время application_exec,
+    //  могут записывать новые команды, которые выполнятся при следующем flush
+    std::vector<Command> commands;
+    std::vector<QString> strings;
+    commands.swap(buffer->commands);
+    strings.swap(buffer->strings);
+
+    std::vector<CommandSlot>& objects = buffer->objects;
+    size_t executed = 0;
+    for (const Command& command : commands) {
+        if (!PyCommandBuffer_CheckCommand(objects, command)) {
+            Py_CLEAR(results);
+            break;
+        }
+        CommandSlot& target = objects[command.target];
+        PyObject* result = NULL;
+        switch (command.op) {
+        case CommandOp_ApplicationNew: {
+            Application* app = Application_New();
+            PyCommandBuffer_SetCreated(target, app, app, NULL);
+            break;
+        }
+        case CommandOp_ApplicationExec: {
+            // Цикл событий должен работать с включенной перерисовкой и, как
+            //  в PyApplication_Exec, без GIL
+            PyCommandBuffer_ResumeUpdates(suspended);
+            Application* app = (Application*)target.impl;
+            int status = 0;
+            Py_BEGIN_ALLOW_THREADS
+            status = Application_Exec(app);
+            Py_END_ALLOW_THREADS
+            result = PyLong_FromLong(status);
+            break;
+        }
+        case CommandOp_WidgetNew: {
+            Widget* widget = Widget_New(NULL);
+            PyCommandBuffer_SetCreated(target, widget, widget, widget);
+            PyCommandBuffer_SuspendUpdates(suspended, widget);
+            break;
+        }
+        case CommandOp_VBoxLayoutNew: {
+            VBoxLayout* layout = VBoxLayout_New((Widget*)objects[command.arg1].impl);
+            PyCommandBuffer_SetCreated(target, layout, layout, NULL);
+            break;
+        }
+        case CommandOp_LabelNew: {
+            Label* label = Label_New((Widget*)objects[command.arg1].impl);
+            PyCommandBuffer_SetCreated(target, label, label, label);
+            break;
+        }
+        case CommandOp_PushButtonNew: {
+            PushButton* button = PushButton_New((Widget*)objects[command.arg1].impl);
+            PyCommandBuffer_SetCreated(target, button, button, button);
+            break;
+        }
+        case CommandOp_WidgetSetWindowTitle:
+            Widget_SetWindowTitle((Widget*)target.impl, strings[command.arg1]);
+            break;
+        case CommandOp_WidgetSetSize:
+            Widget_SetSize((Widget*)target.impl, command.arg1, command.arg2);
+            break;
+        case CommandOp_WidgetSetVisible:
+            Widget_SetVisible((Widget*)target.impl, command.arg1 != 0);
+            break;
+        case CommandOp_WidgetSetLayout:
+            Widget_SetLayout((Widget*)target.impl, (VBoxLayout*)objects[command.arg1].impl);
+            break;
+        case CommandOp_LayoutAddWidget:
+            Layout_AddWidget((VBoxLayout*)target.impl, objects[command.arg1].widget);
+            break;
+        case CommandOp_LabelSetText:
+            Label_SetText((Label*)target.impl, strings[command.arg1]);
+            break;
+        case CommandOp_PushButtonSetText:
+            PushButton_SetText((PushButton*)target.impl, strings[command.arg1]);
+            break;
+        case CommandOp_ObjectGetClassName:
+            result = PyCommandBuffer_GetTypes(self)[target.tag].className;
+            Py_INCREF(result);
+            break;
+        }
+        ++executed;
+        if (result != NULL) {
+            int status = PyList_Append(results, result);
+            Py_DECREF(result);
+            if (status < 0) {
+                Py_CLEAR(results);
+                break;
+            }
+        } else if (PyErr_Occurred()) {
+            Py_CLEAR(results);
+            break;
+        }
+    }
+    PyCommandBuffer_ResumeUpdates(suspended);
+
+    long long elapsed = std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now() - start).count();
+    buffer->flushCount += 1;
+    buffer->executedCount += executed;
+    buffer->lastFlushNs = elapsed;
+    buffer->maxFlushNs = std::max(buffer->maxFlushNs, elapsed);
+    buffer->totalFlushNs += elapsed;
+
+    return results;
+}
+
+// Возвращает обертку над объектом, созданным командой буфера
+static PyObject* PyCommandBuffer_Get(PyCommandBuffer* self, PyObject* const* args, Py_ssize_t nargs) {
+    int index = 0;
+    if (!PyWidgets_CheckArgsCount("get", nargs, 1) || !PyCommandBuffer_ToSlot(self, args[0], &index)) {
+        return NULL;
+    }
+    CommandSlot& slot = self->pImpl->objects[index];
+    if (slot.wrapper == NULL) {
+        if (slot.impl == NULL) {
+            PyErr_SetString(PyExc_RuntimeError, "object is not created yet, call flush() first");
+            return NULL;
+        }
+        if (!PyCommandBuffer_CheckSlot(slot)) {
+            return NULL;
+        }
+        slot.wrapper = PyCommandBuffer_GetTypes(self)[slot.tag].wrap(slot.impl);
+        if (slot.wrapper == NULL) {
+            return NULL;
+        }
+    }
+    Py_INCREF(slot.wrapper);
+    return slot.wrapper;
+}
+
+static PyObject* PyCommandBuffer_Stats(PyCommandBuffer* self, PyObject* noargs) {
+    CommandBuffer* buffer = self->pImpl;
+    return Py_BuildValue("{s:n,s:K,s:K,s:L,s:L,s:L}",
+        "pending", (Py_ssize_t) buffer->commands.size(),
+        "flushes", buffer->flushCount,
+        "executed", buffer->executedCount,
+        "last_flush_ns", buffer->lastFlushNs,
+        "max_flush_ns", buffer->maxFlushNs,
+        "total_flush_ns", buffer->totalFlushNs);
+}
+
+static PyMethodDef PyCommandBuffer_methods[] = {
+    {"application_new", PY_LOCKED_METHOD(PyCommandBuffer_ApplicationNew), METH_NOARGS, "Records Application_New, returns handle"},
+    {"application_exec", PY_LOCKED_METHOD(PyCommandBuffer_ApplicationExec), METH_FASTCALL, "Records Application_Exec"},
+    {"widget_new", PY_LOCKED_METHOD(PyCommandBuffer_WidgetNew), METH_NOARGS, "Records Widget_New, returns handle"},
+    {"vbox_layout_new", PY_LOCKED_METHOD(PyCommandBuffer_VBoxLayoutNew), METH_FASTCALL, "Records VBoxLayout_New, returns handle"},
+    {"label_new", PY_LOCKED_METHOD(PyCommandBuffer_LabelNew), METH_FASTCALL, "Records Label_New, returns handle"},
+    {"push_button_new", PY_LOCKED_METHOD(PyCommandBuffer_PushButtonNew), METH_FASTCALL, "Records PushButton_New, returns handle"},
+    {"widget_set_window_title", PY_LOCKED_METHOD(PyCommandBuffer_WidgetSetWindowTitle), METH_FASTCALL, "Records Widget_SetWindowTitle"},
+    {"widget_set_size", PY_LOCKED_METHOD(PyCommandBuffer_WidgetSetSize), METH_FASTCALL, "Records Widget_SetSize"},
+    {"widget_set_visible", PY_LOCKED_METHOD(PyCommandBuffer_WidgetSetVisible), METH_FASTCALL, "Records Widget_SetVisible"},
+    {"widget_set_layout", PY_LOCKED_METHOD(PyCommandBuffer_WidgetSetLayout), METH_FASTCALL, "Records Widget_SetLayout"},
+    {"layout_add_widget", PY_LOCKED_METHOD(PyCommandBuffer_LayoutAddWidget), METH_FASTCALL, "Records Layout_AddWidget"},
+    {"label_set_text", PY_LOCKED_METHOD(PyCommandBuffer_LabelSetText), METH_FASTCALL, "Records Label_SetText"},
+    {"push_button_set_text", PY_LOCKED_METHOD(PyCommandBuffer_PushButtonSetText), METH_FASTCALL, "Records PushButton_SetText"},
+    {"object_get_class_name", PY_LOCKED_METHOD(PyCommandBuffer_ObjectGetClassName), METH_FASTCALL, "Records Object_GetClassName"},
+    {"flush", PY_GUI_LOCKED_METHOD(PyCommandBuffer_Flush), METH_NOARGS, "Runs recorded commands, returns their results"},
+    {"get", PY_GUI_LOCKED_METHOD(PyCommandBuffer_Get), METH_FASTCALL, "Returns object created by handle"},
+    {"stats", PY_LOCKED_METHOD(PyCommandBuffer_Stats), METH_NOARGS, "Returns flush timings"},
+    {NULL}
+};
+
+static PyType_Slot PyCommandBuffer_slots[] = {
+    {Py_tp_dealloc, (void*)PyCommandBuffer_Dealloc},
+    {Py_tp_traverse, (void*)PyCommandBuffer_Traverse},
+    {Py_tp_clear, (void*)PyCommandBuffer_Clear},
+    {Py_tp_methods, (void*)PyCommandBuffer_methods},
+    {Py_tp_new, (void*)PyCommandBuffer_new},
+    {Py_tp_doc, (void*)"CommandBuffer object"},
+    {0, NULL}
+};
+
+static PyType_Spec Py_SpecCommandBuffer = {
+    "pywidgets.CommandBuffer",
+    sizeof(PyCommandBuffer),
+    0,
+    Py_TPFLAGS_DEFAULT | Py_TPFLAGS_HAVE_GC | PY_WIDGETS_TPFLAGS_IMMUTABLE,
+    PyCommandBuffer_slots
+};
+
+#endif // PY_WIDGETS_COMMAND_BUFFER_H
@@ -0,0 +1,421 @@
+/*
+ * Цикл asyncio поверх цикла событий Qt
+ */
+
+#ifndef PY_WIDGETS_EVENT_LOOP_H
+#define PY_WIDGETS_EVENT_LOOP_H
+
+#include <math.h>
+#include "PyWidgetsClasses.h"
+
+// Селектор для asyncio.SelectorEventLoop. select() не блокирует поток в epoll/select,
+//  а крутит цикл событий Qt, пока не готов дескриптор (QSocketNotifier), не подошел срок
+//  ближайшего отложенного вызова asyncio (QTimer) или не отработал Python-обработчик
+//  сигнала, который мог поставить в цикл новую работу. Реализовано то подмножество
+//  selectors.BaseSelector, которым пользуется asyncio
+struct PyEventLoopSelector {
+    PyObject_HEAD
+    EventPoller* pImpl;     // NULL после close()
+    int selectDepth;        // число идущих select(): их ожидание держит EventPoller
+    PyObject* app;          // уведомители Qt не должны пережить приложение
+    PyObject* keys;         // dict: дескриптор -> selectors.SelectorKey
+};
+
+// selectors.SelectorKey: asyncio читает из ключа fileobj и data. Заимствованная ссылка
+//  из состояния модуля, которому принадлежит селектор
+static PyObject* PyEventLoopSelector_GetKeyType(PyEventLoopSelector* self) {
+    PyWidgetsModuleState* state = (PyWidgetsModuleState*)PyType_GetModuleState(Py_TYPE(self));
+    if (state->selectorKeyType == NULL) {
+        PyObject* selectors = PyImport_ImportModule("selectors");
+        if (selectors == NULL) {
+            return NULL;
+        }
+        state->selectorKeyType = PyObject_GetAttrString(selectors, "SelectorKey");
+        Py_DECREF(selectors);
+    }
+    return state->selectorKeyType;
+}
+
+static PyObject* PyEventLoopSelector_new(PyTypeObject* type, PyObject* args, PyObject* kwds) {
+    PyApplication* app = NULL;
+    if (!PyWidgets_CheckArgsCount("EventLoopSelector", PyTuple_GET_SIZE(args), 1) ||
+        !Py_ConvertApplication(PyTuple_GET_ITEM(args, 0), &app))
+    {
+        return NULL;
+    }
+    if (app->pImpl->GetQObject()->thread() != QThread::currentThread()) {
+        PyErr_SetString(PyExc_RuntimeError, "EventLoopSelector() must be called from the GUI thread");
+        return NULL;
+    }
+    PyObject* keys = PyDict_New();
+    if (keys == NULL) {
+        return NULL;
+    }
+    PyEventLoopSelector* self = (PyEventLoopSelector*)type->tp_alloc(type, 0);
+    if (self == NULL) {
+        Py_DECREF(keys);
+        return NULL;
+    }
+    Py_INCREF(app);
+    self->app = (PyObject*)app;
+    self->keys = keys;
+    self->pImpl = EventPoller_New();
+    return (PyObject*)self;
+}
+
+static int PyEventLoopSelector_Traverse(PyEventLoopSelector* self, visitproc visit, void* arg) {
+    Py_VISIT(Py_TYPE(self));
+    Py_VISIT(self->app);
+    Py_VISIT(self->keys);
+    return 0;
+}
+
+// Селектор закрывается сразу, а EventPoller, пока его ждет select() (close() из
+//  обработчика), удаляет сам select() после выхода из ожидания
+static void PyEventLoopSelector_ClosePoller(PyEventLoopSelector* self) {
+    if (self->pImpl == NULL) {
+        return;
+    }
+    if (self->selectDepth == 0) {
+        EventPoller_Delete(self->pImpl);
+    } else {
+        EventPoller_InterruptWait();
+    }
+    self->pImpl = NULL;
+}
+
+// Ключи держат обработчики asyncio, а те - цикл, который держит селектор. Уведомители
+//  удаляются раньше, чем отпускается приложение: ссылка селектора может быть последней
+static int PyEventLoopSelector_Clear(PyEventLoopSelector* self) {
+    PyEventLoopSelector_ClosePoller(self);
+    Py_CLEAR(self->keys);
+    Py_CLEAR(self->app);
+    return 0;
+}
+
+static void PyEventLoopSelector_Dealloc(PyEventLoopSelector* self) {
+    PyTypeObject* type = Py_TYPE(self);
+    PyObject_GC_UnTrack(self);
+    PyEventLoopSelector_Clear(self);
+    type->tp_free((PyObject*)self);
+    Py_DECREF(type);
+}
+
+static int PyEventLoopSelector_CheckOpen(PyEventLoopSelector* self) {
+    if (self->pImpl == NULL || self->keys == NULL) {
+        PyErr_SetString(PyExc_RuntimeError, "EventLoopSelector is closed");
+        return 0;
+    }
+    return 1;
+}
+
+// Дескриптор по объекту, как в selectors: число или объект с fileno(). Закрытый файл
+//  fileno() уже не отдает, его ключ ищется по самому объекту, а если не найден - KeyError,
+//  как для любого незарегистрированного объекта. Возвращает ключ dict (новая ссылка) и,
+//  если он зарегистрирован, заимствованную ссылку на SelectorKey
+static PyObject* PyEventLoopSelector_Lookup(PyEventLoopSelector* self, PyObject* fileobj, PyObject** key) {
+    *key = NULL;
+    int fd = PyObject_AsFileDescriptor(fileobj);
+    if (fd >= 0) {
+        PyObject* fdObject = PyLong_FromLong(fd);
+        if (fdObject != NULL) {
+            *key = PyDict_GetItemWithError(self->keys, fdObject);
+            if (*key == NULL && PyErr_Occurred()) {
+                Py_CLEAR(fdObject);
+            }
+        }
+        return fdObject;
+    }
+    Py_ssize_t position = 0;
+    PyObject* fdObject;
+    PyObject* value;
+    while (PyDict_Next(self->keys, &position, &fdObject, &value)) {
+        if (PyTuple_GET_ITEM(value, 0) == fileobj) {
+            PyErr_Clear();
+            Py_INCREF(fdObject);
+            *key = value;
+            return fdObject;
+        }
+    }
+    if (PyErr_ExceptionMatches(PyExc_TypeError) || PyErr_ExceptionMatches(PyExc_ValueError)) {
+        PyErr_Clear();
+        PyErr_Format(PyExc_KeyError, "%R is not registered", fileobj);
+    }
+    return NULL;
+}
+
+static int PyEventLoopSelector_ToEvents(PyObject* obj, int* events) {
+    if (!PyWidgets_ToInt(obj, events)) {
+        return 0;
+    }
+    if (*events == 0 || (*events & ~(PollEvent_Read | PollEvent_Write)) != 0) {
+        PyErr_Format(PyExc_ValueError, "Invalid events: %d", *events);
+        return 0;
+    }
+    return 1;
+}
+
+static PyObject* PyEventLoopSelector_Register(PyEventLoopSelector* self, PyObject* const* args, Py_ssize_t nargs) {
+    if (!PyEventLoopSelector_CheckOpen(self)) {
+        return NULL;
+    }
+    if (nargs != 2 && !PyWidgets_CheckArgsCount("register", nargs, 3)) {
+        return NULL;
+    }
+    int events = 0;
+    if (!PyEventLoopSelector_ToEvents(args[1], &events)) {
+        return NULL;
+    }
+    PyObject* data = (nargs == 3) ? args[2] : Py_None;
+    PyObject* keyType = PyEventLoopSelector_GetKeyType(self);
+    if (keyType == NULL) {
+        return NULL;
+    }
+    int fd = PyObject_AsFileDescriptor(args[0]);
+    if (fd < 0) {
+        return NULL;
+    }
+    PyObject* fdObject = PyLong_FromLong(fd);
+    if (fdObject == NULL) {
+        return NULL;
+    }
+    int isRegistered = PyDict_Contains(self->keys, fdObject);
+    if (isRegistered != 0) {
+        if (isRegistered > 0) {
+            PyErr_Format(PyExc_KeyError, "%R (FD %d) is already registered", args[0], fd);
+        }
+        Py_DECREF(fdObject);
+        return NULL;
+    }
+    PyObject* key = PyObject_CallFunction(keyType, "OOiO", args[0], fdObject, events, data);
+    if (key == NULL || PyDict_SetItem(self->keys, fdObject, key) < 0) {
+        Py_XDECREF(key);
+        Py_DECREF(fdObject);
+        return NULL;
+    }
+    Py_DECREF(fdObject);
+    EventPoller_Watch(self->pImpl, fd, events);
+    return key;
+}
+
+static PyObject* PyEventLoopSelector_Unregister(PyEventLoopSelector* self, PyObject* const* args, Py_ssize_t nargs) {
+    if (!PyEventLoopSelector_CheckOpen(self) || !PyWidgets_CheckArgsCount("unregister", nargs, 1)) {
+        return NULL;
+    }
+    PyObject* key = NULL;
+    PyObject* fdObject = PyEventLoopSelector_Lookup(self, args[0], &key);
+    if (key == NULL) {
+        if (fdObject != NULL) {
+            PyErr_Format(PyExc_KeyError, "%R is not registered", args[0]);
+        }
+        Py_XDECREF(fdObject);
+        return NULL;
+    }
+    Py_INCREF(key);
+    int fd = (int)PyLong_AsLong(fdObject);
+    int isDeleted = PyDict_DelItem(self->keys, fdObject);
+    Py_DECREF(fdObject);
+    if (isDeleted < 0) {
+        Py_DECREF(key);
+        return NULL;
+    }
+    EventPoller_Watch(self->pImpl, fd, 0);
+    return key;
+}
+
+static PyObject* PyEventLoopSelector_Modify(PyEventLoopSelector* self, PyObject* const* args, Py_ssize_t nargs) {
+    if (!PyEventLoopSelector_CheckOpen(self)) {
+        return NULL;
+    }
+    if (nargs != 2 && !PyWidgets_CheckArgsCount("modify", nargs, 3)) {
+        return NULL;
+    }
+    int events = 0;
+    if (!PyEventLoopSelector_ToEvents(args[1], &events)) {
+        return NULL;
+    }
+    PyObject* keyType = PyEventLoopSelector_GetKeyType(self);
+    if (keyType == NULL) {
+        return NULL;
+    }
+    PyObject* key = NULL;
+    PyObject* fdObject = PyEventLoopSelector_Lookup(self, args[0], &key);
+    if (key == NULL) {
+        if (fdObject != NULL) {
+            PyErr_Format(PyExc_KeyError, "%R is not registered", args[0]);
+        }
+        Py_XDECREF(fdObject);
+        return NULL;
+    }
+    PyObject* data = (nargs == 3) ? args[2] : Py_None;
+    PyObject* newKey = PyObject_CallFunction(keyType, "OOiO", PyTuple_GET_ITEM(key, 0), fdObject, events, data);
+    if (newKey == NULL || PyDict_SetItem(self->keys, fdObject, newKey) < 0) {
+        Py_XDECREF(newKey);
+        Py_DECREF(fdObject);
+        return NULL;
+    }
+    EventPoller_Watch(self->pImpl, (int)PyLong_AsLong(fdObject), events);
+    Py_DECREF(fdObject);
+    return newKey;
+}
+
+static PyObject* PyEventLoopSelector_GetKey(PyEventLoopSelector* self, PyObject* const* args, Py_ssize_t nargs) {
+    if (!PyEventLoopSelector_CheckOpen(self) || !PyWidgets_CheckArgsCount("get_key", nargs, 1)) {
+        return NULL;
+    }
+    PyObject* key = NULL;
+    PyObject* fdObject = PyEventLoopSelector_Lookup(self, args[0], &key);
+    if (key == NULL) {
+        if (fdObject != NULL) {
+            PyErr_Format(PyExc_KeyError, "%R is not registered", args[0]);
+        }
+        Py_XDECREF(fdObject);
+        return NULL;
+    }
+    Py_DECREF(fdObject);
+    Py_INCREF(key);
+    return key;
+}
+
+static PyObject* PyEventLoopSelector_GetMap(PyEventLoopSelector* self) {
+    if (self->keys == NULL) {
+        Py_RETURN_NONE;
+    }
+    return PyDictProxy_New(self->keys);
+}
+
+// timeout - секунды: None - ждать без ограничения, <= 0 - не ждать. Возвращает список
+//  пар (SelectorKey, готовые события)
+static PyObject* PyEventLoopSelector_Select(PyEventLoopSelector* self, PyObject* const* args, Py_ssize_t nargs) {
+    if (!PyEventLoopSelector_CheckOpen(self)) {
+        return NULL;
+    }
+    if (nargs != 0 && !PyWidgets_CheckArgsCount("select", nargs, 1)) {
+        return NULL;
+    }
+    if (self->pImpl->thread() != QThread::currentThread()) {
+        PyErr_SetString(PyExc_RuntimeError, "select() must be called from the GUI thread");
+        return NULL;
+    }
+    int timeoutMs = -1;
+    if (nargs == 1 && args[0] != Py_None) {
+        double timeout = 0;
+        if (!PyWidgets_ToDouble(args[0], &timeout)) {
+            return NULL;
+        }
+        // Вверх, как в selectors: иначе срок, до которого осталось меньше миллисекунды,
+        //  превратился бы в опрос без ожидания и цикл крутился бы вхолостую
+        timeoutMs = (timeout <= 0) ? 0 : (int)std::min(ceil(timeout * 1e3), (double)INT_MAX);
+    }
+
+    // Обработчики, вызванные из цикла событий, берут GIL сами
+    std::vector<PollReady> ready;
+    EventPoller* poller = self->pImpl;
+    ++self->selectDepth;
+    Py_BEGIN_ALLOW_THREADS
+    ready = EventPoller_Wait(poller, timeoutMs);
+    Py_END_ALLOW_THREADS
+    if (--self->selectDepth == 0 && self->pImpl != poller) {
+        // Селектор закрыли, пока шло ожидание
+        EventPoller_Delete(poller);
+    }
+
+    PyObject* result = PyList_New(0);
+    if (result == NULL || self->keys == NULL) {
+        return result;
+    }
+    for (const PollReady& item : ready) {
+        // Обработчик мог снять дескриптор с регистрации, пока шло ожидание
+        PyObject* fdObject = PyLong_FromSsize_t(item.fd);
+        PyObject* key = (fdObject != NULL) ? PyDict_GetItemWithError(self->keys, fdObject) : NULL;
+        Py_XDECREF(fdObject);
+        if (key == NULL) {
+            if (PyErr_Occurred()) {
+                Py_DECREF(result);
+                return NULL;
+            }
+            continue;
+        }
+        int events = item.events & (int)PyLong_AsLong(PyTuple_GET_ITEM(key, 2));
+        if (events == 0) {
+            continue;
+        }
+        PyObject* pair = Py_BuildValue("(Oi)", key, events);
+        if (pair == NULL || PyList_Append(result, pair) < 0) {
+            Py_XDECREF(pair);
+            Py_DECREF(result);
+            return NULL;
+        }
+        Py_DECREF(pair);
+    }
+    return result;
+}
+
+static PyObject* PyEventLoopSelector_Close(PyEventLoopSelector* self) {
+    PyEventLoopSelector_ClosePoller(self);
+    if (self->keys != NULL) {
+        PyDict_Clear(self->keys);
+    }
+    Py_RETURN_NONE;
+}
+
+// Без GIL селектор могут вызывать из разных потоков: все методы идут в критической секции,
+//  а те, что трогают уведомители Qt, - еще и в GUI-потоке. select() там и должен
+//  вызываться, он проверяет это сам
+static PyMethodDef PyEventLoopSelector_methods[] = {
+    {"register", PY_GUI_LOCKED_METHOD(PyEventLoopSelector_Register), METH_FASTCALL,
+        "Starts watching fileobj for events (EVENT_READ | EVENT_WRITE); returns SelectorKey"},
+    {"unregister", PY_GUI_LOCKED_METHOD(PyEventLoopSelector_Unregister), METH_FASTCALL,
+        "Stops watching fileobj; returns its SelectorKey"},
+    {"modify", PY_GUI_LOCKED_METHOD(PyEventLoopSelector_Modify), METH_FASTCALL,
+        "Changes watched events and data of fileobj; returns the new SelectorKey"},
+    {"select", PY_LOCKED_METHOD(PyEventLoopSelector_Select), METH_FASTCALL,
+        "Runs the Qt event loop until a file object is ready, timeout expires or a Python handler runs;"
+        " returns a list of (key, events)"},
+    {"get_key", PY_LOCKED_METHOD(PyEventLoopSelector_GetKey), METH_FASTCALL, "Returns SelectorKey of fileobj"},
+    {"get_map", PY_LOCKED_METHOD(PyEventLoopSelector_GetMap), METH_NOARGS,
+        "Returns a read-only mapping of file descriptors to SelectorKey"},
+    {"close", PY_GUI_LOCKED_METHOD(PyEventLoopSelector_Close), METH_NOARGS, "Stops watching all file objects"},
+    {NULL}
+};
+
+static PyType_Slot PyEventLoopSelector_slots[] = {
+    {Py_tp_dealloc, (void*)PyEventLoopSelector_Dealloc},
+    {Py_tp_traverse, (void*)PyEventLoopSelector_Traverse},
+    {Py_tp_clear, (void*)PyEventLoopSelector_Clear},
+    {Py_tp_methods, (void*)PyEventLoopSelector_methods},
+    {Py_tp_new, (void*)PyEventLoopSelector_new},
+    {Py_tp_doc, (void*)"Selector for asyncio.SelectorEventLoop that waits inside the Qt event loop"},
+    {0, NULL}
+};
+
+static PyType_Spec Py_SpecEventLoopSelector = {
+    "pywidgets.EventLoopSelector",
+    sizeof(PyEventLoopSelector),
+    0,
+    Py_TPFLAGS_DEFAULT | Py_TPFLAGS_HAVE_GC | PY_WIDGETS_TPFLAGS_IMMUTABLE,
+    PyEventLoopSelector_slots
+};
+
+// asyncio.SelectorEventLoop на EventLoopSelector: Application.new_event_loop
+//  и Application_NewEventLoop
+static PyObject* PyWidgets_NewEventLoop(PyObject* app) {
+    PyWidgetsModuleState* state = PyWidgets_GetState();
+    if (state == NULL) {
+        return NULL;
+    }
+    PyObject* selector = PyObject_CallFunctionObjArgs((PyObject*)state->eventLoopSelectorType, app, NULL);
+    if (selector == NULL) {
+        return NULL;
+    }
+    PyObject* asyncio = PyImport_ImportModule("asyncio");
+    PyObject* loop = NULL;
+    if (asyncio != NULL) {
+        loop = PyObject_CallMethod(asyncio, "SelectorEventLoop", "O", selector);
+        Py_DECREF(asyncio);
+    }
+    Py_DECREF(selector);
+    return loop;
+}
+
+#endif // PY_WIDGETS_EVENT_LOOP_H
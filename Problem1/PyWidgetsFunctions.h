@@ -6,44 +6,154 @@
 #define PY_WIDGETS_FUNCTIONS_H
 
 #include "PyWidgetsClasses.h"
+#include "PyWidgetsCommandBuffer.h"
+#include "PyWidgetsEventLoop.h"
+#include "PyWidgetsTasks.h"
+#include "PyWidgetsTimers.h"
+#include "PyWidgetsTemplate.h"
 
 static PyObject* PyWidgets_Application_New(PyObject* module, PyObject* noargs) {
-    return PyApplication_new(&Py_TypeApplication, NULL, NULL);
+    return PyApplication_Create(PyWidgets_GetModuleState(module)->types[PyWidgetsTag_Application].type, NULL, 0);
 }
 
 static PyObject* PyWidgets_Widget_New(PyObject* module, PyObject* noargs) {
-    return PyWidget_new(&Py_TypeWidget, NULL, NULL);
+    return PyWidget_Create(PyWidgets_GetModuleState(module)->types[PyWidgetsTag_Widget].type, NULL, 0);
 }
 
-static PyObject* PyWidgets_VBoxLayout_New(PyObject* module, PyObject* args) {
-    return PyVBoxLayout_new(&Py_TypeVBoxLayout, args, NULL);
+static PyObject* PyWidgets_VBoxLayout_New(PyObject* module, PyObject* const* args, Py_ssize_t nargs) {
+    return PyVBoxLayout_Create(PyWidgets_GetModuleState(module)->types[PyWidgetsTag_VBoxLayout].type, args, nargs);
 }
 
-static PyObject* PyWidgets_Label_New(PyObject* module, PyObject* args) {
-    return PyLabel_new(&Py_TypeLabel, args, NULL);
+static PyObject* PyWidgets_Label_New(PyObject* module, PyObject* const* args, Py_ssize_t nargs) {
+    return PyLabel_Create(PyWidgets_GetModuleState(module)->types[PyWidgetsTag_Label].type, args, nargs);
 }
 
-static PyObject* PyWidgets_PushButton_New(PyObject* module, PyObject* args) {
-    return PyPushButton_new(&Py_TypePushButton, args, NULL);
+static PyObject* PyWidgets_PushButton_New(PyObject* module, PyObject* const* args, Py_ssize_t nargs) {
+    return PyPushButton_Create(PyWidgets_GetModuleState(module)->types[PyWidgetsTag_PushButton].type, args, nargs);
 }
 
 //----------------------------------------------------------------------------------------
 
-static PyObject* PyWidgets_Application_Exec(PyObject* module, PyObject* args) {
+static PyObject* PyWidgets_Application_Exec(PyObject* module, PyObject* const* args, Py_ssize_t nargs) {
     PyApplication* pyApplication = NULL;
-    if (!PyArg_ParseTuple(args, "O", &pyApplication)) {
+    if (!PyWidgets_CheckArgsCount("Application_Exec", nargs, 1) ||
+        !Py_ConvertApplication(args[0], &pyApplication))
+    {
         return NULL;
     }
 
     return PyApplication_Exec(pyApplication);
 }
 
+static PyObject* PyWidgets_Application_FlushUpdates(PyObject* module, PyObject* const* args, Py_ssize_t nargs) {
+    PyApplication* pyApplication = NULL;
+    if (!PyWidgets_CheckArgsCount("Application_FlushUpdates", nargs, 1) ||
+        !Py_ConvertApplication(args[0], &pyApplication))
+    {
+        return NULL;
+    }
+
+    return PyApplication_FlushUpdates(pyApplication);
+}
+
+static PyObject* PyWidgets_Application_GetUpdateStats(PyObject* module, PyObject* const* args, Py_ssize_t nargs) {
+    PyApplication* pyApplication = NULL;
+    if (!PyWidgets_CheckArgsCount("Application_GetUpdateStats", nargs, 1) ||
+        !Py_ConvertApplication(args[0], &pyApplication))
+    {
+        return NULL;
+    }
+
+    return PyApplication_UpdateStats(pyApplication);
+}
+
+static PyObject* PyWidgets_Application_NewEventLoop(PyObject* module, PyObject* const* args, Py_ssize_t nargs) {
+    PyApplication* pyApplication = NULL;
+    if (!PyWidgets_CheckArgsCount("Application_NewEventLoop", nargs, 1) ||
+        !Py_ConvertApplication(args[0], &pyApplication))
+    {
+        return NULL;
+    }
+
+    return PyApplication_NewEventLoop(pyApplication);
+}
+
+static PyObject* PyWidgets_Application_Submit(PyObject* module, PyObject* const* args, Py_ssize_t nargs, PyObject* kwnames) {
+    PyApplication* pyApplication = NULL;
+    if (nargs < 1) {
+        PyErr_SetString(PyExc_TypeError, "Application_Submit() missing required argument 'app'");
+        return NULL;
+    }
+    if (!Py_ConvertApplication(args[0], &pyApplication)) {
+        return NULL;
+    }
+
+    return PyApplication_Submit(pyApplication, args + 1, nargs - 1, kwnames);
+}
+
+static PyObject* PyWidgets_Application_GetTaskStats(PyObject* module, PyObject* const* args, Py_ssize_t nargs) {
+    PyApplication* pyApplication = NULL;
+    if (!PyWidgets_CheckArgsCount("Application_GetTaskStats", nargs, 1) ||
+        !Py_ConvertApplication(args[0], &pyApplication))
+    {
+        return NULL;
+    }
+
+    return PyApplication_TaskStats(pyApplication);
+}
+
+static PyObject* PyWidgets_Application_SetInterval(PyObject* module, PyObject* const* args, Py_ssize_t nargs) {
+    PyApplication* pyApplication = NULL;
+    if ((nargs != 3 && !PyWidgets_CheckArgsCount("Application_SetInterval", nargs, 4)) ||
+        !Py_ConvertApplication(args[0], &pyApplication))
+    {
+        return NULL;
+    }
+
+    return PyApplication_SetInterval(pyApplication, args + 1, nargs - 1);
+}
+
+static PyObject* PyWidgets_Application_SetTimeout(PyObject* module, PyObject* const* args, Py_ssize_t nargs) {
+    PyApplication* pyApplication = NULL;
+    if ((nargs != 3 && !PyWidgets_CheckArgsCount("Application_SetTimeout", nargs, 4)) ||
+        !Py_ConvertApplication(args[0], &pyApplication))
+    {
+        return NULL;
+    }
+
+    return PyApplication_SetTimeout(pyApplication, args + 1, nargs - 1);
+}
+
+static PyObject* PyWidgets_Application_RequestFrame(PyObject* module, PyObject* const* args, Py_ssize_t nargs) {
+    PyApplication* pyApplication = NULL;
+    if ((nargs != 2 && !PyWidgets_CheckArgsCount("Application_RequestFrame", nargs, 3)) ||
+        !Py_ConvertApplication(args[0], &pyApplication))
+    {
+        return NULL;
+    }
+
+    return PyApplication_RequestFrame(pyApplication, args + 1, nargs - 1);
+}
+
+static PyObject* PyWidgets_Application_GetSchedulerStats(PyObject* module, PyObject* const* args, Py_ssize_t nargs) {
+    PyApplication* pyApplication = NULL;
+    if (!PyWidgets_CheckArgsCount("Application_GetSchedulerStats", nargs, 1) ||
+        !Py_ConvertApplication(args[0], &pyApplication))
+    {
+        return NULL;
+    }
+
+    return PyApplication_SchedulerStats(pyApplication);
+}
+
 //----------------------------------------------------------------------------------------
 
-static PyObject* PyWidgets_Widget_SetWindowTitle(PyObject* module, PyObject* args) {
+static PyObject* PyWidgets_Widget_SetWindowTitle(PyObject* module, PyObject* const* args, Py_ssize_t nargs) {
     PyWidget* pyWidget = NULL;
-    const char* title;
-    if (!PyArg_ParseTuple(args, "Os", &pyWidget, &title)) {
+    QString title;
+    if (!PyWidgets_CheckArgsCount("Widget_SetWindowTitle", nargs, 2) ||
+        !Py_ConvertWidget(args[0], &pyWidget) || !PyWidgets_ToQString(args[1], &title))
+    {
         return NULL;
     }
 
@@ -51,10 +161,13 @@ static PyObject* PyWidgets_Widget_SetWindowTitle(PyObject* module, PyObject* arg
     Py_RETURN_NONE;
 }
 
-static PyObject* PyWidgets_Widget_SetSize(PyObject* module, PyObject* args) {
+static PyObject* PyWidgets_Widget_SetSize(PyObject* module, PyObject* const* args, Py_ssize_t nargs) {
     PyWidget* pyWidget = NULL;
     int width = 0, height = 0;
-    if (!PyArg_ParseTuple(args, "Oii", &pyWidget, &width, &height)) {
+    if (!PyWidgets_CheckArgsCount("Widget_SetSize", nargs, 3) ||
+        !Py_ConvertWidget(args[0], &pyWidget) ||
+        !PyWidgets_ToInt(args[1], &width) || !PyWidgets_ToInt(args[2], &height))
+    {
         return NULL;
     }
 
@@ -62,44 +175,58 @@ static PyObject* PyWidgets_Widget_SetSize(PyObject* module, PyObject* args) {
     Py_RETURN_NONE;
 }
 
-static PyObject* PyWidgets_Widget_SetVisible(PyObject* module, PyObject* args) {
+static PyObject* PyWidgets_Widget_SetVisible(PyObject* module, PyObject* const* args, Py_ssize_t nargs) {
     PyWidget* pyWidget = NULL;
-    PyObject* isVisible = NULL;
-    if (!PyArg_ParseTuple(args, "OO", &pyWidget, &isVisible)) {
+    bool isVisible = false;
+    if (!PyWidgets_CheckArgsCount("Widget_SetVisible", nargs, 2) ||
+        !Py_ConvertWidget(args[0], &pyWidget) || !PyWidgets_ToBool(args[1], &isVisible))
+    {
         return NULL;
     }
-    Widget_SetVisible(pyWidget->pImpl, PyObject_IsTrue(isVisible));
+    Widget_SetVisible(pyWidget->pImpl, isVisible);
     Py_RETURN_NONE;
 }
 
-static PyObject* PyWidgets_Widget_SetLayout(PyObject* module, PyObject* args) {
+static PyObject* PyWidgets_Widget_SetLayout(PyObject* module, PyObject* const* args, Py_ssize_t nargs) {
     PyWidget* pyWidget = NULL;
     PyVBoxLayout* pyLayout = NULL;
-    if (!PyArg_ParseTuple(args, "OO", &pyWidget, &pyLayout)) {
+    if (!PyWidgets_CheckArgsCount("Widget_SetLayout", nargs, 2) ||
+        !Py_ConvertWidget(args[0], &pyWidget) || !Py_ConvertVBoxLayout(args[1], &pyLayout))
+    {
         return NULL;
     }
-    Widget_SetLayout(pyWidget->pImpl, (Layout*) pyLayout->pImpl);
+    Widget_SetLayout(pyWidget->pImpl, pyLayout->pImpl);
     Py_RETURN_NONE;
 }
 
+static PyObject* PyWidgets_Widget_ApplyState(PyObject* module, PyObject* const* args, Py_ssize_t nargs) {
+    PyWidget* pyWidget = NULL;
+    if (!PyWidgets_CheckArgsCount("Widget_ApplyState", nargs, 2) || !Py_ConvertWidget(args[0], &pyWidget)) {
+        return NULL;
+    }
+    return PyWidgets_ApplyState("Widget_ApplyState", pyWidget->pImpl, args[1]);
+}
+
 //----------------------------------------------------------------------------------------
 
-static PyObject* PyWidgets_Layout_AddWidget(PyObject* module, PyObject* args) {
-    PyObject* pyWidget = NULL;
+static PyObject* PyWidgets_Layout_AddWidget(PyObject* module, PyObject* const* args, Py_ssize_t nargs) {
     PyVBoxLayout* pyLayout = NULL;
-    if (!PyArg_ParseTuple(args, "OO", &pyLayout, &pyWidget)) {
+    if (!PyWidgets_CheckArgsCount("Layout_AddWidget", nargs, 2) ||
+        !Py_ConvertVBoxLayout(args[0], &pyLayout))
+    {
         return NULL;
     }
-    PyVBoxLayout_AddWidget(pyLayout, Py_BuildValue("(O)", pyWidget));
-    Py_RETURN_NONE;
+    return PyVBoxLayout_AddWidget(pyLayout, args + 1, 1);
 }
 
 //----------------------------------------------------------------------------------------
 
-static PyObject* PyWidgets_Label_SetText(PyObject* module, PyObject* args) {
+static PyObject* PyWidgets_Label_SetText(PyObject* module, PyObject* const* args, Py_ssize_t nargs) {
     PyLabel* pyLabel = NULL;
-    const char* text;
-    if (!PyArg_ParseTuple(args, "Os", &pyLabel, &text)) {
+    QString text;
+    if (!PyWidgets_CheckArgsCount("Label_SetText", nargs, 2) ||
+        !Py_ConvertLabel(args[0], &pyLabel) || !PyWidgets_ToQString(args[1], &text))
+    {
         return NULL;
     }
 
@@ -109,10 +236,12 @@ static PyObject* PyWidgets_Label_SetText(PyObject* module, PyObject* args) {
 
 //----------------------------------------------------------------------------------------
 
-static PyObject* PyWidgets_PushButton_SetText(PyObject* module, PyObject* args) {
+static PyObject* PyWidgets_PushButton_SetText(PyObject* module, PyObject* const* args, Py_ssize_t nargs) {
     PyPushButton* pyPushButton = NULL;
-    const char* text;
-    if (!PyArg_ParseTuple(args, "Os", &pyPushButton, &text)) {
+    QString text;
+    if (!PyWidgets_CheckArgsCount("PushButton_SetText", nargs, 2) ||
+        !Py_ConvertPushButton(args[0], &pyPushButton) || !PyWidgets_ToQString(args[1], &text))
+    {
         return NULL;
     }
 
@@ -122,47 +251,393 @@ static PyObject* PyWidgets_PushButton_SetText(PyObject* module, PyObject* args)
 
 //----------------------------------------------------------------------------------------
 
-static PyObject* PyWidgets_Object_GetClassName(PyObject* module, PyObject* args) {
-    PyApplication* pyApp;
-    if (PyArg_ParseTuple(args, "O", &pyApp)) {
-        return PyApplication_GetClassName(pyApp);
+static PyObject* PyWidgets_ListView_New(PyObject* module, PyObject* const* args, Py_ssize_t nargs) {
+    return PyListView_Create(PyWidgets_GetModuleState(module)->types[PyWidgetsTag_ListView].type, args, nargs);
+}
+
+static PyObject* PyWidgets_ListView_SetItems(PyObject* module, PyObject* const* args, Py_ssize_t nargs) {
+    PyListView* pyListView = NULL;
+    if (!PyWidgets_CheckArgsCount("ListView_SetItems", nargs, 2) ||
+        !Py_ConvertListView(args[0], &pyListView))
+    {
+        return NULL;
+    }
+
+    return PyListView_SetItems(pyListView, args + 1, nargs - 1);
+}
+
+static PyObject* PyWidgets_ListView_RowsChanged(PyObject* module, PyObject* const* args, Py_ssize_t nargs) {
+    PyListView* pyListView = NULL;
+    if (!PyWidgets_CheckArgsCount("ListView_RowsChanged", nargs, 3) ||
+        !Py_ConvertListView(args[0], &pyListView))
+    {
+        return NULL;
+    }
+
+    return PyListView_RowsChanged(pyListView, args + 1, nargs - 1);
+}
+
+static PyObject* PyWidgets_ListView_RowsInserted(PyObject* module, PyObject* const* args, Py_ssize_t nargs) {
+    PyListView* pyListView = NULL;
+    if (!PyWidgets_CheckArgsCount("ListView_RowsInserted", nargs, 3) ||
+        !Py_ConvertListView(args[0], &pyListView))
+    {
+        return NULL;
+    }
+
+    return PyListView_RowsInserted(pyListView, args + 1, nargs - 1);
+}
+
+static PyObject* PyWidgets_ListView_RowsRemoved(PyObject* module, PyObject* const* args, Py_ssize_t nargs) {
+    PyListView* pyListView = NULL;
+    if (!PyWidgets_CheckArgsCount("ListView_RowsRemoved", nargs, 3) ||
+        !Py_ConvertListView(args[0], &pyListView))
+    {
+        return NULL;
+    }
+
+    return PyListView_RowsRemoved(pyListView, args + 1, nargs - 1);
+}
+
+static PyObject* PyWidgets_ListView_Reset(PyObject* module, PyObject* const* args, Py_ssize_t nargs) {
+    PyListView* pyListView = NULL;
+    if (!PyWidgets_CheckArgsCount("ListView_Reset", nargs, 1) ||
+        !Py_ConvertListView(args[0], &pyListView))
+    {
+        return NULL;
+    }
+
+    return PyListView_Reset(pyListView);
+}
+
+//----------------------------------------------------------------------------------------
+
+static PyObject* PyWidgets_TableView_New(PyObject* module, PyObject* const* args, Py_ssize_t nargs) {
+    return PyTableView_Create(PyWidgets_GetModuleState(module)->types[PyWidgetsTag_TableView].type, args, nargs);
+}
+
+static PyObject* PyWidgets_TableView_SetColumns(PyObject* module, PyObject* const* args, Py_ssize_t nargs) {
+    PyTableView* pyTableView = NULL;
+    if (!PyWidgets_CheckArgsCount("TableView_SetColumns", nargs, 2) ||
+        !Py_ConvertTableView(args[0], &pyTableView))
+    {
+        return NULL;
+    }
+
+    return PyTableView_SetColumns(pyTableView, args + 1, nargs - 1);
+}
+
+static PyObject* PyWidgets_TableView_Sort(PyObject* module, PyObject* const* args, Py_ssize_t nargs) {
+    PyTableView* pyTableView = NULL;
+    if (nargs != 2 && !PyWidgets_CheckArgsCount("TableView_Sort", nargs, 3)) {
+        return NULL;
+    }
+    if (!Py_ConvertTableView(args[0], &pyTableView)) {
+        return NULL;
+    }
+
+    return PyTableView_Sort(pyTableView, args + 1, nargs - 1);
+}
+
+static PyObject* PyWidgets_TableView_FilterRange(PyObject* module, PyObject* const* args, Py_ssize_t nargs) {
+    PyTableView* pyTableView = NULL;
+    if (!PyWidgets_CheckArgsCount("TableView_FilterRange", nargs, 4) ||
+        !Py_ConvertTableView(args[0], &pyTableView))
+    {
+        return NULL;
+    }
+
+    return PyTableView_FilterRange(pyTableView, args + 1, nargs - 1);
+}
+
+static PyObject* PyWidgets_TableView_FilterContains(PyObject* module, PyObject* const* args, Py_ssize_t nargs) {
+    PyTableView* pyTableView = NULL;
+    if (!PyWidgets_CheckArgsCount("TableView_FilterContains", nargs, 3) ||
+        !Py_ConvertTableView(args[0], &pyTableView))
+    {
+        return NULL;
+    }
+
+    return PyTableView_FilterContains(pyTableView, args + 1, nargs - 1);
+}
+
+static PyObject* PyWidgets_TableView_ClearFilter(PyObject* module, PyObject* const* args, Py_ssize_t nargs) {
+    PyTableView* pyTableView = NULL;
+    if (!PyWidgets_CheckArgsCount("TableView_ClearFilter", nargs, 1) ||
+        !Py_ConvertTableView(args[0], &pyTableView))
+    {
+        return NULL;
+    }
+
+    return PyTableView_ClearFilter(pyTableView);
+}
+
+static PyObject* PyWidgets_TableView_Refresh(PyObject* module, PyObject* const* args, Py_ssize_t nargs) {
+    PyTableView* pyTableView = NULL;
+    if (!PyWidgets_CheckArgsCount("TableView_Refresh", nargs, 1) ||
+        !Py_ConvertTableView(args[0], &pyTableView))
+    {
+        return NULL;
+    }
+
+    return PyTableView_Refresh(pyTableView);
+}
+
+//----------------------------------------------------------------------------------------
+
+static PyObject* PyWidgets_Image_New(PyObject* module, PyObject* const* args, Py_ssize_t nargs) {
+    return PyImage_Create(PyWidgets_GetModuleState(module)->types[PyWidgetsTag_Image].type, args, nargs);
+}
+
+static PyObject* PyWidgets_Image_SetFrame(PyObject* module, PyObject* const* args, Py_ssize_t nargs) {
+    PyImage* pyImage = NULL;
+    if (nargs != 4 && !PyWidgets_CheckArgsCount("Image_SetFrame", nargs, 5)) {
+        return NULL;
+    }
+    if (!Py_ConvertImage(args[0], &pyImage)) {
+        return NULL;
+    }
+
+    return PY_LOCKED_CALL(PyImage_SetFrame)(pyImage, args + 1, nargs - 1);
+}
+
+static PyObject* PyWidgets_Image_GetStats(PyObject* module, PyObject* const* args, Py_ssize_t nargs) {
+    PyImage* pyImage = NULL;
+    if (!PyWidgets_CheckArgsCount("Image_GetStats", nargs, 1) ||
+        !Py_ConvertImage(args[0], &pyImage))
+    {
+        return NULL;
+    }
+
+    return PY_LOCKED_CALL(PyImage_Stats)(pyImage);
+}
+
+//----------------------------------------------------------------------------------------
+
+static PyObject* PyWidgets_Plot_New(PyObject* module, PyObject* const* args, Py_ssize_t nargs) {
+    return PyPlot_Create(PyWidgets_GetModuleState(module)->types[PyWidgetsTag_Plot].type, args, nargs);
+}
+
+static PyObject* PyWidgets_Plot_SetSeries(PyObject* module, PyObject* const* args, Py_ssize_t nargs) {
+    PyPlot* pyPlot = NULL;
+    if (!PyWidgets_CheckArgsCount("Plot_SetSeries", nargs, 2) ||
+        !Py_ConvertPlot(args[0], &pyPlot))
+    {
+        return NULL;
+    }
+
+    return PY_LOCKED_CALL(PyPlot_SetSeries)(pyPlot, args + 1, nargs - 1);
+}
+
+static PyObject* PyWidgets_Plot_Append(PyObject* module, PyObject* const* args, Py_ssize_t nargs) {
+    PyPlot* pyPlot = NULL;
+    if (!PyWidgets_CheckArgsCount("Plot_Append", nargs, 2) ||
+        !Py_ConvertPlot(args[0], &pyPlot))
+    {
+        return NULL;
+    }
+
+    return PY_LOCKED_CALL(PyPlot_Append)(pyPlot, args + 1, nargs - 1);
+}
+
+static PyObject* PyWidgets_Plot_SetCapacity(PyObject* module, PyObject* const* args, Py_ssize_t nargs) {
+    PyPlot* pyPlot = NULL;
+    if (!PyWidgets_CheckArgsCount("Plot_SetCapacity", nargs, 2) ||
+        !Py_ConvertPlot(args[0], &pyPlot))
+    {
+        return NULL;
+    }
+
+    return PY_LOCKED_CALL(PyPlot_SetCapacity)(pyPlot, args + 1, nargs - 1);
+}
+
+static PyObject* PyWidgets_Plot_Clear(PyObject* module, PyObject* const* args, Py_ssize_t nargs) {
+    PyPlot* pyPlot = NULL;
+    if (!PyWidgets_CheckArgsCount("Plot_Clear", nargs, 1) ||
+        !Py_ConvertPlot(args[0], &pyPlot))
+    {
+        return NULL;
+    }
+
+    return PY_LOCKED_CALL(PyPlot_Clear)(pyPlot);
+}
+
+static PyObject* PyWidgets_Plot_GetSize(PyObject* module, PyObject* const* args, Py_ssize_t nargs) {
+    PyPlot* pyPlot = NULL;
+    if (!PyWidgets_CheckArgsCount("Plot_GetSize", nargs, 1) ||
+        !Py_ConvertPlot(args[0], &pyPlot))
+    {
+        return NULL;
+    }
+
+    return PY_LOCKED_CALL(PyPlot_Size)(pyPlot);
+}
+
+//----------------------------------------------------------------------------------------
+
+static PyObject* PyWidgets_LogView_New(PyObject* module, PyObject* const* args, Py_ssize_t nargs) {
+    return PyLogView_Create(PyWidgets_GetModuleState(module)->types[PyWidgetsTag_LogView].type, args, nargs);
+}
+
+static PyObject* PyWidgets_LogView_Append(PyObject* module, PyObject* const* args, Py_ssize_t nargs) {
+    PyLogView* pyLogView = NULL;
+    if (!PyWidgets_CheckArgsCount("LogView_Append", nargs, 2) ||
+        !Py_ConvertLogView(args[0], &pyLogView))
+    {
+        return NULL;
+    }
+
+    return PY_LOCKED_CALL(PyLogView_Append)(pyLogView, args + 1, nargs - 1);
+}
+
+static PyObject* PyWidgets_LogView_AppendMany(PyObject* module, PyObject* const* args, Py_ssize_t nargs) {
+    PyLogView* pyLogView = NULL;
+    if (!PyWidgets_CheckArgsCount("LogView_AppendMany", nargs, 2) ||
+        !Py_ConvertLogView(args[0], &pyLogView))
+    {
+        return NULL;
+    }
+
+    return PY_LOCKED_CALL(PyLogView_AppendMany)(pyLogView, args + 1, nargs - 1);
+}
+
+static PyObject* PyWidgets_LogView_SetMaxLines(PyObject* module, PyObject* const* args, Py_ssize_t nargs) {
+    PyLogView* pyLogView = NULL;
+    if (!PyWidgets_CheckArgsCount("LogView_SetMaxLines", nargs, 2) ||
+        !Py_ConvertLogView(args[0], &pyLogView))
+    {
+        return NULL;
+    }
+
+    return PY_LOCKED_CALL(PyLogView_SetMaxLines)(pyLogView, args + 1, nargs - 1);
+}
+
+static PyObject* PyWidgets_LogView_Clear(PyObject* module, PyObject* const* args, Py_ssize_t nargs) {
+    PyLogView* pyLogView = NULL;
+    if (!PyWidgets_CheckArgsCount("LogView_Clear", nargs, 1) ||
+        !Py_ConvertLogView(args[0], &pyLogView))
+    {
+        return NULL;
+    }
+
+    return PY_LOCKED_CALL(PyLogView_Clear)(pyLogView);
+}
+
+static PyObject* PyWidgets_LogView_GetLineCount(PyObject* module, PyObject* const* args, Py_ssize_t nargs) {
+    PyLogView* pyLogView = NULL;
+    if (!PyWidgets_CheckArgsCount("LogView_GetLineCount", nargs, 1) ||
+        !Py_ConvertLogView(args[0], &pyLogView))
+    {
+        return NULL;
+    }
+
+    return PY_LOCKED_CALL(PyLogView_LineCount)(pyLogView);
+}
+
+//----------------------------------------------------------------------------------------
+
+static PyObject* PyWidgets_Object_GetClassName(PyObject* module, PyObject* const* args, Py_ssize_t nargs) {
+    if (!PyWidgets_CheckArgsCount("Object_GetClassName", nargs, 1)) {
+        return NULL;
     }
-    PyWidget* pyWidget;
-    if (PyArg_ParseTuple(args, "O", &pyWidget)) {
-        return PyWidget_GetClassName(pyWidget);
+    if (!PyObject_TypeCheck(args[0], PyWidgets_GetModuleState(module)->objectType)) {
+        PyErr_Format(PyExc_TypeError, "expected pywidgets.Object, got %.200s", Py_TYPE(args[0])->tp_name);
+        return NULL;
     }
-    PyVBoxLayout* pyVBoxLayout;
-    if (PyArg_ParseTuple(args, "O", &pyVBoxLayout)) {
-        return PyVBoxLayout_GetClassName(pyVBoxLayout);
+    return PyWidgetsObject_GetClassName((PyWidgetsObject*) args[0]);
+}
+
+static PyObject* PyWidgets_Object_GetHandle(PyObject* module, PyObject* const* args, Py_ssize_t nargs) {
+    if (!PyWidgets_CheckArgsCount("Object_GetHandle", nargs, 1)) {
+        return NULL;
     }
-    PyPushButton* pyPushButton;
-    if (PyArg_ParseTuple(args, "O", &pyPushButton)) {
-        return PyPushButton_GetClassName(pyPushButton);
+    return PyWidgetsObject_GetHandle(args[0]);
+}
+
+static PyObject* PyWidgets_Object_Connect(PyObject* module, PyObject* const* args, Py_ssize_t nargs) {
+    if (!PyWidgets_CheckArgsCount("Object_Connect", nargs, 3)) {
+        return NULL;
     }
-    PyLabel* pyLabel;
-    if (PyArg_ParseTuple(args, "O", &pyLabel)) {
-        return PyLabel_GetClassName(pyLabel);
+    return PyWidgetsObject_Connect(args[0], args + 1, nargs - 1);
+}
+
+static PyObject* PyWidgets_Object_GetParent(PyObject* module, PyObject* const* args, Py_ssize_t nargs) {
+    if (!PyWidgets_CheckArgsCount("Object_GetParent", nargs, 1)) {
+        return NULL;
+    }
+    return PyWidgetsObject_GetParent(args[0]);
+}
+
+static PyObject* PyWidgets_Object_GetChildren(PyObject* module, PyObject* const* args, Py_ssize_t nargs) {
+    if (!PyWidgets_CheckArgsCount("Object_GetChildren", nargs, 1)) {
+        return NULL;
     }
-    return NULL;
+    return PyWidgetsObject_GetChildren(args[0]);
 }
 
 //----------------------------------------------------------------------------------------
 
 static PyMethodDef methods[] = {
-    {"Application_New", PyWidgets_Application_New, METH_NOARGS, "Application_New"},
-    {"Application_Exec", PyWidgets_Application_Exec, METH_VARARGS, "Application_Exec"},
-    {"Widget_New", PyWidgets_Widget_New, METH_NOARGS, "Widget_New"},
-    {"VBoxLayout_New", PyWidgets_VBoxLayout_New, METH_VARARGS, "VBoxLayout_New"},
-    {"Label_New", PyWidgets_Label_New, METH_VARARGS, "Label_New"},
-    {"PushButton_New", PyWidgets_PushButton_New, METH_VARARGS, "PushButton_New"},
-    {"Widget_SetWindowTitle", PyWidgets_Widget_SetWindowTitle, METH_VARARGS, "Widget_SetWindowTitle"},
-    {"Widget_SetSize", PyWidgets_Widget_SetSize, METH_VARARGS, "Widget_SetSize"},
-    {"Widget_SetVisible", PyWidgets_Widget_SetVisible, METH_VARARGS, "Widget_SetVisible"},
-    {"Widget_SetLayout", PyWidgets_Widget_SetLayout, METH_VARARGS, "Widget_SetLayout"},
-    {"Layout_AddWidget", PyWidgets_Layout_AddWidget, METH_VARARGS, "Layout_AddWidget"},
-    {"Label_SetText", PyWidgets_Label_SetText, METH_VARARGS, "Label_SetText"},
-    {"PushButton_SetText", PyWidgets_PushButton_SetText, METH_VARARGS, "PushButton_SetText"},
-    {"Object_GetClassName", PyWidgets_Object_GetClassName, METH_VARARGS, "Object_GetClassName"},
+    {"Application_New", PY_GUI_METHOD(PyWidgets_Application_New), METH_NOARGS, "Application_New"},
+    {"Application_Exec", (PyCFunction)PyWidgets_Application_Exec, METH_FASTCALL, "Application_Exec"},
+    {"Application_FlushUpdates", PY_GUI_METHOD(PyWidgets_Application_FlushUpdates), METH_FASTCALL, "Application_FlushUpdates"},
+    {"Application_PostSetText", (PyCFunction)PyWidgets_PostSetText, METH_FASTCALL, "Application_PostSetText"},
+    {"Application_PostSetWindowTitle", (PyCFunction)PyWidgets_PostSetWindowTitle, METH_FASTCALL, "Application_PostSetWindowTitle"},
+    {"Application_PostSetSize", (PyCFunction)PyWidgets_PostSetSize, METH_FASTCALL, "Application_PostSetSize"},
+    {"Application_PostSetVisible", (PyCFunction)PyWidgets_PostSetVisible, METH_FASTCALL, "Application_PostSetVisible"},
+    {"Application_GetUpdateStats", (PyCFunction)PyWidgets_Application_GetUpdateStats, METH_FASTCALL, "Application_GetUpdateStats"},
+    {"Application_NewEventLoop", PY_GUI_METHOD(PyWidgets_Application_NewEventLoop), METH_FASTCALL, "Application_NewEventLoop"},
+    {"Application_Submit", (PyCFunction)(void(*)(void))PyWidgets_Application_Submit, METH_FASTCALL | METH_KEYWORDS, "Application_Submit"},
+    {"Application_GetTaskStats", (PyCFunction)PyWidgets_Application_GetTaskStats, METH_FASTCALL, "Application_GetTaskStats"},
+    {"Application_SetInterval", PY_GUI_METHOD(PyWidgets_Application_SetInterval), METH_FASTCALL, "Application_SetInterval"},
+    {"Application_SetTimeout", PY_GUI_METHOD(PyWidgets_Application_SetTimeout), METH_FASTCALL, "Application_SetTimeout"},
+    {"Application_RequestFrame", PY_GUI_METHOD(PyWidgets_Application_RequestFrame), METH_FASTCALL, "Application_RequestFrame"},
+    {"Application_GetSchedulerStats", PY_GUI_METHOD(PyWidgets_Application_GetSchedulerStats), METH_FASTCALL, "Application_GetSchedulerStats"},
+    {"Widget_New", PY_GUI_METHOD(PyWidgets_Widget_New), METH_NOARGS, "Widget_New"},
+    {"VBoxLayout_New", PY_GUI_METHOD(PyWidgets_VBoxLayout_New), METH_FASTCALL, "VBoxLayout_New"},
+    {"Label_New", PY_GUI_METHOD(PyWidgets_Label_New), METH_FASTCALL, "Label_New"},
+    {"PushButton_New", PY_GUI_METHOD(PyWidgets_PushButton_New), METH_FASTCALL, "PushButton_New"},
+    {"Widget_SetWindowTitle", PY_GUI_METHOD(PyWidgets_Widget_SetWindowTitle), METH_FASTCALL, "Widget_SetWindowTitle"},
+    {"Widget_SetSize", PY_GUI_METHOD(PyWidgets_Widget_SetSize), METH_FASTCALL, "Widget_SetSize"},
+    {"Widget_SetVisible", PY_GUI_METHOD(PyWidgets_Widget_SetVisible), METH_FASTCALL, "Widget_SetVisible"},
+    {"Widget_SetLayout", PY_GUI_METHOD(PyWidgets_Widget_SetLayout), METH_FASTCALL, "Widget_SetLayout"},
+    {"Widget_ApplyState", PY_GUI_METHOD(PyWidgets_Widget_ApplyState), METH_FASTCALL, "Widget_ApplyState"},
+    {"Layout_AddWidget", PY_GUI_METHOD(PyWidgets_Layout_AddWidget), METH_FASTCALL, "Layout_AddWidget"},
+    {"Label_SetText", PY_GUI_METHOD(PyWidgets_Label_SetText), METH_FASTCALL, "Label_SetText"},
+    {"PushButton_SetText", PY_GUI_METHOD(PyWidgets_PushButton_SetText), METH_FASTCALL, "PushButton_SetText"},
+    {"ListView_New", PY_GUI_METHOD(PyWidgets_ListView_New), METH_FASTCALL, "ListView_New"},
+    {"ListView_SetItems", PY_GUI_METHOD(PyWidgets_ListView_SetItems), METH_FASTCALL, "ListView_SetItems"},
+    {"ListView_RowsChanged", PY_GUI_METHOD(PyWidgets_ListView_RowsChanged), METH_FASTCALL, "ListView_RowsChanged"},
+    {"ListView_RowsInserted", PY_GUI_METHOD(PyWidgets_ListView_RowsInserted), METH_FASTCALL, "ListView_RowsInserted"},
+    {"ListView_RowsRemoved", PY_GUI_METHOD(PyWidgets_ListView_RowsRemoved), METH_FASTCALL, "ListView_RowsRemoved"},
+    {"ListView_Reset", PY_GUI_METHOD(PyWidgets_ListView_Reset), METH_FASTCALL, "ListView_Reset"},
+    {"TableView_New", PY_GUI_METHOD(PyWidgets_TableView_New), METH_FASTCALL, "TableView_New"},
+    {"TableView_SetColumns", PY_GUI_METHOD(PyWidgets_TableView_SetColumns), METH_FASTCALL, "TableView_SetColumns"},
+    {"TableView_Sort", PY_GUI_METHOD(PyWidgets_TableView_Sort), METH_FASTCALL, "TableView_Sort"},
+    {"TableView_FilterRange", PY_GUI_METHOD(PyWidgets_TableView_FilterRange), METH_FASTCALL, "TableView_FilterRange"},
+    {"TableView_FilterContains", PY_GUI_METHOD(PyWidgets_TableView_FilterContains), METH_FASTCALL, "TableView_FilterContains"},
+    {"TableView_ClearFilter", PY_GUI_METHOD(PyWidgets_TableView_ClearFilter), METH_FASTCALL, "TableView_ClearFilter"},
+    {"TableView_Refresh", PY_GUI_METHOD(PyWidgets_TableView_Refresh), METH_FASTCALL, "TableView_Refresh"},
+    {"Image_New", PY_GUI_METHOD(PyWidgets_Image_New), METH_FASTCALL, "Image_New"},
+    {"Image_SetFrame", (PyCFunction)PyWidgets_Image_SetFrame, METH_FASTCALL, "Image_SetFrame"},
+    {"Image_GetStats", (PyCFunction)PyWidgets_Image_GetStats, METH_FASTCALL, "Image_GetStats"},
+    {"Plot_New", PY_GUI_METHOD(PyWidgets_Plot_New), METH_FASTCALL, "Plot_New"},
+    {"Plot_SetSeries", (PyCFunction)PyWidgets_Plot_SetSeries, METH_FASTCALL, "Plot_SetSeries"},
+    {"Plot_Append", (PyCFunction)PyWidgets_Plot_Append, METH_FASTCALL, "Plot_Append"},
+    {"Plot_SetCapacity", (PyCFunction)PyWidgets_Plot_SetCapacity, METH_FASTCALL, "Plot_SetCapacity"},
+    {"Plot_Clear", (PyCFunction)PyWidgets_Plot_Clear, METH_FASTCALL, "Plot_Clear"},
+    {"Plot_GetSize", (PyCFunction)PyWidgets_Plot_GetSize, METH_FASTCALL, "Plot_GetSize"},
+    {"LogView_New", PY_GUI_METHOD(PyWidgets_LogView_New), METH_FASTCALL, "LogView_New"},
+    {"LogView_Append", (PyCFunction)PyWidgets_LogView_Append, METH_FASTCALL, "LogView_Append"},
+    {"LogView_AppendMany", (PyCFunction)PyWidgets_LogView_AppendMany, METH_FASTCALL, "LogView_AppendMany"},
+    {"LogView_SetMaxLines", (PyCFunction)PyWidgets_LogView_SetMaxLines, METH_FASTCALL, "LogView_SetMaxLines"},
+    {"LogView_Clear", (PyCFunction)PyWidgets_LogView_Clear, METH_FASTCALL, "LogView_Clear"},
+    {"LogView_GetLineCount", (PyCFunction)PyWidgets_LogView_GetLineCount, METH_FASTCALL, "LogView_GetLineCount"},
+    {"Object_GetClassName", (PyCFunction)PyWidgets_Object_GetClassName, METH_FASTCALL, "Object_GetClassName"},
+    {"Object_GetHandle", PY_GUI_METHOD(PyWidgets_Object_GetHandle), METH_FASTCALL, "Object_GetHandle"},
+    {"Object_Connect", PY_GUI_METHOD(PyWidgets_Object_Connect), METH_FASTCALL, "Object_Connect"},
+    {"Object_GetParent", PY_GUI_METHOD(PyWidgets_Object_GetParent), METH_FASTCALL, "Object_GetParent"},
+    {"Object_GetChildren", PY_GUI_METHOD(PyWidgets_Object_GetChildren), METH_FASTCALL, "Object_GetChildren"},
     {NULL, NULL, 0, NULL}
 };
 
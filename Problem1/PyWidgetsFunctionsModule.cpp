@@ -2,7 +2,10 @@
  * Модуль, предоставляющий функциональное API к библиотеке
  */
 
+#define PY_WIDGETS_MODULE_NAME "_pywidgets"
+
 #include "PyWidgetsFunctions.h"
+#include "PyWidgetsModuleInit.h"
 
 extern PyMethodDef methods[];
 
@@ -11,22 +14,15 @@ extern PyMethodDef methods[];
 PyMODINIT_FUNC PyInit__pywidgets() {
     static PyModuleDef modDef = {
         PyModuleDef_HEAD_INIT,
-        "_pywidgets",
+        PY_WIDGETS_MODULE_NAME,
         "Qt-widgets module",
-        -1,
-        methods
+        sizeof(PyWidgetsModuleState),
+        methods,
+        PyWidgets_ModuleSlots,
+        PyWidgets_TraverseModule,
+        PyWidgets_ClearModule,
+        PyWidgets_FreeModule
     };
 
-    PyObject* module = PyModule_Create(&modDef);
-    if (module == NULL) {
-        return NULL;
-    }
-
-    REGISTER_TYPE(module, Application);
-    REGISTER_TYPE(module, Widget);
-    REGISTER_TYPE(module, Label);
-    REGISTER_TYPE(module, VBoxLayout);
-    REGISTER_TYPE(module, PushButton);
-
-    return module;
+    return PyModuleDef_Init(&modDef);
 }
@@ -0,0 +1,197 @@
+/*
+ * Источники строк ListView над объектами Python
+ */
+
+#ifndef PY_WIDGETS_LIST_SOURCE_H
+#define PY_WIDGETS_LIST_SOURCE_H
+
+#include <Python.h>
+#include <climits>
+#include <cstring>
+#include "widgets.h"
+#include "PyWidgetsArgs.h"
+
+// Строки читаются в GUI-потоке, в том числе из цикла событий без GIL, поэтому
+//  все обращения к объектам Python берут его сами
+
+static int PyWidgets_ClampRowCount(Py_ssize_t size) {
+    return (size > INT_MAX) ? INT_MAX : (int)size;
+}
+
+// Для str вызов str() не нужен, а текст берется прямо из представления строки
+static QString PyWidgets_ItemToQString(PyObject* item) {
+    PyObject* str = PyUnicode_CheckExact(item) ? (Py_INCREF(item), item) : PyObject_Str(item);
+    if (str == NULL) {
+        return QString();
+    }
+    QString text;
+    PyWidgets_UnicodeToQString(str, &text);
+    Py_DECREF(str);
+    return text;
+}
+
+// Строка i - str(sequence[i]). Последовательность хранится по ссылке, поэтому ее
+//  изменения видны сразу, а число строк модель узнает из уведомлений
+class PySequenceListSource : public ListSource {
+public:
+    // Забирает ссылку на sequence
+    explicit PySequenceListSource(PyObject* _sequence) : sequence(_sequence) {}
+
+    ~PySequenceListSource() override {
+        PyGILState_STATE gil = PyGILState_Ensure();
+        Py_DECREF(sequence);
+        PyGILState_Release(gil);
+    }
+
+    int GetRowCount() override {
+        PyGILState_STATE gil = PyGILState_Ensure();
+        Py_ssize_t size = PySequence_Size(sequence);
+        if (size < 0) {
+            PyErr_Print();
+            size = 0;
+        }
+        PyGILState_Release(gil);
+        return PyWidgets_ClampRowCount(size);
+    }
+
+    QString GetRowText(int row) override {
+        PyGILState_STATE gil = PyGILState_Ensure();
+        QString text;
+        PyObject* item = PySequence_GetItem(sequence, row);
+        if (item != NULL) {
+            text = PyWidgets_ItemToQString(item);
+            Py_DECREF(item);
+        }
+        if (PyErr_Occurred()) {
+            // Последовательность укоротилась, а уведомления еще не было - строка пустая
+            if (PyErr_ExceptionMatches(PyExc_IndexError)) {
+                PyErr_Clear();
+            } else {
+                PyErr_Print();
+            }
+        }
+        PyGILState_Release(gil);
+        return text;
+    }
+
+private:
+    PyObject* sequence;
+};
+
+typedef QString (*PyWidgetsItemFormatter)(const char* item);
+
+template <typename T, typename Number>
+static QString PyWidgets_FormatItem(const char* item) {
+    T value;
+    memcpy(&value, item, sizeof(T));
+    return QString::number((Number)value);
+}
+
+// Форматтер для кода формата struct с нативным порядком байтов или NULL
+static PyWidgetsItemFormatter PyWidgets_GetItemFormatter(const char* format, Py_ssize_t itemSize) {
+    if (format == NULL) {
+        format = "B";
+    }
+    if (format[0] == '@') {
+        ++format;
+    }
+    if (format[0] == '\0' || format[1] != '\0') {
+        return NULL;
+    }
+    PyWidgetsItemFormatter formatter = NULL;
+    Py_ssize_t size = 0;
+    switch (format[0]) {
+#define PY_WIDGETS_ITEM_FORMAT(code, T, Number) \
+    case code: \
+        formatter = PyWidgets_FormatItem<T, Number>; \
+        size = sizeof(T); \
+        break;
+    PY_WIDGETS_ITEM_FORMAT('b', signed char, int)
+    PY_WIDGETS_ITEM_FORMAT('B', unsigned char, unsigned int)
+    PY_WIDGETS_ITEM_FORMAT('?', bool, int)
+    PY_WIDGETS_ITEM_FORMAT('h', short, int)
+    PY_WIDGETS_ITEM_FORMAT('H', unsigned short, unsigned int)
+    PY_WIDGETS_ITEM_FORMAT('i', int, int)
+    PY_WIDGETS_ITEM_FORMAT('I', unsigned int, unsigned int)
+    PY_WIDGETS_ITEM_FORMAT('l', long, qlonglong)
+    PY_WIDGETS_ITEM_FORMAT('L', unsigned long, qulonglong)
+    PY_WIDGETS_ITEM_FORMAT('q', long long, qlonglong)
+    PY_WIDGETS_ITEM_FORMAT('Q', unsigned long long, qulonglong)
+    PY_WIDGETS_ITEM_FORMAT('n', Py_ssize_t, qlonglong)
+    PY_WIDGETS_ITEM_FORMAT('N', size_t, qulonglong)
+    PY_WIDGETS_ITEM_FORMAT('f', float, double)
+    PY_WIDGETS_ITEM_FORMAT('d', double, double)
+#undef PY_WIDGETS_ITEM_FORMAT
+    default:
+        return NULL;
+    }
+    return (size == itemSize) ? formatter : NULL;
+}
+
+// Строки - числа одномерного буфера (array.array, numpy.ndarray и т.п.), читаемые прямо
+//  из его памяти без GIL и без копирования. Пока буфер захвачен, экспортер не может
+//  перевыделить память, поэтому, например, array.array нельзя и удлинить
+class PyBufferListSource : public ListSource {
+public:
+    PyBufferListSource() : formatter(NULL) {
+        view.obj = NULL;
+    }
+
+    ~PyBufferListSource() override {
+        PyGILState_STATE gil = PyGILState_Ensure();
+        PyBuffer_Release(&view);
+        PyGILState_Release(gil);
+    }
+
+    // Захватывает буфер items; при ошибке выставляет исключение и возвращает false.
+    //  view не копируется: shape и strides могут указывать внутрь него самого
+    bool Acquire(PyObject* items) {
+        if (PyObject_GetBuffer(items, &view, PyBUF_RECORDS_RO) < 0) {
+            return false;
+        }
+        formatter = PyWidgets_GetItemFormatter(view.format, view.itemsize);
+        if (view.ndim != 1 || formatter == NULL) {
+            PyErr_Format(PyExc_TypeError,
+                "expected one-dimensional buffer of numbers, got format '%.20s' with %d dimensions",
+                view.format != NULL ? view.format : "B", view.ndim);
+            return false;
+        }
+        return true;
+    }
+
+    int GetRowCount() override {
+        return PyWidgets_ClampRowCount(view.shape[0]);
+    }
+
+    QString GetRowText(int row) override {
+        if (row >= view.shape[0]) {
+            return QString();
+        }
+        return formatter((const char*)view.buf + row * view.strides[0]);
+    }
+
+private:
+    Py_buffer view;
+    PyWidgetsItemFormatter formatter;
+};
+
+// Источник над объектом с протоколом буфера или над последовательностью.
+//  Строки (str) - тоже последовательности, но списком символов их не показываем
+static ListSource* PyWidgets_NewListSource(PyObject* items) {
+    if (PyObject_CheckBuffer(items)) {
+        PyBufferListSource* source = new PyBufferListSource();
+        if (!source->Acquire(items)) {
+            delete source;
+            return NULL;
+        }
+        return source;
+    }
+    if (PyUnicode_Check(items) || !PySequence_Check(items)) {
+        PyErr_Format(PyExc_TypeError, "expected sequence or buffer, got %.200s", Py_TYPE(items)->tp_name);
+        return NULL;
+    }
+    Py_INCREF(items);
+    return new PySequenceListSource(items);
+}
+
+#endif // PY_WIDGETS_LIST_SOURCE_H
@@ -5,64 +5,298 @@
 #ifndef PY_WIDGETS_MACROSES_H
 #define PY_WIDGETS_MACROSES_H
 
-#define PY_CLASS_WRAPPER(ClassName, methods, new_method) \
+// Сколько освобожденных оберток каждого типа держать для повторного использования
+#define PY_WIDGETS_FREELIST_SIZE 256
+
+// create_method имеет сигнатуру
+//  PyObject* (PyTypeObject* type, PyObject* const* args, Py_ssize_t nargs)
+//  и используется как из tp_new (для наследников), так и из tp_vectorcall.
+// Объект обертки должен создаваться через Py_Alloc##ClassName, чтобы в нем был выставлен тег
+//  и работал список свободных оберток, а объект библиотеки привязываться через Py_Bind##ClassName.
+// Владение: обертка удаляет объект библиотеки, только если у того нет родителя Qt.
+//  Если объект удален раньше обертки, Py_Destroyed##ClassName обнуляет pImpl.
+// Объект хранит невладеющий указатель на свою обертку (Object_GetBinding), поэтому
+//  у объекта не больше одной обертки и Py_Wrap##ClassName находит ее за O(1). В 3.13t
+//  привязка держит ссылку на обертку (PY_WIDGETS_BINDING_HOLDS_REF).
+// pImpl пишут Py_Bind##ClassName и Py_Destroyed##ClassName в GUI-потоке и Py_Unbind##ClassName
+//  из Py_Dealloc##ClassName в потоке, отпустившем последнюю ссылку, когда других ссылок на
+//  обертку уже нет (в 3.13t - и из Py_Clear##ClassName в потоке сборщика мусора). Поэтому
+//  методы, выполняемые в GUI-потоке (PY_GUI_METHOD), читают pImpl напрямую, а из других
+//  потоков - через Py_GetImpl##ClassName или Py_Convert##ClassName. Методы, которые работают
+//  с объектом в вызвавшем потоке (PY_LOCKED_METHOD у Image, Plot и LogView), держат GIL или
+//  критическую секцию обертки, которую Py_Destroyed##ClassName ждет: эти классы вызывают
+//  его в начале своего деструктора, и объект не разрушается посреди вызова
+#define PY_CLASS_WRAPPER(ClassName, methods, create_method) \
 struct Py##ClassName { \
     PyObject_HEAD \
+    /* общее начало с PyWidgetsObject */ \
+    PyWidgetsTypeTag tag; \
+    bool isKeptAlive; \
+    PyObject* callbacks; \
+    PyObject* weakreflist; \
+    uint64_t handle; \
     ClassName* pImpl; \
 }; \
  \
+static void* Py_GetImpl##ClassName(PyObject* self) { \
+    void* impl; \
+    PY_WIDGETS_BEGIN_CRITICAL_SECTION(self); \
+    impl = ((Py##ClassName*)self)->pImpl; \
+    PY_WIDGETS_END_CRITICAL_SECTION(); \
+    return impl; \
+} \
+ \
+static Object* Py_AsObject##ClassName(void* impl) { \
+    return (ClassName*)impl; \
+} \
+ \
+static QWidget* Py_AsQWidget##ClassName(void* impl) { \
+    return PyWidgets_AsQWidget((ClassName*)impl); \
+} \
+ \
+/* Object - виртуальная база, поэтому вниз только через dynamic_cast */ \
+static void* Py_FromObject##ClassName(Object* object) { \
+    return dynamic_cast<ClassName*>(object); \
+} \
+ \
+static void Py_Dealloc##ClassName(Py##ClassName* self); \
+static Py##ClassName* Py_Alloc##ClassName(PyTypeObject* type); \
+static void Py_Unbind##ClassName(Py##ClassName* self); \
+ \
+/* Экземпляр держит ссылку на свой тип: тип создан в куче */ \
+static int Py_Traverse##ClassName(Py##ClassName* self, visitproc visit, void* arg) { \
+    Py_VISIT(Py_TYPE(self)); \
+    Py_VISIT(self->callbacks); \
+    if (self->pImpl == NULL) { \
+        return 0; \
+    } \
+    return PyWidgets_VisitOwnedWrappers((PyWidgetsObject*)self, self->pImpl, visit, arg); \
+} \
+ \
+static int Py_Clear##ClassName(Py##ClassName* self) { \
+    PyObject* callbacks; \
+    PY_WIDGETS_BEGIN_CRITICAL_SECTION(self); \
+    callbacks = self->callbacks; \
+    self->callbacks = NULL; \
+    PY_WIDGETS_END_CRITICAL_SECTION(); \
+    Py_XDECREF(callbacks); \
+    /* В 3.13t ссылку держит и привязка: отвязываем до ее снятия, чтобы другой поток */ \
+    /*  не нашел обертку с нулевым счетчиком */ \
+    if (PY_WIDGETS_BINDING_HOLDS_REF) { \
+        Py_Unbind##ClassName(self); \
+    } \
+    PyWidgets_ReleaseKeepAlive((PyWidgetsObject*)self); \
+    return 0; \
+} \
+ \
+static PyObject* Py_New##ClassName(PyTypeObject* type, PyObject* args, PyObject* kwds) { \
+    if (!PyWidgets_CheckNoKwargs(#ClassName, kwds != NULL ? PyDict_GET_SIZE(kwds) : 0)) { \
+        return NULL; \
+    } \
+    return PyWidgets_CallInGuiThread([type, args]() { \
+        return create_method(type, &PyTuple_GET_ITEM(args, 0), PyTuple_GET_SIZE(args)); \
+    }); \
+} \
+ \
+static PyObject* Py_Vectorcall##ClassName(PyObject* type, PyObject* const* args, \
+    size_t nargsf, PyObject* kwnames) \
+{ \
+    if (!PyWidgets_CheckNoKwargs(#ClassName, kwnames != NULL ? PyTuple_GET_SIZE(kwnames) : 0)) { \
+        return NULL; \
+    } \
+    return PyWidgets_CallInGuiThread([type, args, nargsf]() { \
+        return create_method((PyTypeObject*)type, args, PyVectorcall_NARGS(nargsf)); \
+    }); \
+} \
+ \
+static PyType_Slot Py_Slots##ClassName[] = { \
+    {Py_tp_dealloc, (void*)Py_Dealloc##ClassName}, \
+    {Py_tp_traverse, (void*)Py_Traverse##ClassName}, \
+    {Py_tp_clear, (void*)Py_Clear##ClassName}, \
+    {Py_tp_methods, (void*)methods}, \
+    {Py_tp_new, (void*)Py_New##ClassName}, \
+    {Py_tp_doc, (void*)#ClassName" object"}, \
+    {0, NULL} \
+}; \
+ \
+/* База pywidgets.Object и tp_vectorcall задаются в REGISTER_TYPE */ \
+static PyType_Spec Py_Spec##ClassName = { \
+    "pywidgets."#ClassName, \
+    sizeof(Py##ClassName), \
+    0, \
+    Py_TPFLAGS_DEFAULT | Py_TPFLAGS_BASETYPE | Py_TPFLAGS_HAVE_GC | PY_WIDGETS_TPFLAGS_IMMUTABLE, \
+    Py_Slots##ClassName \
+}; \
+ \
+static Py##ClassName* Py_Alloc##ClassName(PyTypeObject* type) { \
+    if (!PyWidgets_CheckMainInterpreter(#ClassName)) { \
+        return NULL; \
+    } \
+    const int tag = PyWidgetsTag_##ClassName; \
+    PyWidgetsModuleState* state = PyWidgets_FindState(); \
+    Py##ClassName* self; \
+    /* Списки свободных оберток не синхронизированы, поэтому без GIL не ведутся */ \
+    if (!PY_WIDGETS_FREE_THREADED && state != NULL && type == state->types[tag].type && state->freeCount[tag] > 0) { \
+        self = (Py##ClassName*)state->freeList[tag][--state->freeCount[tag]]; \
+        /* Снова берет ссылку на тип, отпущенную в Py_Dealloc##ClassName */ \
+        PyObject_Init((PyObject*)self, type); \
+        self->isKeptAlive = false; \
+        self->callbacks = NULL; \
+        self->weakreflist = NULL; \
+        self->handle = 0; \
+        self->pImpl = NULL; \
+        PyObject_GC_Track(self); \
+    } else { \
+        self = (Py##ClassName*)type->tp_alloc(type, 0); \
+    } \
+    if (self != NULL) { \
+        self->tag = PyWidgetsTag_##ClassName; \
+        PyWidgets_EnableTryIncRef((PyObject*)self); \
+    } \
+    return self; \
+} \
+ \
+/* Вызывается из деструктора объекта библиотеки, в том числе без GIL из цикла событий */ \
+static void Py_Destroyed##ClassName(Object* object) { \
+    PyGILState_STATE gil = PyGILState_Ensure(); \
+    /* Обертку читаем под GIL и PyWidgets_LockBindings: она могла отвязаться, пока мы их ждали. */ \
+    /*  Ссылку, которой объект держал обертку, отпускаем после: иначе освобождение */ \
+    /*  обертки взяло бы мьютекс повторно */ \
+    bool wasKeptAlive = false; \
+    PyWidgets_LockBindings(); \
+    Py##ClassName* self = (Py##ClassName*)Object_GetBinding(object); \
+    if (self != NULL) { \
+        Object_SetBinding(object, NULL, NULL); \
+        PY_WIDGETS_BEGIN_CRITICAL_SECTION(self); \
+        self->pImpl = NULL; \
+        wasKeptAlive = self->isKeptAlive; \
+        self->isKeptAlive = false; \
+        PY_WIDGETS_END_CRITICAL_SECTION(); \
+    } \
+    PyWidgets_UnlockBindings(); \
+    if (wasKeptAlive) { \
+        Py_DECREF(self); \
+    } \
+    PyGILState_Release(gil); \
+} \
+ \
+/* Вызывается в GUI-потоке. Без GIL другие потоки ставят обновления объекту по handle */ \
+/*  (см. PyApplication_IsUpdateByHandle), поэтому он выдается сразу */ \
+static void Py_Bind##ClassName(Py##ClassName* self, ClassName* impl) { \
+    PyWidgets_LockBindings(); \
+    PY_WIDGETS_BEGIN_CRITICAL_SECTION(self); \
+    self->pImpl = impl; \
+    if (PY_WIDGETS_BINDING_HOLDS_REF && !self->isKeptAlive) { \
+        self->isKeptAlive = true; \
+        Py_INCREF(self); \
+    } \
+    PY_WIDGETS_END_CRITICAL_SECTION(); \
+    Object_SetBinding(impl, self, Py_Destroyed##ClassName); \
+    PyWidgets_UnlockBindings(); \
+    if (PY_WIDGETS_FREE_THREADED) { \
+        self->handle = Object_GetHandle(impl); \
+    } \
+} \
+ \
+/* Отвязка под мьютексом: GUI-поток может в это же время удалять объект. Без GIL объект */ \
+/*  мог, пока мы ждали, получить новую обертку (PyWidgets_GetBoundWrapper) - она им */ \
+/*  и владеет */ \
+static void Py_Unbind##ClassName(Py##ClassName* self) { \
+    PyWidgets_LockBindings(); \
+    ClassName* impl = self->pImpl; \
+    if (impl != NULL && Object_GetBinding(impl) != self) { \
+        impl = NULL; \
+    } else if (impl != NULL) { \
+        Object_SetBinding(impl, NULL, NULL); \
+    } \
+    PY_WIDGETS_BEGIN_CRITICAL_SECTION(self); \
+    self->pImpl = NULL; \
+    PY_WIDGETS_END_CRITICAL_SECTION(); \
+    PyWidgets_UnlockBindings(); \
+    /* Объектом с родителем владеет Qt. Обертка может умереть в рабочем потоке, */ \
+    /*  пока цикл событий работает без GIL, тогда удаление откладывается */ \
+    if (impl != NULL && !Object_HasParent(impl)) { \
+        Object_Release(impl); \
+    } \
+} \
+ \
 static void Py_Dealloc##ClassName(Py##ClassName* self) { \
-    delete self->pImpl; \
-    Py_TYPE(self)->tp_free((PyObject*)self); \
+    PyTypeObject* type = Py_TYPE(self); \
+    PyObject_GC_UnTrack(self); \
+    if (self->weakreflist != NULL) { \
+        PyObject_ClearWeakRefs((PyObject*)self); \
+    } \
+    Py_Unbind##ClassName(self); \
+    Py_CLEAR(self->callbacks); \
+    /* Наследники из Python освобождаются как обычно: у них свой размер и тип */ \
+    const int tag = PyWidgetsTag_##ClassName; \
+    PyWidgetsModuleState* state = PyWidgets_FindState(); \
+    if (!PY_WIDGETS_FREE_THREADED && state != NULL && type == state->types[tag].type && \
+        state->freeCount[tag] < PY_WIDGETS_FREELIST_SIZE) \
+    { \
+        state->freeList[tag][state->freeCount[tag]++] = (PyObject*)self; \
+    } else { \
+        type->tp_free((PyObject*)self); \
+    } \
+    /* Ссылку на тип держит и экземпляр наследника: subtype_dealloc ее не отпускает, */ \
+    /*  когда база - тип из кучи */ \
+    Py_DECREF(type); \
 } \
  \
-static PyTypeObject Py_Type##ClassName = { \
-    PyVarObject_HEAD_INIT(NULL, 0) \
-    "pywidgets."#ClassName,            /* tp_name */ \
-    sizeof(Py##ClassName),             /* tp_basicsize */ \
-    0,                                 /* tp_itemsize */ \
-    (destructor)Py_Dealloc##ClassName, /* tp_dealloc */ \
-    0,                                 /* tp_print */ \
-    0,                                 /* tp_getattr */ \
-    0,                                 /* tp_setattr */ \
-    0,                                 /* tp_reserved */ \
-    0,                                 /* tp_repr */ \
-    0,                                 /* tp_as_number */ \
-    0,                                 /* tp_as_sequence */ \
-    0,                                 /* tp_as_mapping */ \
-    0,                                 /* tp_hash  */ \
-    0,                                 /* tp_call */ \
-    0,                                 /* tp_str */ \
-    0,                                 /* tp_getattro */ \
-    0,                                 /* tp_setattro */ \
-    0,                                 /* tp_as_buffer */ \
-    Py_TPFLAGS_DEFAULT | \
-        Py_TPFLAGS_BASETYPE,           /* tp_flags */ \
-    #ClassName" object",               /* tp_doc */ \
-    0,                                 /* tp_traverse */ \
-    0,                                 /* tp_clear */ \
-    0,                                 /* tp_richcompare */ \
-    0,                                 /* tp_weaklistoffset */ \
-    0,                                 /* tp_iter */ \
-    0,                                 /* tp_iternext */ \
-    methods,                           /* tp_methods */ \
-    NULL,                              /* tp_members */ \
-    0,                                 /* tp_getset */ \
-    0,                                 /* tp_base */ \
-    0,                                 /* tp_dict */ \
-    0,                                 /* tp_descr_get */ \
-    0,                                 /* tp_descr_set */ \
-    0,                                 /* tp_dictoffset */ \
-    NULL,                              /* tp_init */ \
-    0,                                 /* tp_alloc */ \
-    new_method,                        /* tp_new */ \
-};
-
-#define REGISTER_TYPE(module, ClassName) \
-if (PyType_Ready(&Py_Type##ClassName) < 0) { \
-    return NULL; \
+/* Обертка над уже существующим объектом библиотеки: привязанная к нему или новая */ \
+static PyObject* Py_Wrap##ClassName(void* impl) { \
+    PyObject* existing = PyWidgets_GetBoundWrapper((ClassName*)impl); \
+    if (existing != NULL) { \
+        return existing; \
+    } \
+    PyWidgetsModuleState* state = PyWidgets_GetState(); \
+    if (state == NULL) { \
+        return NULL; \
+    } \
+    Py##ClassName* self = Py_Alloc##ClassName(state->types[PyWidgetsTag_##ClassName].type); \
+    if (self != NULL) { \
+        Py_Bind##ClassName(self, (ClassName*)impl); \
+    } \
+    return (PyObject*)self; \
 } \
-Py_INCREF(&Py_Type##ClassName); \
-PyModule_AddObject(module, #ClassName, (PyObject*)&Py_Type##ClassName);
+ \
+static int Py_Convert##ClassName(PyObject* obj, Py##ClassName** result) { \
+    PyWidgetsModuleState* state = PyWidgets_FindState(); \
+    if (state == NULL || !PyObject_TypeCheck(obj, state->types[PyWidgetsTag_##ClassName].type)) { \
+        PyErr_Format(PyExc_TypeError, "expected pywidgets."#ClassName", got %.200s", \
+            Py_TYPE(obj)->tp_name); \
+        return 0; \
+    } \
+    if (!PyWidgets_CheckAlive(Py_GetImpl##ClassName(obj))) { \
+        return 0; \
+    } \
+    *result = (Py##ClassName*)obj; \
+    return 1; \
+}
+
+// Создает тип модуля по спецификации Py_Spec##ClassName и добавляет его в модуль.
+//  Ссылку из PyType_FromModuleAndSpec хранит result в состоянии модуля
+#define ADD_TYPE(module, ClassName, result, base) \
+result = (PyTypeObject*)PyType_FromModuleAndSpec(module, &Py_Spec##ClassName, (PyObject*)(base)); \
+if (result == NULL || PyModule_AddType(module, result) < 0) { \
+    return -1; \
+}
+
+// Добавляет тип обертки в модуль и в таблицу типов состояния под его тегом
+#define REGISTER_TYPE(module, state, ClassName) \
+ADD_TYPE(module, ClassName, state->types[PyWidgetsTag_##ClassName].type, state->objectType) \
+/* Слота для tp_vectorcall в спецификации нет */ \
+state->types[PyWidgetsTag_##ClassName].type->tp_vectorcall = Py_Vectorcall##ClassName; \
+state->types[PyWidgetsTag_##ClassName].getImpl = Py_GetImpl##ClassName; \
+state->types[PyWidgetsTag_##ClassName].asObject = Py_AsObject##ClassName; \
+state->types[PyWidgetsTag_##ClassName].asQWidget = Py_AsQWidget##ClassName; \
+state->types[PyWidgetsTag_##ClassName].fromObject = Py_FromObject##ClassName; \
+state->types[PyWidgetsTag_##ClassName].wrap = Py_Wrap##ClassName; \
+state->types[PyWidgetsTag_##ClassName].typeName = ClassName::TypeName; \
+state->types[PyWidgetsTag_##ClassName].isWidget = std::is_base_of<QWidget, ClassName>::value; \
+state->types[PyWidgetsTag_##ClassName].className = PyUnicode_InternFromString(ClassName::TypeName); \
+if (state->types[PyWidgetsTag_##ClassName].className == NULL) { \
+    return -1; \
+}
 
 #endif // PY_WIDGETS_MACROSES_H
@@ -2,29 +2,36 @@
  * Модуль, предоставляющий ООП API к библиотеке
  */
 
-#include "PyWidgetsClasses.h"
+#define PY_WIDGETS_MODULE_NAME "pywidgets"
+
+#include "PyWidgetsModuleInit.h"
+
+static PyMethodDef methods[] = {
+    {"post_set_text", (PyCFunction)PyWidgets_PostSetText, METH_FASTCALL,
+        "Application.post_set_text without an Application: objects are given by handle from any interpreter"},
+    {"post_set_window_title", (PyCFunction)PyWidgets_PostSetWindowTitle, METH_FASTCALL,
+        "Application.post_set_window_title without an Application: objects are given by handle from any interpreter"},
+    {"post_set_size", (PyCFunction)PyWidgets_PostSetSize, METH_FASTCALL,
+        "Application.post_set_size without an Application: objects are given by handle from any interpreter"},
+    {"post_set_visible", (PyCFunction)PyWidgets_PostSetVisible, METH_FASTCALL,
+        "Application.post_set_visible without an Application: objects are given by handle from any interpreter"},
+    {NULL, NULL, 0, NULL}
+};
 
 //--------------------------------------------------------------------------
 
 PyMODINIT_FUNC PyInit_pywidgets() {
     static PyModuleDef modDef = {
         PyModuleDef_HEAD_INIT,
-        "pywidgets",
+        PY_WIDGETS_MODULE_NAME,
         "Qt-widgets module",
-        -1,
-        NULL,
+        sizeof(PyWidgetsModuleState),
+        methods,
+        PyWidgets_ModuleSlots,
+        PyWidgets_TraverseModule,
+        PyWidgets_ClearModule,
+        PyWidgets_FreeModule
     };
 
-    PyObject* module = PyModule_Create(&modDef);
-    if (module == NULL) {
-        return NULL;
-    }
-
-    REGISTER_TYPE(module, Application);
-    REGISTER_TYPE(module, Widget);
-    REGISTER_TYPE(module, Label);
-    REGISTER_TYPE(module, VBoxLayout);
-    REGISTER_TYPE(module, PushButton);
-
-    return module;
+    return PyModuleDef_Init(&modDef);
 }
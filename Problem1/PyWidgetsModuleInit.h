@@ -0,0 +1,138 @@
+/*
+ * Многофазная инициализация модулей: типы создаются из спецификаций в каждом
+ *  интерпретаторе, где импортирован модуль, и хранятся в состоянии модуля
+ */
+
+#ifndef PY_WIDGETS_MODULE_INIT_H
+#define PY_WIDGETS_MODULE_INIT_H
+
+#include <new>
+#include "PyWidgetsClasses.h"
+#include "PyWidgetsCommandBuffer.h"
+#include "PyWidgetsEventLoop.h"
+#include "PyWidgetsTasks.h"
+#include "PyWidgetsTimers.h"
+#include "PyWidgetsTemplate.h"
+
+// Состояние приходит обнуленным. При ошибке модуль удаляется, и недозаполненное
+//  состояние освобождает PyWidgets_FreeModule
+static int PyWidgets_ExecModule(PyObject* module) {
+    PyWidgetsModuleState* state = PyWidgets_GetModuleState(module);
+    state->stringCache = new (std::nothrow) PyWidgetsStringCacheEntry[PY_WIDGETS_STRING_CACHE_SIZE]();
+    if (state->stringCache == NULL) {
+        PyErr_NoMemory();
+        return -1;
+    }
+
+    ADD_TYPE(module, Object, state->objectType, NULL);
+    REGISTER_TYPE(module, state, Application);
+    REGISTER_TYPE(module, state, Widget);
+    REGISTER_TYPE(module, state, Label);
+    REGISTER_TYPE(module, state, VBoxLayout);
+    REGISTER_TYPE(module, state, PushButton);
+    REGISTER_TYPE(module, state, ListView);
+    REGISTER_TYPE(module, state, TableView);
+    REGISTER_TYPE(module, state, Image);
+    REGISTER_TYPE(module, state, Plot);
+    REGISTER_TYPE(module, state, LogView);
+    ADD_TYPE(module, CommandBuffer, state->commandBufferType, NULL);
+    ADD_TYPE(module, Template, state->templateType, NULL);
+    ADD_TYPE(module, EventLoopSelector, state->eventLoopSelectorType, NULL);
+    ADD_TYPE(module, Task, state->taskType, NULL);
+    ADD_TYPE(module, Timer, state->timerType, NULL);
+#if PY_VERSION_HEX < 0x030A0000
+    state->objectType->tp_new = NULL;
+    state->taskType->tp_new = NULL;
+    state->timerType->tp_new = NULL;
+#endif
+
+    // С этого места модуль виден PyWidgets_FindState. Повторный импорт заменяет запись,
+    //  и старые кэши в потоках сбрасываются
+    PyObject* dict = PyInterpreterState_GetDict(PyInterpreterState_Get());
+    if (dict == NULL) {
+        PyErr_SetString(PyExc_RuntimeError, "interpreter has no state dict");
+        return -1;
+    }
+    if (PyDict_SetItemString(dict, PY_WIDGETS_MODULE_NAME, module) < 0) {
+        return -1;
+    }
+    PyWidgets_StateGeneration.fetch_add(1, std::memory_order_acq_rel);
+    return 0;
+}
+
+static int PyWidgets_TraverseModule(PyObject* module, visitproc visit, void* arg) {
+    PyWidgetsModuleState* state = PyWidgets_GetModuleState(module);
+    Py_VISIT(state->objectType);
+    Py_VISIT(state->commandBufferType);
+    Py_VISIT(state->templateType);
+    Py_VISIT(state->eventLoopSelectorType);
+    Py_VISIT(state->taskType);
+    Py_VISIT(state->timerType);
+    for (int tag = PyWidgetsTag_Unknown + 1; tag < PyWidgetsTag_Count; ++tag) {
+        Py_VISIT(state->types[tag].type);
+    }
+    Py_VISIT(state->asyncio);
+    Py_VISIT(state->tasks);
+    Py_VISIT(state->selectorKeyType);
+    return 0;
+}
+
+static int PyWidgets_ClearModule(PyObject* module) {
+    PyWidgetsModuleState* state = PyWidgets_GetModuleState(module);
+    Py_CLEAR(state->objectType);
+    Py_CLEAR(state->commandBufferType);
+    Py_CLEAR(state->templateType);
+    Py_CLEAR(state->eventLoopSelectorType);
+    Py_CLEAR(state->taskType);
+    Py_CLEAR(state->timerType);
+    for (int tag = PyWidgetsTag_Unknown + 1; tag < PyWidgetsTag_Count; ++tag) {
+        Py_CLEAR(state->types[tag].type);
+        Py_CLEAR(state->types[tag].className);
+    }
+    if (state->stringCache != NULL) {
+        for (int i = 0; i < PY_WIDGETS_STRING_CACHE_SIZE; ++i) {
+            Py_CLEAR(state->stringCache[i].key);
+        }
+    }
+    PyWidgetsStateNames& names = state->stateNames;
+    PyObject** fields[] = {&names.type, &names.key, &names.props, &names.children,
+        &names.title, &names.text, &names.size, &names.visible};
+    for (size_t i = 0; i < sizeof(fields) / sizeof(fields[0]); ++i) {
+        Py_CLEAR(*fields[i]);
+    }
+    Py_CLEAR(state->asyncio);
+    Py_CLEAR(state->tasks);
+    Py_CLEAR(state->selectorKeyType);
+    return 0;
+}
+
+// Обертки в списках свободных уже разрушены и держат только память
+static void PyWidgets_FreeModule(void* module) {
+    PyWidgets_ClearModule((PyObject*)module);
+    PyWidgetsModuleState* state = PyWidgets_GetModuleState((PyObject*)module);
+    for (int tag = PyWidgetsTag_Unknown + 1; tag < PyWidgetsTag_Count; ++tag) {
+        while (state->freeCount[tag] > 0) {
+            PyObject_GC_Del(state->freeList[tag][--state->freeCount[tag]]);
+        }
+    }
+    delete[] state->stringCache;
+    state->stringCache = NULL;
+    PyWidgets_StateGeneration.fetch_add(1, std::memory_order_acq_rel);
+}
+
+// Объекты Qt создаются только в основном интерпретаторе (PyWidgets_CheckMainInterpreter),
+//  а общая с ним очередь обновлений защищена мьютексом, поэтому модулю не нужен общий GIL.
+//  Не нужен и GIL вообще: вызовы Qt из других потоков уходят в GUI-поток (PY_GUI_METHOD),
+//  а поля, которые потоки делят, защищены критическими секциями (PyWidgetsThreads.h)
+static PyModuleDef_Slot PyWidgets_ModuleSlots[] = {
+    {Py_mod_exec, (void*)PyWidgets_ExecModule},
+#if PY_VERSION_HEX >= 0x030C0000
+    {Py_mod_multiple_interpreters, Py_MOD_PER_INTERPRETER_GIL_SUPPORTED},
+#endif
+#if PY_VERSION_HEX >= 0x030D0000
+    {Py_mod_gil, Py_MOD_GIL_NOT_USED},
+#endif
+    {0, NULL}
+};
+
+#endif // PY_WIDGETS_MODULE_INIT_H
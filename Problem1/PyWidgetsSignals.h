@@ -0,0 +1,125 @@
+/*
+ * Преобразование аргументов сигналов Qt в объекты Python
+ */
+
+#ifndef PY_WIDGETS_SIGNALS_H
+#define PY_WIDGETS_SIGNALS_H
+
+#include <Python.h>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include "widgets.h"
+
+// Возвращает новую ссылку на объект Python со значением параметра сигнала
+typedef PyObject* (*PyWidgetsArgConverter)(void* value);
+
+static PyObject* PyWidgets_FromBoolArg(void* value) {
+    return PyBool_FromLong(*(bool*)value);
+}
+
+static PyObject* PyWidgets_FromIntArg(void* value) {
+    return PyLong_FromLong(*(int*)value);
+}
+
+static PyObject* PyWidgets_FromUIntArg(void* value) {
+    return PyLong_FromUnsignedLong(*(unsigned int*)value);
+}
+
+static PyObject* PyWidgets_FromLongLongArg(void* value) {
+    return PyLong_FromLongLong(*(qlonglong*)value);
+}
+
+static PyObject* PyWidgets_FromULongLongArg(void* value) {
+    return PyLong_FromUnsignedLongLong(*(qulonglong*)value);
+}
+
+static PyObject* PyWidgets_FromDoubleArg(void* value) {
+    return PyFloat_FromDouble(*(double*)value);
+}
+
+static PyObject* PyWidgets_FromFloatArg(void* value) {
+    return PyFloat_FromDouble(*(float*)value);
+}
+
+static PyObject* PyWidgets_FromQStringArg(void* value) {
+    QByteArray utf8 = ((QString*)value)->toUtf8();
+    return PyUnicode_FromStringAndSize(utf8.constData(), utf8.size());
+}
+
+static PyObject* PyWidgets_FromQByteArrayArg(void* value) {
+    QByteArray* bytes = (QByteArray*)value;
+    return PyBytes_FromStringAndSize(bytes->constData(), bytes->size());
+}
+
+// Для типов без преобразования передается None, чтобы не сдвигать позиции аргументов
+static PyObject* PyWidgets_FromUnsupportedArg(void*) {
+    Py_RETURN_NONE;
+}
+
+static PyWidgetsArgConverter PyWidgets_GetArgConverter(int type) {
+    switch (type) {
+    case QMetaType::Bool:
+        return PyWidgets_FromBoolArg;
+    case QMetaType::Int:
+        return PyWidgets_FromIntArg;
+    case QMetaType::UInt:
+        return PyWidgets_FromUIntArg;
+    case QMetaType::LongLong:
+        return PyWidgets_FromLongLongArg;
+    case QMetaType::ULongLong:
+        return PyWidgets_FromULongLongArg;
+    case QMetaType::Double:
+        return PyWidgets_FromDoubleArg;
+    case QMetaType::Float:
+        return PyWidgets_FromFloatArg;
+    case QMetaType::QString:
+        return PyWidgets_FromQStringArg;
+    case QMetaType::QByteArray:
+        return PyWidgets_FromQByteArrayArg;
+    default:
+        return PyWidgets_FromUnsupportedArg;
+    }
+}
+
+// План преобразования аргументов одной сигнатуры: строится при первом подключении,
+//  при испускании остается пройти по массиву конвертеров
+struct PyWidgetsSignalPlan {
+    std::vector<PyWidgetsArgConverter> converters;
+};
+
+// Планы не удаляются, поэтому указатель можно хранить в подключении. Только из GUI-потока
+static const PyWidgetsSignalPlan* PyWidgets_GetSignalPlan(const SignalSignature* signal) {
+    static std::unordered_map<std::string, PyWidgetsSignalPlan> plans;
+
+    std::string signature(signal->signature.constData(), signal->signature.size());
+    auto it = plans.find(signature);
+    if (it == plans.end()) {
+        PyWidgetsSignalPlan plan;
+        for (int type : signal->parameterTypes) {
+            plan.converters.push_back(PyWidgets_GetArgConverter(type));
+        }
+        it = plans.emplace(std::move(signature), std::move(plan)).first;
+    }
+    return &it->second;
+}
+
+// Собирает кортеж аргументов для обработчика; вызывающий держит GIL
+static PyObject* PyWidgets_MarshalSignal(const PyWidgetsSignalPlan* plan, void** args) {
+    Py_ssize_t count = (Py_ssize_t)plan->converters.size();
+    PyObject* tuple = PyTuple_New(count);
+    if (tuple == NULL) {
+        return NULL;
+    }
+    for (Py_ssize_t i = 0; i < count; ++i) {
+        PyObject* item = plan->converters[i](args[i]);
+        if (item == NULL) {
+            Py_DECREF(tuple);
+            return NULL;
+        }
+        PyTuple_SET_ITEM(tuple, i, item);
+    }
+    return tuple;
+}
+
+#endif // PY_WIDGETS_SIGNALS_H
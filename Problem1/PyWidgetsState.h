@@ -0,0 +1,249 @@
+/*
+ * Разбор декларативного описания интерфейса для Widget_ApplyState
+ */
+
+#ifndef PY_WIDGETS_STATE_H
+#define PY_WIDGETS_STATE_H
+
+#include <Python.h>
+#include "widgets.h"
+#include "PyWidgetsArgs.h"
+
+// Узел - dict {"type": str, "key": str | int, "props": dict, "children": sequence},
+//  где обязателен только type. Свойства: у Widget - title, size (пара чисел) и visible,
+//  у Label и PushButton - text и visible. Дочерние узлы бывают только у Widget
+
+// Имена полей интернированы, как и строковые литералы в коде на Python, поэтому
+//  поиск в словаре узла обычно обходится сравнением указателей
+struct PyWidgetsStateNames {
+    PyObject* type;
+    PyObject* key;
+    PyObject* props;
+    PyObject* children;
+    PyObject* title;
+    PyObject* text;
+    PyObject* size;
+    PyObject* visible;
+};
+
+// Строки свои у каждого интерпретатора и лежат в состоянии модуля (PyWidgetsClasses.h)
+static PyWidgetsStateNames* PyWidgets_GetStateNamesStorage();
+
+static const PyWidgetsStateNames* PyWidgets_GetStateNames() {
+    PyWidgetsStateNames* names = PyWidgets_GetStateNamesStorage();
+    if (names == NULL) {
+        return NULL;
+    }
+    if (names->visible == NULL) {
+        PyObject** fields[] = {&names->type, &names->key, &names->props, &names->children,
+            &names->title, &names->text, &names->size, &names->visible};
+        const char* values[] = {"type", "key", "props", "children", "title", "text", "size", "visible"};
+        for (size_t i = 0; i < sizeof(fields) / sizeof(fields[0]); ++i) {
+            if (*fields[i] == NULL && (*fields[i] = PyUnicode_InternFromString(values[i])) == NULL) {
+                return NULL;
+            }
+        }
+    }
+    return names;
+}
+
+static int PyWidgets_ToStateNodeType(PyObject* obj, StateNodeType* result) {
+    if (!PyWidgets_CheckUnicode(obj)) {
+        return 0;
+    }
+    if (PyUnicode_CompareWithASCIIString(obj, Widget::TypeName) == 0) {
+        *result = StateNodeType_Widget;
+    } else if (PyUnicode_CompareWithASCIIString(obj, Label::TypeName) == 0) {
+        *result = StateNodeType_Label;
+    } else if (PyUnicode_CompareWithASCIIString(obj, PushButton::TypeName) == 0) {
+        *result = StateNodeType_PushButton;
+    } else {
+        PyErr_Format(PyExc_ValueError, "unsupported state node type %R", obj);
+        return 0;
+    }
+    return 1;
+}
+
+static int PyWidgets_ToStateKey(PyObject* obj, StateNode* node) {
+    if (PyLong_CheckExact(obj)) {
+        // Ключ-число хранится текстом; "1" и 1 считаются одним ключом
+        int overflow = 0;
+        long long value = PyLong_AsLongLongAndOverflow(obj, &overflow);
+        if (overflow == 0) {
+            node->key = QString::number(value);
+            return 1;
+        }
+        PyObject* text = PyObject_Str(obj);
+        if (text == NULL) {
+            return 0;
+        }
+        int isOk = PyWidgets_UnicodeToQString(text, &node->key);
+        Py_DECREF(text);
+        return isOk;
+    }
+    if (!PyUnicode_Check(obj)) {
+        PyErr_Format(PyExc_TypeError, "state node key must be str or int, got %.200s", Py_TYPE(obj)->tp_name);
+        return 0;
+    }
+    return PyWidgets_UnicodeToQString(obj, &node->key);
+}
+
+static int PyWidgets_ToStateProperties(PyObject* props, StateNode* node, const PyWidgetsStateNames* names) {
+    if (!PyDict_Check(props)) {
+        PyErr_Format(PyExc_TypeError, "state node props must be dict, got %.200s", Py_TYPE(props)->tp_name);
+        return 0;
+    }
+    Py_ssize_t position = 0;
+    PyObject* name;
+    PyObject* value;
+    while (PyDict_Next(props, &position, &name, &value)) {
+        bool isWidget = node->type == StateNodeType_Widget;
+        if (!PyUnicode_Check(name)) {
+            PyErr_Format(PyExc_TypeError, "property name must be str, got %.200s", Py_TYPE(name)->tp_name);
+            return 0;
+        }
+        if (PyUnicode_Compare(name, isWidget ? names->title : names->text) == 0) {
+            if (!PyWidgets_ToQString(value, &node->text)) {
+                return 0;
+            }
+            node->properties |= StateProperty_Text;
+        } else if (isWidget && PyUnicode_Compare(name, names->size) == 0) {
+            PyObject* size = PySequence_Fast(value, "size must be a (width, height) pair");
+            if (size == NULL) {
+                return 0;
+            }
+            int isOk = PySequence_Fast_GET_SIZE(size) == 2;
+            if (!isOk) {
+                PyErr_SetString(PyExc_ValueError, "size must be a (width, height) pair");
+            }
+            isOk = isOk &&
+                PyWidgets_ToInt(PySequence_Fast_GET_ITEM(size, 0), &node->width) &&
+                PyWidgets_ToInt(PySequence_Fast_GET_ITEM(size, 1), &node->height);
+            Py_DECREF(size);
+            if (!isOk) {
+                return 0;
+            }
+            node->properties |= StateProperty_Size;
+        } else if (PyUnicode_Compare(name, names->visible) == 0) {
+            if (!PyWidgets_ToBool(value, &node->isVisible)) {
+                return 0;
+            }
+            node->properties |= StateProperty_Visible;
+        } else {
+            PyErr_Format(PyExc_ValueError, "unknown state property %R", name);
+            return 0;
+        }
+    }
+    return 1;
+}
+
+static int PyWidgets_ToStateNode(PyObject* obj, StateNode* node);
+
+static int PyWidgets_ToStateChildren(PyObject* children, StateNode* node) {
+    PyObject* sequence = PySequence_Fast(children, "state node children must be a sequence");
+    if (sequence == NULL) {
+        return 0;
+    }
+    Py_ssize_t count = PySequence_Fast_GET_SIZE(sequence);
+    if (count != 0 && node->type != StateNodeType_Widget) {
+        Py_DECREF(sequence);
+        PyErr_SetString(PyExc_ValueError, "only Widget state nodes can have children");
+        return 0;
+    }
+    PyObject** items = PySequence_Fast_ITEMS(sequence);
+    node->children.resize(count);
+    for (Py_ssize_t i = 0; i < count; ++i) {
+        if (!PyWidgets_ToStateNode(items[i], &node->children[i])) {
+            Py_DECREF(sequence);
+            return 0;
+        }
+    }
+    Py_DECREF(sequence);
+    return 1;
+}
+
+static int PyWidgets_ToStateNode(PyObject* obj, StateNode* node) {
+    const PyWidgetsStateNames* names = PyWidgets_GetStateNames();
+    if (names == NULL) {
+        return 0;
+    }
+    if (!PyDict_Check(obj)) {
+        PyErr_Format(PyExc_TypeError, "state node must be dict, got %.200s", Py_TYPE(obj)->tp_name);
+        return 0;
+    }
+    node->properties = 0;
+    node->hasKey = false;
+    node->isVisible = false;
+    node->width = 0;
+    node->height = 0;
+
+    PyObject* type = PyDict_GetItemWithError(obj, names->type);
+    if (type == NULL) {
+        if (!PyErr_Occurred()) {
+            PyErr_SetString(PyExc_ValueError, "state node has no type");
+        }
+        return 0;
+    }
+    if (!PyWidgets_ToStateNodeType(type, &node->type)) {
+        return 0;
+    }
+
+    PyObject* key = PyDict_GetItemWithError(obj, names->key);
+    if (key != NULL) {
+        if (!PyWidgets_ToStateKey(key, node)) {
+            return 0;
+        }
+        node->hasKey = true;
+    } else if (PyErr_Occurred()) {
+        return 0;
+    }
+
+    PyObject* props = PyDict_GetItemWithError(obj, names->props);
+    if (props != NULL) {
+        if (!PyWidgets_ToStateProperties(props, node, names)) {
+            return 0;
+        }
+    } else if (PyErr_Occurred()) {
+        return 0;
+    }
+
+    PyObject* children = PyDict_GetItemWithError(obj, names->children);
+    if (children != NULL) {
+        if (Py_EnterRecursiveCall(" while converting a state tree")) {
+            return 0;
+        }
+        int isOk = PyWidgets_ToStateChildren(children, node);
+        Py_LeaveRecursiveCall();
+        return isOk;
+    }
+    return !PyErr_Occurred();
+}
+
+// Общая часть Widget.apply_state и Widget_ApplyState: разбирает дерево целиком до того,
+//  как трогать виджеты, и возвращает статистику примененных изменений
+static PyObject* PyWidgets_ApplyState(const char* name, Widget* widget, PyObject* tree) {
+    if (widget->GetQObject()->thread() != QThread::currentThread()) {
+        PyErr_Format(PyExc_RuntimeError, "%s() must be called from the GUI thread", name);
+        return NULL;
+    }
+    StateNode root;
+    if (!PyWidgets_ToStateNode(tree, &root)) {
+        return NULL;
+    }
+    if (root.type != StateNodeType_Widget) {
+        PyErr_Format(PyExc_ValueError, "%s() root node must have type 'Widget'", name);
+        return NULL;
+    }
+    ReconcileStats stats;
+    if (!Widget_ApplyState(widget, root, &stats)) {
+        PyErr_Format(PyExc_ValueError, "%s() requires a widget without a layout or with a box layout", name);
+        return NULL;
+    }
+    return Py_BuildValue("{sKsKsKsK}",
+        "created", (unsigned long long)stats.created,
+        "removed", (unsigned long long)stats.removed,
+        "moved", (unsigned long long)stats.moved,
+        "updated", (unsigned long long)stats.updated);
+}
+
+#endif // PY_WIDGETS_STATE_H
@@ -0,0 +1,201 @@
+/*
+ * Столбцы TableView над буферами Python
+ */
+
+#ifndef PY_WIDGETS_TABLE_COLUMNS_H
+#define PY_WIDGETS_TABLE_COLUMNS_H
+
+#include <Python.h>
+#include <climits>
+#include <cstring>
+#include <memory>
+#include <vector>
+#include "widgets.h"
+#include "PyWidgetsArgs.h"
+
+// Захваченный буфер. Столбец держит его через TableColumn::keeper, а удаляется он
+//  вместе с моделью, в том числе из цикла событий без GIL
+struct PyWidgetsBuffer {
+    Py_buffer view;
+};
+
+static void PyWidgets_ReleaseBuffer(PyWidgetsBuffer* buffer) {
+    PyGILState_STATE gil = PyGILState_Ensure();
+    PyBuffer_Release(&buffer->view);
+    PyGILState_Release(gil);
+    delete buffer;
+}
+
+// Данные читаются по индексу строки, поэтому буфер должен быть непрерывным
+static std::shared_ptr<PyWidgetsBuffer> PyWidgets_AcquireBuffer(PyObject* obj) {
+    PyWidgetsBuffer* buffer = new PyWidgetsBuffer();
+    if (PyObject_GetBuffer(obj, &buffer->view, PyBUF_C_CONTIGUOUS | PyBUF_FORMAT) < 0) {
+        delete buffer;
+        return nullptr;
+    }
+    return std::shared_ptr<PyWidgetsBuffer>(buffer, PyWidgets_ReleaseBuffer);
+}
+
+// Код формата struct без префикса нативного порядка байтов
+static char PyWidgets_GetFormatCode(const Py_buffer& view) {
+    const char* format = (view.format != NULL) ? view.format : "B";
+    if (format[0] == '@') {
+        ++format;
+    }
+    return (format[0] != '\0' && format[1] == '\0') ? format[0] : '\0';
+}
+
+static bool PyWidgets_IsInt64Buffer(const Py_buffer& view) {
+    char code = PyWidgets_GetFormatCode(view);
+    return view.ndim == 1 && view.itemsize == 8 && (code == 'q' || code == 'l' || code == 'n');
+}
+
+static bool PyWidgets_IsFloat64Buffer(const Py_buffer& view) {
+    return view.ndim == 1 && view.itemsize == 8 && PyWidgets_GetFormatCode(view) == 'd';
+}
+
+static bool PyWidgets_IsBytesBuffer(const Py_buffer& view) {
+    char code = PyWidgets_GetFormatCode(view);
+    return view.ndim <= 1 && view.itemsize == 1 && (code == 'B' || code == 'b' || code == 'c');
+}
+
+static Py_ssize_t PyWidgets_GetBufferLength(const Py_buffer& view) {
+    return view.len / view.itemsize;
+}
+
+// Строки модели нумеруются int
+static bool PyWidgets_CheckRowCount(PyObject* name, Py_ssize_t rows) {
+    if (rows > INT_MAX) {
+        PyErr_Format(PyExc_ValueError, "column %R: too many rows", name);
+        return false;
+    }
+    return true;
+}
+
+// Числовой столбец: (name, values), values - int64 или float64
+static bool PyWidgets_ToValuesColumn(PyObject* name, PyObject* values, TableColumn* column) {
+    std::shared_ptr<PyWidgetsBuffer> buffer = PyWidgets_AcquireBuffer(values);
+    if (buffer == nullptr) {
+        return false;
+    }
+    const Py_buffer& view = buffer->view;
+    if (PyWidgets_IsInt64Buffer(view)) {
+        column->type = TableColumnType_Int64;
+    } else if (PyWidgets_IsFloat64Buffer(view)) {
+        column->type = TableColumnType_Float64;
+    } else {
+        PyErr_Format(PyExc_TypeError, "column %R: expected one-dimensional int64 or float64 buffer", name);
+        return false;
+    }
+    if (!PyWidgets_CheckRowCount(name, PyWidgets_GetBufferLength(view))) {
+        return false;
+    }
+    column->rows = (int)PyWidgets_GetBufferLength(view);
+    column->values = view.buf;
+    column->offsets = NULL;
+    column->keeper = buffer;
+    return true;
+}
+
+// Смещения строк в данных длиной length: count неубывающих значений в ее границах.
+//  Возвращает описание ошибки или NULL
+static const char* PyWidgets_CheckOffsets(const int64_t* offsets, Py_ssize_t count, Py_ssize_t length) {
+    if (offsets[0] < 0 || offsets[count - 1] > length) {
+        return "offsets out of data bounds";
+    }
+    for (Py_ssize_t i = 1; i < count; ++i) {
+        if (offsets[i] < offsets[i - 1]) {
+            return "offsets must be non-decreasing";
+        }
+    }
+    return NULL;
+}
+
+// Строковый столбец: (name, offsets, data), offsets - rows + 1 неубывающих int64,
+//  data - байты UTF-8. Смещения копируются и проверяются здесь: модель читает по ним
+//  без проверок, поэтому изменения буфера offsets после set_columns на нее не влияют.
+//  Данные остаются в буфере data, их можно менять на месте и вызывать refresh
+static bool PyWidgets_ToStringColumn(PyObject* name, PyObject* offsets, PyObject* data, TableColumn* column) {
+    std::shared_ptr<PyWidgetsBuffer> offsetsBuffer = PyWidgets_AcquireBuffer(offsets);
+    if (offsetsBuffer == nullptr) {
+        return false;
+    }
+    std::shared_ptr<PyWidgetsBuffer> dataBuffer = PyWidgets_AcquireBuffer(data);
+    if (dataBuffer == nullptr) {
+        return false;
+    }
+    if (!PyWidgets_IsInt64Buffer(offsetsBuffer->view) || PyWidgets_GetBufferLength(offsetsBuffer->view) < 1) {
+        PyErr_Format(PyExc_TypeError, "column %R: offsets must be a non-empty int64 buffer", name);
+        return false;
+    }
+    if (!PyWidgets_IsBytesBuffer(dataBuffer->view)) {
+        PyErr_Format(PyExc_TypeError, "column %R: data must be a bytes-like buffer", name);
+        return false;
+    }
+    Py_ssize_t count = PyWidgets_GetBufferLength(offsetsBuffer->view);
+    if (!PyWidgets_CheckRowCount(name, count - 1)) {
+        return false;
+    }
+    const int64_t* offsetValues = (const int64_t*)offsetsBuffer->view.buf;
+    std::shared_ptr<std::vector<int64_t>> offsetsCopy =
+        std::make_shared<std::vector<int64_t>>(offsetValues, offsetValues + count);
+    offsetsBuffer = nullptr;
+    const char* error = PyWidgets_CheckOffsets(offsetsCopy->data(), count, dataBuffer->view.len);
+    if (error != NULL) {
+        PyErr_Format(PyExc_ValueError, "column %R: %s", name, error);
+        return false;
+    }
+    column->type = TableColumnType_String;
+    column->rows = (int)(count - 1);
+    column->values = dataBuffer->view.buf;
+    column->offsets = offsetsCopy->data();
+    // Копия смещений и буфер данных живут, пока жив столбец
+    column->keeper = std::make_shared<std::pair<std::shared_ptr<std::vector<int64_t>>, std::shared_ptr<PyWidgetsBuffer>>>(
+        offsetsCopy, dataBuffer);
+    return true;
+}
+
+// Разбирает последовательность описаний столбцов: (name, values) или (name, offsets, data)
+static bool PyWidgets_ToTableColumns(PyObject* items, std::vector<TableColumn>* columns) {
+    PyObject* sequence = PySequence_Fast(items, "expected a sequence of column tuples");
+    if (sequence == NULL) {
+        return false;
+    }
+    Py_ssize_t count = PySequence_Fast_GET_SIZE(sequence);
+    PyObject** elements = PySequence_Fast_ITEMS(sequence);
+    bool isOk = true;
+    for (Py_ssize_t i = 0; i < count && isOk; ++i) {
+        PyObject* item = elements[i];
+        Py_ssize_t size = PyTuple_Check(item) ? PyTuple_GET_SIZE(item) : 0;
+        if (size != 2 && size != 3) {
+            PyErr_SetString(PyExc_TypeError, "columns must be (name, values) or (name, offsets, data) tuples");
+            isOk = false;
+            break;
+        }
+        PyObject* name = PyTuple_GET_ITEM(item, 0);
+        TableColumn column;
+        if (!PyUnicode_Check(name)) {
+            PyErr_SetString(PyExc_TypeError, "column name must be str");
+            isOk = false;
+            break;
+        }
+        if (!PyWidgets_UnicodeToQString(name, &column.name)) {
+            isOk = false;
+            break;
+        }
+        isOk = (size == 2) ?
+            PyWidgets_ToValuesColumn(name, PyTuple_GET_ITEM(item, 1), &column) :
+            PyWidgets_ToStringColumn(name, PyTuple_GET_ITEM(item, 1), PyTuple_GET_ITEM(item, 2), &column);
+        if (isOk && !columns->empty() && column.rows != columns->front().rows) {
+            PyErr_Format(PyExc_ValueError, "column %R: all columns must have the same length", name);
+            isOk = false;
+        }
+        if (isOk) {
+            columns->push_back(std::move(column));
+        }
+    }
+    Py_DECREF(sequence);
+    return isOk;
+}
+
+#endif // PY_WIDGETS_TABLE_COLUMNS_H
@@ -0,0 +1,315 @@
+/*
+ * Фоновые задачи: Application.submit и завершения в GUI-потоке
+ */
+
+#ifndef PY_WIDGETS_TASKS_H
+#define PY_WIDGETS_TASKS_H
+
+#include "PyWidgetsClasses.h"
+
+// Имя капсулы с нативной задачей: указатель - PyWidgetsNativeTask, контекст капсулы
+//  передается ей аргументом. Такая задача выполняется без GIL
+#define PY_WIDGETS_NATIVE_TASK "pywidgets.native_task"
+
+typedef intptr_t (*PyWidgetsNativeTask)(void* context);
+
+enum PyTaskState {
+    PyTaskState_Pending,    // в очереди или выполняется
+    PyTaskState_Done,       // завершение доставлено в GUI-поток
+    PyTaskState_Cancelled
+};
+
+struct PyTask {
+    PyObject_HEAD
+    PyObject* app;          // задачи в пуле не дают удалить приложение
+    PyObject* fn;
+    PyObject* args;         // NULL после выполнения
+    PyObject* onDone;       // NULL после вызова
+    PyObject* result;
+    PyObject* exception;
+    PyWidgetsNativeTask native;
+    void* nativeContext;
+    intptr_t nativeResult;  // пишется рабочим потоком без GIL, читается после доставки
+    uint64_t id;
+    PyTaskState state;
+};
+
+static int PyTask_Traverse(PyTask* self, visitproc visit, void* arg) {
+    Py_VISIT(Py_TYPE(self));
+    Py_VISIT(self->app);
+    Py_VISIT(self->fn);
+    Py_VISIT(self->args);
+    Py_VISIT(self->onDone);
+    Py_VISIT(self->result);
+    Py_VISIT(self->exception);
+    return 0;
+}
+
+// on_done обычно замыкает саму задачу
+static int PyTask_Clear(PyTask* self) {
+    Py_CLEAR(self->app);
+    Py_CLEAR(self->fn);
+    Py_CLEAR(self->args);
+    Py_CLEAR(self->onDone);
+    Py_CLEAR(self->result);
+    Py_CLEAR(self->exception);
+    return 0;
+}
+
+static void PyTask_Dealloc(PyTask* self) {
+    PyTypeObject* type = Py_TYPE(self);
+    PyObject_GC_UnTrack(self);
+    PyTask_Clear(self);
+    type->tp_free((PyObject*)self);
+    Py_DECREF(type);
+}
+
+// Рабочий поток пула. Python-функция берет GIL на время вызова, нативная его не трогает
+static void PyTask_Run(void* context) {
+    PyTask* self = (PyTask*)context;
+    if (self->native != NULL) {
+        self->nativeResult = self->native(self->nativeContext);
+        return;
+    }
+    PyGILState_STATE gil = PyGILState_Ensure();
+    PyObject* result = PyObject_Call(self->fn, self->args, NULL);
+    if (result != NULL) {
+        self->result = result;
+    } else {
+        PyObject* type;
+        PyObject* value;
+        PyObject* traceback;
+        PyErr_Fetch(&type, &value, &traceback);
+        PyErr_NormalizeException(&type, &value, &traceback);
+        if (traceback != NULL && value != NULL) {
+            PyException_SetTraceback(value, traceback);
+        }
+        self->exception = value;
+        Py_XDECREF(type);
+        Py_XDECREF(traceback);
+    }
+    Py_CLEAR(self->args);
+    PyGILState_Release(gil);
+}
+
+// Пачка завершений: GIL берется один раз на всю пачку. Пул держал ссылку на каждую задачу.
+//  Завершение после удаления приложения (isDropped) приходит из рабочего потока: on_done
+//  не вызывается, а задача считается отмененной - ее результат не доставлен
+static void PyTask_Done(const TaskCompletion* completions, size_t count) {
+    PyGILState_STATE gil = PyGILState_Ensure();
+    for (size_t i = 0; i < count; ++i) {
+        PyTask* self = (PyTask*)completions[i].context;
+        PyObject* onDone;
+        // Без GIL методы задачи могут в это время выполняться в других потоках
+        PY_WIDGETS_BEGIN_CRITICAL_SECTION(self);
+        if (completions[i].isCancelled || completions[i].isDropped) {
+            self->state = PyTaskState_Cancelled;
+        } else {
+            self->state = PyTaskState_Done;
+            if (self->native != NULL && (self->result = PyLong_FromSsize_t(self->nativeResult)) == NULL) {
+                PyErr_Print();
+            }
+        }
+        Py_CLEAR(self->args);
+        onDone = self->onDone;
+        self->onDone = NULL;
+        PY_WIDGETS_END_CRITICAL_SECTION();
+        if (onDone != NULL) {
+            if (!completions[i].isDropped) {
+                PyWidgets_FinishCallback(PyObject_CallFunctionObjArgs(onDone, (PyObject*)self, NULL));
+            }
+            Py_DECREF(onDone);
+        }
+        Py_DECREF(self);
+    }
+    PyGILState_Release(gil);
+}
+
+static PyObject* PyTask_Cancel(PyTask* self) {
+    if (self->state != PyTaskState_Pending) {
+        return PyBool_FromLong(self->state == PyTaskState_Cancelled);
+    }
+    Application* app = ((PyApplication*)self->app)->pImpl;
+    if (app == NULL || !TaskPool_Cancel(app, self->id)) {
+        Py_RETURN_FALSE;
+    }
+    // on_done придет следующей пачкой
+    self->state = PyTaskState_Cancelled;
+    Py_RETURN_TRUE;
+}
+
+static PyObject* PyTask_Cancelled(PyTask* self) {
+    return PyBool_FromLong(self->state == PyTaskState_Cancelled);
+}
+
+static PyObject* PyTask_IsDone(PyTask* self) {
+    return PyBool_FromLong(self->state != PyTaskState_Pending);
+}
+
+static PyObject* PyTask_Result(PyTask* self) {
+    if (self->state == PyTaskState_Pending) {
+        PyErr_SetString(PyExc_RuntimeError, "task is not done yet");
+        return NULL;
+    }
+    if (self->state == PyTaskState_Cancelled) {
+        PyErr_SetString(PyExc_RuntimeError, "task was cancelled");
+        return NULL;
+    }
+    if (self->exception != NULL) {
+        PyErr_SetObject((PyObject*)Py_TYPE(self->exception), self->exception);
+        return NULL;
+    }
+    PyObject* result = (self->result != NULL) ? self->result : Py_None;
+    Py_INCREF(result);
+    return result;
+}
+
+static PyObject* PyTask_Exception(PyTask* self) {
+    if (self->state == PyTaskState_Pending) {
+        PyErr_SetString(PyExc_RuntimeError, "task is not done yet");
+        return NULL;
+    }
+    PyObject* exception = (self->exception != NULL) ? self->exception : Py_None;
+    Py_INCREF(exception);
+    return exception;
+}
+
+static PyMethodDef PyTask_methods[] = {
+    {"cancel", PY_LOCKED_METHOD(PyTask_Cancel), METH_NOARGS,
+        "Removes the task from the queue if it has not started; returns True if the task is cancelled"},
+    {"cancelled", PY_LOCKED_METHOD(PyTask_Cancelled), METH_NOARGS, "Returns True if the task was cancelled"},
+    {"done", PY_LOCKED_METHOD(PyTask_IsDone), METH_NOARGS,
+        "Returns True once the task is cancelled or its completion reached the GUI thread"},
+    {"result", PY_LOCKED_METHOD(PyTask_Result), METH_NOARGS,
+        "Returns the value of fn or raises its exception; raises RuntimeError if the task is not done or cancelled"},
+    {"exception", PY_LOCKED_METHOD(PyTask_Exception), METH_NOARGS,
+        "Returns the exception raised by fn or None"},
+    {NULL}
+};
+
+static PyType_Slot PyTask_slots[] = {
+    {Py_tp_dealloc, (void*)PyTask_Dealloc},
+    {Py_tp_traverse, (void*)PyTask_Traverse},
+    {Py_tp_clear, (void*)PyTask_Clear},
+    {Py_tp_methods, (void*)PyTask_methods},
+    {Py_tp_doc, (void*)"Background task created by Application.submit"},
+    {0, NULL}
+};
+
+static PyType_Spec Py_SpecTask = {
+    "pywidgets.Task",
+    sizeof(PyTask),
+    0,
+    Py_TPFLAGS_DEFAULT | Py_TPFLAGS_HAVE_GC | PY_WIDGETS_TPFLAGS_IMMUTABLE | PY_WIDGETS_TPFLAGS_NO_NEW,
+    PyTask_slots
+};
+
+// submit(fn, *args, on_done=None). fn - вызываемый объект или капсула PY_WIDGETS_NATIVE_TASK
+//  (без аргументов, результат - int). on_done(task) вызывается в GUI-потоке, может быть
+//  корутинной функцией. Можно вызывать из любого потока
+static PyObject* PyApplication_Submit(PyApplication* self, PyObject* const* args, Py_ssize_t nargs, PyObject* kwnames) {
+    PyWidgetsModuleState* state = PyWidgets_GetState();
+    if (state == NULL || !PyWidgets_CheckAlive(self->pImpl)) {
+        return NULL;
+    }
+    if (nargs < 1) {
+        PyErr_SetString(PyExc_TypeError, "submit() missing required argument 'fn'");
+        return NULL;
+    }
+    PyObject* onDone = NULL;
+    Py_ssize_t kwargsCount = (kwnames != NULL) ? PyTuple_GET_SIZE(kwnames) : 0;
+    for (Py_ssize_t i = 0; i < kwargsCount; ++i) {
+        PyObject* name = PyTuple_GET_ITEM(kwnames, i);
+        if (!PyUnicode_Check(name) || PyUnicode_CompareWithASCIIString(name, "on_done") != 0) {
+            PyErr_Format(PyExc_TypeError, "submit() got an unexpected keyword argument '%S'", name);
+            return NULL;
+        }
+        onDone = args[nargs + i];
+    }
+    if (onDone == Py_None) {
+        onDone = NULL;
+    }
+    if (onDone != NULL && !PyCallable_Check(onDone)) {
+        PyErr_SetString(PyExc_TypeError, "submit() on_done must be callable or None");
+        return NULL;
+    }
+
+    PyObject* fn = args[0];
+    PyWidgetsNativeTask native = NULL;
+    void* nativeContext = NULL;
+    if (PyCapsule_CheckExact(fn)) {
+        native = (PyWidgetsNativeTask)PyCapsule_GetPointer(fn, PY_WIDGETS_NATIVE_TASK);
+        if (native == NULL) {
+            return NULL;
+        }
+        nativeContext = PyCapsule_GetContext(fn);
+        if (nargs != 1) {
+            PyErr_SetString(PyExc_TypeError, "submit() native task takes no arguments");
+            return NULL;
+        }
+    } else if (!PyCallable_Check(fn)) {
+        PyErr_SetString(PyExc_TypeError, "submit() argument 1 must be callable or a native task capsule");
+        return NULL;
+    }
+    PyObject* fnArgs = NULL;
+    if (native == NULL) {
+        if ((fnArgs = PyTuple_New(nargs - 1)) == NULL) {
+            return NULL;
+        }
+        for (Py_ssize_t i = 1; i < nargs; ++i) {
+            Py_INCREF(args[i]);
+            PyTuple_SET_ITEM(fnArgs, i - 1, args[i]);
+        }
+    }
+
+    PyTask* task = PyObject_GC_New(PyTask, state->taskType);
+    if (task == NULL) {
+        Py_XDECREF(fnArgs);
+        return NULL;
+    }
+    Py_INCREF(self);
+    task->app = (PyObject*)self;
+    Py_INCREF(fn);
+    task->fn = fn;
+    task->args = fnArgs;
+    Py_XINCREF(onDone);
+    task->onDone = onDone;
+    task->result = NULL;
+    task->exception = NULL;
+    task->native = native;
+    task->nativeContext = nativeContext;
+    task->nativeResult = 0;
+    task->state = PyTaskState_Pending;
+    task->id = 0;
+    PyObject_GC_Track(task);
+
+    // Ссылка пула, отпускается в PyTask_Done. Номер пишется до того, как Python-задача
+    //  сможет взять GIL, а cancel() без номера просто вернет False
+    Py_INCREF(task);
+    task->id = TaskPool_Submit(self->pImpl, PyTask_Run, PyTask_Done, task);
+    return (PyObject*)task;
+}
+
+static PyObject* PyApplication_TaskStats(PyApplication* self) {
+    if (!PyWidgets_CheckAlive(self->pImpl)) {
+        return NULL;
+    }
+    TaskStats stats = TaskPool_GetStats(self->pImpl);
+    uint64_t started = stats.completed + stats.running;
+    uint64_t delivered = stats.completed + stats.cancelled;
+    return Py_BuildValue("{sKsKsKsKsKsKsisKsKsKsKsK}",
+        "submitted", (unsigned long long)stats.submitted,
+        "completed", (unsigned long long)stats.completed,
+        "cancelled", (unsigned long long)stats.cancelled,
+        "queued", (unsigned long long)stats.queued,
+        "running", (unsigned long long)stats.running,
+        "batches", (unsigned long long)stats.batches,
+        "threads", stats.threadCount,
+        "avg_wait_ns", (unsigned long long)(started != 0 ? stats.waitNs / started : 0),
+        "max_wait_ns", (unsigned long long)stats.maxWaitNs,
+        "avg_run_ns", (unsigned long long)(stats.completed != 0 ? stats.runNs / stats.completed : 0),
+        "avg_delivery_ns", (unsigned long long)(delivered != 0 ? stats.deliveryNs / delivered : 0),
+        "max_delivery_ns", (unsigned long long)stats.maxDeliveryNs);
+}
+
+#endif // PY_WIDGETS_TASKS_H
@@ -0,0 +1,343 @@
+/*
+ * Шаблон поддерева: построение записывается один раз, а instantiate() строит
+ *  сколько угодно копий одним вызовом
+ */
+
+#ifndef PY_WIDGETS_TEMPLATE_H
+#define PY_WIDGETS_TEMPLATE_H
+
+#include <memory>
+#include "PyWidgetsClasses.h"
+
+struct PyTemplate {
+    PyObject_HEAD
+    Template* pImpl;
+};
+
+static PyObject* PyTemplate_new(PyTypeObject* type, PyObject* args, PyObject* kwds) {
+    if (!PyWidgets_CheckArgsCount("Template", PyTuple_GET_SIZE(args), 0) ||
+        !PyWidgets_CheckMainInterpreter("Template"))
+    {
+        return NULL;
+    }
+    PyTemplate* self = (PyTemplate*)type->tp_alloc(type, 0);
+    if (self != NULL) {
+        self->pImpl = Template_New();
+    }
+
+    return (PyObject*)self;
+}
+
+static void PyTemplate_Dealloc(PyTemplate* self) {
+    PyTypeObject* type = Py_TYPE(self);
+    if (self->pImpl != NULL) {
+        Template_Delete(self->pImpl);
+    }
+    type->tp_free((PyObject*)self);
+    Py_DECREF(type);
+}
+
+static const char* PyTemplate_GetSlotName(TemplateOp op) {
+    switch (op) {
+    case TemplateOp_WidgetNew:
+        return Widget::TypeName;
+    case TemplateOp_VBoxLayoutNew:
+        return VBoxLayout::TypeName;
+    case TemplateOp_LabelNew:
+        return Label::TypeName;
+    case TemplateOp_PushButtonNew:
+        return PushButton::TypeName;
+    default:
+        return "?";
+    }
+}
+
+// Разбирает номер слота, выданный одной из функций *_new этого шаблона
+static int PyTemplate_ToSlot(PyTemplate* self, PyObject* obj, int* result) {
+    if (!PyLong_Check(obj)) {
+        PyErr_Format(PyExc_TypeError, "expected Template handle, got %.200s", Py_TYPE(obj)->tp_name);
+        return 0;
+    }
+    int slot = 0;
+    if (!PyWidgets_ToInt(obj, &slot)) {
+        return 0;
+    }
+    if (slot < 0 || slot >= (int) self->pImpl->slots.size()) {
+        PyErr_Format(PyExc_IndexError, "invalid Template handle %d", slot);
+        return 0;
+    }
+    *result = slot;
+    return 1;
+}
+
+// op - команда, создающая объекты нужного типа
+static int PyTemplate_ToTypedSlot(PyTemplate* self, PyObject* obj, TemplateOp op, int* result) {
+    if (!PyTemplate_ToSlot(self, obj, result)) {
+        return 0;
+    }
+    TemplateOp slotOp = self->pImpl->slots[*result];
+    if (slotOp != op) {
+        PyErr_Format(PyExc_TypeError, "expected %s handle, got %s handle",
+            PyTemplate_GetSlotName(op), PyTemplate_GetSlotName(slotOp));
+        return 0;
+    }
+    return 1;
+}
+
+static int PyTemplate_ToWidgetSlot(PyTemplate* self, PyObject* obj, int* result) {
+    if (!PyTemplate_ToSlot(self, obj, result)) {
+        return 0;
+    }
+    if (self->pImpl->slots[*result] == TemplateOp_VBoxLayoutNew) {
+        PyErr_SetString(PyExc_TypeError, "expected widget handle, got VBoxLayout handle");
+        return 0;
+    }
+    return 1;
+}
+
+// Текст: str - общий для всех экземпляров, int - номер параметра экземпляра
+static int PyTemplate_ToText(PyTemplate* self, PyObject* obj, int* result) {
+    if (PyLong_Check(obj)) {
+        int param = 0;
+        if (!PyWidgets_ToInt(obj, &param)) {
+            return 0;
+        }
+        if (param < 0) {
+            PyErr_SetString(PyExc_ValueError, "parameter index must be non-negative");
+            return 0;
+        }
+        *result = TemplateText_Param(param);
+        return 1;
+    }
+    QString text;
+    if (!PyWidgets_ToQString(obj, &text)) {
+        return 0;
+    }
+    *result = Template_AddText(self->pImpl, text);
+    return 1;
+}
+
+//----------------------------------------------------------------------------------------
+
+// Родитель необязателен: без него (или с None) объект - корень экземпляра
+static PyObject* PyTemplate_NewWidget(PyTemplate* self, const char* name, PyObject* const* args,
+    Py_ssize_t nargs, TemplateOp op)
+{
+    int parent = TemplateRoot;
+    if (nargs > 1) {
+        PyErr_Format(PyExc_TypeError, "%s() takes at most 1 argument (%zd given)", name, nargs);
+        return NULL;
+    }
+    if (nargs == 1 && args[0] != Py_None &&
+        !PyTemplate_ToTypedSlot(self, args[0], TemplateOp_WidgetNew, &parent))
+    {
+        return NULL;
+    }
+    return PyLong_FromLong(Template_AddObject(self->pImpl, op, parent));
+}
+
+static PyObject* PyTemplate_WidgetNew(PyTemplate* self, PyObject* const* args, Py_ssize_t nargs) {
+    return PyTemplate_NewWidget(self, "widget_new", args, nargs, TemplateOp_WidgetNew);
+}
+
+static PyObject* PyTemplate_LabelNew(PyTemplate* self, PyObject* const* args, Py_ssize_t nargs) {
+    return PyTemplate_NewWidget(self, "label_new", args, nargs, TemplateOp_LabelNew);
+}
+
+static PyObject* PyTemplate_PushButtonNew(PyTemplate* self, PyObject* const* args, Py_ssize_t nargs) {
+    return PyTemplate_NewWidget(self, "push_button_new", args, nargs, TemplateOp_PushButtonNew);
+}
+
+static PyObject* PyTemplate_VBoxLayoutNew(PyTemplate* self, PyObject* const* args, Py_ssize_t nargs) {
+    int widget = 0;
+    if (!PyWidgets_CheckArgsCount("vbox_layout_new", nargs, 1) ||
+        !PyTemplate_ToTypedSlot(self, args[0], TemplateOp_WidgetNew, &widget))
+    {
+        return NULL;
+    }
+    return PyLong_FromLong(Template_VBoxLayoutNew(self->pImpl, widget));
+}
+
+static PyObject* PyTemplate_WidgetSetWindowTitle(PyTemplate* self, PyObject* const* args, Py_ssize_t nargs) {
+    int widget = 0, text = 0;
+    if (!PyWidgets_CheckArgsCount("widget_set_window_title", nargs, 2) ||
+        !PyTemplate_ToTypedSlot(self, args[0], TemplateOp_WidgetNew, &widget) ||
+        !PyTemplate_ToText(self, args[1], &text))
+    {
+        return NULL;
+    }
+    Template_WidgetSetWindowTitle(self->pImpl, widget, text);
+    Py_RETURN_NONE;
+}
+
+static PyObject* PyTemplate_WidgetSetSize(PyTemplate* self, PyObject* const* args, Py_ssize_t nargs) {
+    int widget = 0, width = 0, height = 0;
+    if (!PyWidgets_CheckArgsCount("widget_set_size", nargs, 3) ||
+        !PyTemplate_ToTypedSlot(self, args[0], TemplateOp_WidgetNew, &widget) ||
+        !PyWidgets_ToInt(args[1], &width) || !PyWidgets_ToInt(args[2], &height))
+    {
+        return NULL;
+    }
+    Template_WidgetSetSize(self->pImpl, widget, width, height);
+    Py_RETURN_NONE;
+}
+
+static PyObject* PyTemplate_WidgetSetVisible(PyTemplate* self, PyObject* const* args, Py_ssize_t nargs) {
+    int widget = 0;
+    bool isVisible = false;
+    if (!PyWidgets_CheckArgsCount("widget_set_visible", nargs, 2) ||
+        !PyTemplate_ToWidgetSlot(self, args[0], &widget) ||
+        !PyWidgets_ToBool(args[1], &isVisible))
+    {
+        return NULL;
+    }
+    Template_WidgetSetVisible(self->pImpl, widget, isVisible);
+    Py_RETURN_NONE;
+}
+
+static PyObject* PyTemplate_LayoutAddWidget(PyTemplate* self, PyObject* const* args, Py_ssize_t nargs) {
+    int layout = 0, widget = 0;
+    if (!PyWidgets_CheckArgsCount("layout_add_widget", nargs, 2) ||
+        !PyTemplate_ToTypedSlot(self, args[0], TemplateOp_VBoxLayoutNew, &layout) ||
+        !PyTemplate_ToWidgetSlot(self, args[1], &widget))
+    {
+        return NULL;
+    }
+    Template_LayoutAddWidget(self->pImpl, layout, widget);
+    Py_RETURN_NONE;
+}
+
+static PyObject* PyTemplate_LabelSetText(PyTemplate* self, PyObject* const* args, Py_ssize_t nargs) {
+    int label = 0, text = 0;
+    if (!PyWidgets_CheckArgsCount("label_set_text", nargs, 2) ||
+        !PyTemplate_ToTypedSlot(self, args[0], TemplateOp_LabelNew, &label) ||
+        !PyTemplate_ToText(self, args[1], &text))
+    {
+        return NULL;
+    }
+    Template_LabelSetText(self->pImpl, label, text);
+    Py_RETURN_NONE;
+}
+
+static PyObject* PyTemplate_PushButtonSetText(PyTemplate* self, PyObject* const* args, Py_ssize_t nargs) {
+    int button = 0, text = 0;
+    if (!PyWidgets_CheckArgsCount("push_button_set_text", nargs, 2) ||
+        !PyTemplate_ToTypedSlot(self, args[0], TemplateOp_PushButtonNew, &button) ||
+        !PyTemplate_ToText(self, args[1], &text))
+    {
+        return NULL;
+    }
+    Template_PushButtonSetText(self->pImpl, button, text);
+    Py_RETURN_NONE;
+}
+
+//----------------------------------------------------------------------------------------
+
+// instantiate(parent, count, params=None). params - (offsets, data), как у строковых
+//  столбцов TableView: count * param_count() + 1 смещений int64 в байтах UTF-8, строки
+//  экземпляра i идут подряд с индекса i * param_count(). Буферы нужны только на время вызова
+static PyObject* PyTemplate_Instantiate(PyTemplate* self, PyObject* const* args, Py_ssize_t nargs) {
+    PyWidget* parent = NULL;
+    int count = 0;
+    if (nargs != 2 && nargs != 3) {
+        PyErr_Format(PyExc_TypeError, "instantiate() takes 2 or 3 arguments (%zd given)", nargs);
+        return NULL;
+    }
+    if (!Py_ConvertWidget(args[0], &parent) || !PyWidgets_ToInt(args[1], &count)) {
+        return NULL;
+    }
+    if (count < 0) {
+        PyErr_SetString(PyExc_ValueError, "instance count must be non-negative");
+        return NULL;
+    }
+    if (parent->pImpl->GetQObject()->thread() != QThread::currentThread()) {
+        PyErr_SetString(PyExc_RuntimeError, "instantiate() must be called from the GUI thread");
+        return NULL;
+    }
+
+    Template* tpl = self->pImpl;
+    PyObject* params = (nargs == 3) ? args[2] : Py_None;
+    if (tpl->paramCount == 0 || count == 0) {
+        if (params != Py_None && tpl->paramCount == 0) {
+            PyErr_SetString(PyExc_ValueError, "template has no parameters");
+            return NULL;
+        }
+        Template_Instantiate(tpl, parent->pImpl, count, NULL, NULL);
+        Py_RETURN_NONE;
+    }
+
+    if (!PyTuple_Check(params) || PyTuple_GET_SIZE(params) != 2) {
+        PyErr_SetString(PyExc_TypeError, "params must be an (offsets, data) tuple");
+        return NULL;
+    }
+    std::shared_ptr<PyWidgetsBuffer> offsets = PyWidgets_AcquireBuffer(PyTuple_GET_ITEM(params, 0));
+    if (offsets == nullptr) {
+        return NULL;
+    }
+    std::shared_ptr<PyWidgetsBuffer> data = PyWidgets_AcquireBuffer(PyTuple_GET_ITEM(params, 1));
+    if (data == nullptr) {
+        return NULL;
+    }
+    Py_ssize_t expected = (Py_ssize_t) count * tpl->paramCount + 1;
+    if (!PyWidgets_IsInt64Buffer(offsets->view) || PyWidgets_GetBufferLength(offsets->view) != expected) {
+        PyErr_Format(PyExc_ValueError, "offsets must be an int64 buffer of %zd items", expected);
+        return NULL;
+    }
+    if (!PyWidgets_IsBytesBuffer(data->view)) {
+        PyErr_SetString(PyExc_TypeError, "data must be a bytes-like buffer");
+        return NULL;
+    }
+    const int64_t* offsetValues = (const int64_t*) offsets->view.buf;
+    const char* error = PyWidgets_CheckOffsets(offsetValues, expected, data->view.len);
+    if (error != NULL) {
+        PyErr_SetString(PyExc_ValueError, error);
+        return NULL;
+    }
+    Template_Instantiate(tpl, parent->pImpl, count, (const char*) data->view.buf, offsetValues);
+    Py_RETURN_NONE;
+}
+
+static PyObject* PyTemplate_ParamCount(PyTemplate* self, PyObject* noargs) {
+    return PyLong_FromLong(self->pImpl->paramCount);
+}
+
+static PyMethodDef PyTemplate_methods[] = {
+    {"widget_new", PY_LOCKED_METHOD(PyTemplate_WidgetNew), METH_FASTCALL,
+        "Records Widget_New, returns handle; without a parent the widget is an instance root"},
+    {"vbox_layout_new", PY_LOCKED_METHOD(PyTemplate_VBoxLayoutNew), METH_FASTCALL, "Records VBoxLayout_New, returns handle"},
+    {"label_new", PY_LOCKED_METHOD(PyTemplate_LabelNew), METH_FASTCALL,
+        "Records Label_New, returns handle; without a parent the label is an instance root"},
+    {"push_button_new", PY_LOCKED_METHOD(PyTemplate_PushButtonNew), METH_FASTCALL,
+        "Records PushButton_New, returns handle; without a parent the button is an instance root"},
+    {"widget_set_window_title", PY_LOCKED_METHOD(PyTemplate_WidgetSetWindowTitle), METH_FASTCALL,
+        "Records Widget_SetWindowTitle with a str or a parameter index"},
+    {"widget_set_size", PY_LOCKED_METHOD(PyTemplate_WidgetSetSize), METH_FASTCALL, "Records Widget_SetSize"},
+    {"widget_set_visible", PY_LOCKED_METHOD(PyTemplate_WidgetSetVisible), METH_FASTCALL, "Records Widget_SetVisible"},
+    {"layout_add_widget", PY_LOCKED_METHOD(PyTemplate_LayoutAddWidget), METH_FASTCALL, "Records Layout_AddWidget"},
+    {"label_set_text", PY_LOCKED_METHOD(PyTemplate_LabelSetText), METH_FASTCALL,
+        "Records Label_SetText with a str or a parameter index"},
+    {"push_button_set_text", PY_LOCKED_METHOD(PyTemplate_PushButtonSetText), METH_FASTCALL,
+        "Records PushButton_SetText with a str or a parameter index"},
+    {"instantiate", PY_GUI_LOCKED_METHOD(PyTemplate_Instantiate), METH_FASTCALL,
+        "Builds count copies in parent; per-instance texts come from an (offsets, data) UTF-8 buffer pair"},
+    {"param_count", PY_LOCKED_METHOD(PyTemplate_ParamCount), METH_NOARGS, "Returns the number of texts per instance"},
+    {NULL}
+};
+
+static PyType_Slot PyTemplate_slots[] = {
+    {Py_tp_dealloc, (void*)PyTemplate_Dealloc},
+    {Py_tp_methods, (void*)PyTemplate_methods},
+    {Py_tp_new, (void*)PyTemplate_new},
+    {Py_tp_doc, (void*)"Template object"},
+    {0, NULL}
+};
+
+static PyType_Spec Py_SpecTemplate = {
+    "pywidgets.Template",
+    sizeof(PyTemplate),
+    0,
+    Py_TPFLAGS_DEFAULT | PY_WIDGETS_TPFLAGS_IMMUTABLE,
+    PyTemplate_slots
+};
+
+#endif // PY_WIDGETS_TEMPLATE_H
@@ -0,0 +1,216 @@
+/*
+ * Потоки: вызовы оберток не из GUI-потока и сборка Python без GIL (free-threaded)
+ */
+
+#ifndef PY_WIDGETS_THREADS_H
+#define PY_WIDGETS_THREADS_H
+
+#include <Python.h>
+#include <memory>
+#include "widgets.h"
+
+// Для условий внутри макросов, где #ifdef недоступен
+#ifdef Py_GIL_DISABLED
+#define PY_WIDGETS_FREE_THREADED 1
+#else
+#define PY_WIDGETS_FREE_THREADED 0
+#endif
+
+// Без GIL методы одного объекта могут выполняться в нескольких потоках сразу. Поля, которые
+//  меняются после создания объекта и читаются из других потоков (pImpl обертки, состояние
+//  задачи), защищает критическая секция объекта. С GIL секции не нужны и ничего не делают
+#ifdef Py_GIL_DISABLED
+#define PY_WIDGETS_BEGIN_CRITICAL_SECTION(op) Py_BEGIN_CRITICAL_SECTION(op)
+#define PY_WIDGETS_END_CRITICAL_SECTION() Py_END_CRITICAL_SECTION()
+#else
+#define PY_WIDGETS_BEGIN_CRITICAL_SECTION(op) {
+#define PY_WIDGETS_END_CRITICAL_SECTION() }
+#endif
+
+// Привязку объекта библиотеки к обертке (Object_GetBinding) снимают GUI-поток, когда удаляет
+//  объект, и любой поток, когда освобождает обертку. С GIL их разделяет он, без GIL - этот
+//  мьютекс: пока он взят, обертку, найденную по привязке, нельзя освободить
+#ifdef Py_GIL_DISABLED
+static PyMutex PyWidgets_BindingMutex = {0};
+
+static inline void PyWidgets_LockBindings() {
+    PyMutex_Lock(&PyWidgets_BindingMutex);
+}
+
+static inline void PyWidgets_UnlockBindings() {
+    PyMutex_Unlock(&PyWidgets_BindingMutex);
+}
+#else
+static inline void PyWidgets_LockBindings() {}
+static inline void PyWidgets_UnlockBindings() {}
+#endif
+
+// В 3.13t нет PyUnstable_TryIncRef, а узнать по счетчику ссылок, что обертку уже
+//  освобождают, можно только через внутренние поля. Поэтому там привязка держит сильную
+//  ссылку на обертку (isKeptAlive с Py_Bind##ClassName до отвязки), и пока обертку видно
+//  под PyWidgets_LockBindings, ее счетчик не бывает нулевым
+#if defined(Py_GIL_DISABLED) && PY_VERSION_HEX < 0x030E0000
+#define PY_WIDGETS_BINDING_HOLDS_REF 1
+#else
+#define PY_WIDGETS_BINDING_HOLDS_REF 0
+#endif
+
+// Вызывается для только что созданной обертки, пока на нее нет других ссылок:
+//  без этого PyWidgets_TryIncRef может не узнать живую обертку из другого потока
+static inline void PyWidgets_EnableTryIncRef(PyObject* obj) {
+#if defined(Py_GIL_DISABLED) && PY_VERSION_HEX >= 0x030E0000
+    PyUnstable_EnableTryIncRef(obj);
+#else
+    (void)obj;
+#endif
+}
+
+// Берет ссылку на обертку, найденную по привязке под PyWidgets_LockBindings. В 3.14t ее
+//  счетчик мог уже обнулиться в другом потоке, который ждет мьютекс, чтобы ее освободить, -
+//  тогда возвращает 0 и ссылку не берет. С GIL и в 3.13t (PY_WIDGETS_BINDING_HOLDS_REF)
+//  такого не бывает
+static inline int PyWidgets_TryIncRef(PyObject* obj) {
+#if defined(Py_GIL_DISABLED) && PY_VERSION_HEX >= 0x030E0000
+    return PyUnstable_TryIncRef(obj);
+#else
+    Py_INCREF(obj);
+    return 1;
+#endif
+}
+
+// После завершения интерпретатора (приложение пережило его) ссылку отпускать уже некому
+static void PyWidgets_ReleaseRef(PyObject* obj) {
+    if (!Py_IsInitialized()) {
+        return;
+    }
+    PyGILState_STATE gil = PyGILState_Ensure();
+    Py_DECREF(obj);
+    PyGILState_Release(gil);
+}
+
+// Ссылка для функторов, которые уходят в цикл событий Qt: Qt разрушает функтор без GIL,
+//  а если приложение удалено раньше, то и не вызвав его. Ссылка отпускается под GIL,
+//  кто бы ни разрушил последнюю копию. Вызывается под GIL
+static std::shared_ptr<PyObject> PyWidgets_HoldRef(PyObject* obj) {
+    Py_INCREF(obj);
+    return std::shared_ptr<PyObject>(obj, PyWidgets_ReleaseRef);
+}
+
+// Выполняет call() в GUI-потоке и возвращает его результат: новую ссылку или NULL с исключением.
+//  Из другого потока call ставится в цикл событий (Application_Invoke), а поток ждет его,
+//  отпустив GIL, чтобы GUI-поток мог взять GIL и выполнить call; исключение переносится
+//  в вызывающий поток. Поэтому GUI-поток не должен в это время ждать вызывающий, например
+//  в join() до Application.exec(). В других интерпретаторах объектов Qt нет, там call
+//  выполняется на месте и сам сообщает об ошибке
+template <typename Call>
+static PyObject* PyWidgets_CallInGuiThread(const Call& call) {
+    if (Application_IsGuiThread() || PyInterpreterState_Get() != PyInterpreterState_Main()) {
+        return call();
+    }
+    PyObject* result = NULL;
+    PyObject* type = NULL;
+    PyObject* value = NULL;
+    PyObject* traceback = NULL;
+    bool isExecuted = false;
+    Py_BEGIN_ALLOW_THREADS
+    isExecuted = Application_Invoke([&call, &result, &type, &value, &traceback]() {
+        PyGILState_STATE gil = PyGILState_Ensure();
+        result = call();
+        if (result == NULL) {
+            PyErr_Fetch(&type, &value, &traceback);
+        }
+        PyGILState_Release(gil);
+    });
+    Py_END_ALLOW_THREADS
+    if (!isExecuted) {
+        PyErr_SetString(PyExc_RuntimeError, "application was destroyed before the call reached the GUI thread");
+        return NULL;
+    }
+    if (result == NULL) {
+        PyErr_Restore(type, value, traceback);
+    }
+    return result;
+}
+
+// Метод с той же сигнатурой (METH_NOARGS или METH_FASTCALL), который выполняет method
+//  через PyWidgets_CallInGuiThread. В таблицах методов - через PY_GUI_METHOD
+template <typename Method, Method method>
+struct PyWidgetsGuiMethod;
+
+template <typename Self, PyObject* (*method)(Self*)>
+struct PyWidgetsGuiMethod<PyObject* (*)(Self*), method> {
+    static PyObject* Call(Self* self) {
+        return PyWidgets_CallInGuiThread([self]() { return method(self); });
+    }
+};
+
+template <typename Self, PyObject* (*method)(Self*, PyObject*)>
+struct PyWidgetsGuiMethod<PyObject* (*)(Self*, PyObject*), method> {
+    static PyObject* Call(Self* self, PyObject* arg) {
+        return PyWidgets_CallInGuiThread([self, arg]() { return method(self, arg); });
+    }
+};
+
+template <typename Self, PyObject* (*method)(Self*, PyObject* const*, Py_ssize_t)>
+struct PyWidgetsGuiMethod<PyObject* (*)(Self*, PyObject* const*, Py_ssize_t), method> {
+    static PyObject* Call(Self* self, PyObject* const* args, Py_ssize_t nargs) {
+        return PyWidgets_CallInGuiThread([self, args, nargs]() { return method(self, args, nargs); });
+    }
+};
+
+// То же для критической секции: method выполняется, держа секцию self
+template <typename Method, Method method>
+struct PyWidgetsLockedMethod;
+
+template <typename Self, PyObject* (*method)(Self*)>
+struct PyWidgetsLockedMethod<PyObject* (*)(Self*), method> {
+    static PyObject* Call(Self* self) {
+        PyObject* result;
+        PY_WIDGETS_BEGIN_CRITICAL_SECTION(self);
+        result = method(self);
+        PY_WIDGETS_END_CRITICAL_SECTION();
+        return result;
+    }
+};
+
+template <typename Self, PyObject* (*method)(Self*, PyObject*)>
+struct PyWidgetsLockedMethod<PyObject* (*)(Self*, PyObject*), method> {
+    static PyObject* Call(Self* self, PyObject* arg) {
+        PyObject* result;
+        PY_WIDGETS_BEGIN_CRITICAL_SECTION(self);
+        result = method(self, arg);
+        PY_WIDGETS_END_CRITICAL_SECTION();
+        return result;
+    }
+};
+
+template <typename Self, PyObject* (*method)(Self*, PyObject* const*, Py_ssize_t)>
+struct PyWidgetsLockedMethod<PyObject* (*)(Self*, PyObject* const*, Py_ssize_t), method> {
+    static PyObject* Call(Self* self, PyObject* const* args, Py_ssize_t nargs) {
+        PyObject* result;
+        PY_WIDGETS_BEGIN_CRITICAL_SECTION(self);
+        result = method(self, args, nargs);
+        PY_WIDGETS_END_CRITICAL_SECTION();
+        return result;
+    }
+};
+
+// Методы, которые обращаются к объектам Qt, оборачиваются в PY_GUI_METHOD. Методы,
+//  меняющие поля объекта, которые другие потоки читают без GIL, - в PY_LOCKED_METHOD
+//  (с GIL это сам метод), а то и другое вместе - в PY_GUI_LOCKED_METHOD
+#define PY_GUI_METHOD(method) (PyCFunction)PyWidgetsGuiMethod<decltype(&method), &method>::Call
+
+// Вызов method в критической секции self не из таблицы методов
+#define PY_LOCKED_CALL(method) PyWidgetsLockedMethod<decltype(&method), &method>::Call
+
+#ifdef Py_GIL_DISABLED
+#define PY_LOCKED_METHOD(method) (PyCFunction)PyWidgetsLockedMethod<decltype(&method), &method>::Call
+#define PY_GUI_LOCKED_METHOD(method) (PyCFunction)PyWidgetsGuiMethod< \
+    decltype(&PyWidgetsLockedMethod<decltype(&method), &method>::Call), \
+    &PyWidgetsLockedMethod<decltype(&method), &method>::Call>::Call
+#else
+#define PY_LOCKED_METHOD(method) (PyCFunction)method
+#define PY_GUI_LOCKED_METHOD(method) PY_GUI_METHOD(method)
+#endif
+
+#endif // PY_WIDGETS_THREADS_H
@@ -0,0 +1,241 @@
+/*
+ * Таймеры и кадры: Application.set_interval, set_timeout и request_frame
+ */
+
+#ifndef PY_WIDGETS_TIMERS_H
+#define PY_WIDGETS_TIMERS_H
+
+#include "PyWidgetsClasses.h"
+
+struct PyTimer {
+    PyObject_HEAD
+    PyObject* app;          // активные таймеры не дают удалить приложение
+    PyObject* callback;     // NULL после снятия
+    uint64_t id;
+    TimerKind kind;
+    bool isActive;
+    TimerStats stats;       // итог, когда таймер снят
+};
+
+static int PyTimer_Traverse(PyTimer* self, visitproc visit, void* arg) {
+    Py_VISIT(Py_TYPE(self));
+    Py_VISIT(self->app);
+    Py_VISIT(self->callback);
+    return 0;
+}
+
+static int PyTimer_Clear(PyTimer* self) {
+    Py_CLEAR(self->app);
+    Py_CLEAR(self->callback);
+    return 0;
+}
+
+static void PyTimer_Dealloc(PyTimer* self) {
+    PyTypeObject* type = Py_TYPE(self);
+    PyObject_GC_UnTrack(self);
+    PyTimer_Clear(self);
+    type->tp_free((PyObject*)self);
+    Py_DECREF(type);
+}
+
+// GIL берется один раз на проход планировщика, вызовы внутри него только входят повторно
+static void* PyTimer_EnterBatch() {
+    return (void*)(intptr_t)PyGILState_Ensure();
+}
+
+static void PyTimer_LeaveBatch(void* state) {
+    PyGILState_Release((PyGILState_STATE)(intptr_t)state);
+}
+
+// Кадру передается его срок, как requestAnimationFrame
+static void PyTimer_Run(void* context, double frameTime) {
+    PyTimer* self = (PyTimer*)context;
+    PyGILState_STATE gil = PyGILState_Ensure();
+    PyObject* callback = self->callback;
+    if (callback != NULL) {
+        Py_INCREF(callback);
+        if (self->kind == TimerKind_Frame) {
+            PyObject* time = PyFloat_FromDouble(frameTime);
+            PyWidgets_FinishCallback((time != NULL) ? PyObject_CallFunctionObjArgs(callback, time, NULL) : NULL);
+            Py_XDECREF(time);
+        } else {
+            PyWidgets_FinishCallback(PyObject_CallObject(callback, NULL));
+        }
+        Py_DECREF(callback);
+    }
+    PyGILState_Release(gil);
+}
+
+// Планировщик держал ссылку на таймер с момента постановки
+static void PyTimer_Release(void* context, const TimerStats& stats) {
+    PyTimer* self = (PyTimer*)context;
+    PyGILState_STATE gil = PyGILState_Ensure();
+    self->stats = stats;
+    self->isActive = false;
+    Py_CLEAR(self->callback);
+    Py_DECREF(self);
+    PyGILState_Release(gil);
+}
+
+static PyObject* PyTimer_Cancel(PyTimer* self) {
+    if (!self->isActive) {
+        Py_RETURN_FALSE;
+    }
+    Application* app = ((PyApplication*)self->app)->pImpl;
+    return PyBool_FromLong(app != NULL && Scheduler_Remove(app, self->id));
+}
+
+static PyObject* PyTimer_IsActive(PyTimer* self) {
+    return PyBool_FromLong(self->isActive);
+}
+
+static PyObject* PyTimer_Stats(PyTimer* self) {
+    TimerStats stats = self->stats;
+    Application* app = ((PyApplication*)self->app)->pImpl;
+    if (self->isActive && app != NULL) {
+        Scheduler_GetTimerStats(app, self->id, &stats);
+    }
+    return Py_BuildValue("{sKsKsKsKsKsKsKsK}",
+        "fires", (unsigned long long)stats.fires,
+        "overruns", (unsigned long long)stats.overruns,
+        "skipped", (unsigned long long)stats.skipped,
+        "throttled", (unsigned long long)stats.throttled,
+        "avg_run_ns", (unsigned long long)(stats.fires != 0 ? stats.runNs / stats.fires : 0),
+        "max_run_ns", (unsigned long long)stats.maxRunNs,
+        "avg_late_ns", (unsigned long long)(stats.fires != 0 ? stats.lateNs / stats.fires : 0),
+        "max_late_ns", (unsigned long long)stats.maxLateNs);
+}
+
+static PyMethodDef PyTimer_methods[] = {
+    {"cancel", PY_GUI_METHOD(PyTimer_Cancel), METH_NOARGS,
+        "Stops the timer; returns False if it has already fired or was cancelled"},
+    {"active", PY_GUI_METHOD(PyTimer_IsActive), METH_NOARGS, "Returns True until the timer fires for the last time or is cancelled"},
+    {"stats", PY_GUI_METHOD(PyTimer_Stats), METH_NOARGS,
+        "Returns dict with numbers of fires, overruns, skipped and throttled fires and run and lateness latencies"},
+    {NULL}
+};
+
+static PyType_Slot PyTimer_slots[] = {
+    {Py_tp_dealloc, (void*)PyTimer_Dealloc},
+    {Py_tp_traverse, (void*)PyTimer_Traverse},
+    {Py_tp_clear, (void*)PyTimer_Clear},
+    {Py_tp_methods, (void*)PyTimer_methods},
+    {Py_tp_doc, (void*)"Timer created by Application.set_interval, set_timeout or request_frame"},
+    {0, NULL}
+};
+
+static PyType_Spec Py_SpecTimer = {
+    "pywidgets.Timer",
+    sizeof(PyTimer),
+    0,
+    Py_TPFLAGS_DEFAULT | Py_TPFLAGS_HAVE_GC | PY_WIDGETS_TPFLAGS_IMMUTABLE | PY_WIDGETS_TPFLAGS_NO_NEW,
+    PyTimer_slots
+};
+
+// Общая часть set_interval, set_timeout и request_frame: args - callback и необязательный
+//  виджет, по окну которого таймер притормаживается
+static PyObject* PyApplication_AddTimer(PyApplication* self, const char* name, TimerKind kind, int intervalMs,
+    PyObject* const* args, Py_ssize_t nargs)
+{
+    PyWidgetsModuleState* state = PyWidgets_GetState();
+    if (state == NULL || !PyWidgets_CheckAlive(self->pImpl)) {
+        return NULL;
+    }
+    if (QThread::currentThread() != self->pImpl->GetQObject()->thread()) {
+        PyErr_Format(PyExc_RuntimeError, "%s() must be called from the GUI thread", name);
+        return NULL;
+    }
+    PyObject* callback = args[0];
+    if (!PyCallable_Check(callback)) {
+        PyErr_Format(PyExc_TypeError, "%s() callback must be callable", name);
+        return NULL;
+    }
+    QWidget* owner = NULL;
+    if (nargs == 2 && args[1] != Py_None) {
+        Object* object = NULL;
+        if (!PyWidgets_ToObject(args[1], &object)) {
+            return NULL;
+        }
+        owner = dynamic_cast<QWidget*>(object);
+        if (owner == NULL) {
+            PyErr_Format(PyExc_TypeError, "%s() widget must be a widget, not %.200s", name, Py_TYPE(args[1])->tp_name);
+            return NULL;
+        }
+    }
+
+    PyTimer* timer = PyObject_GC_New(PyTimer, state->timerType);
+    if (timer == NULL) {
+        return NULL;
+    }
+    Py_INCREF(self);
+    timer->app = (PyObject*)self;
+    Py_INCREF(callback);
+    timer->callback = callback;
+    timer->kind = kind;
+    timer->isActive = true;
+    timer->stats = TimerStats();
+    PyObject_GC_Track(timer);
+
+    // Ссылка планировщика, отпускается в PyTimer_Release
+    Py_INCREF(timer);
+    Scheduler_SetBatchHooks(self->pImpl, PyTimer_EnterBatch, PyTimer_LeaveBatch);
+    timer->id = Scheduler_Add(self->pImpl, kind, intervalMs, owner, PyTimer_Run, PyTimer_Release, timer);
+    return (PyObject*)timer;
+}
+
+static int PyApplication_ToIntervalMs(const char* name, PyObject* obj, int* intervalMs) {
+    if (!PyWidgets_ToInt(obj, intervalMs)) {
+        return 0;
+    }
+    if (*intervalMs < 0) {
+        PyErr_Format(PyExc_ValueError, "%s() interval must be non-negative", name);
+        return 0;
+    }
+    return 1;
+}
+
+static PyObject* PyApplication_SetInterval(PyApplication* self, PyObject* const* args, Py_ssize_t nargs) {
+    int intervalMs = 0;
+    if (nargs != 2 && !PyWidgets_CheckArgsCount("set_interval", nargs, 3)) {
+        return NULL;
+    }
+    if (!PyApplication_ToIntervalMs("set_interval", args[0], &intervalMs)) {
+        return NULL;
+    }
+    return PyApplication_AddTimer(self, "set_interval", TimerKind_Interval, intervalMs, args + 1, nargs - 1);
+}
+
+static PyObject* PyApplication_SetTimeout(PyApplication* self, PyObject* const* args, Py_ssize_t nargs) {
+    int intervalMs = 0;
+    if (nargs != 2 && !PyWidgets_CheckArgsCount("set_timeout", nargs, 3)) {
+        return NULL;
+    }
+    if (!PyApplication_ToIntervalMs("set_timeout", args[0], &intervalMs)) {
+        return NULL;
+    }
+    return PyApplication_AddTimer(self, "set_timeout", TimerKind_Timeout, intervalMs, args + 1, nargs - 1);
+}
+
+static PyObject* PyApplication_RequestFrame(PyApplication* self, PyObject* const* args, Py_ssize_t nargs) {
+    if (nargs != 1 && !PyWidgets_CheckArgsCount("request_frame", nargs, 2)) {
+        return NULL;
+    }
+    return PyApplication_AddTimer(self, "request_frame", TimerKind_Frame, 0, args, nargs);
+}
+
+static PyObject* PyApplication_SchedulerStats(PyApplication* self) {
+    if (!PyWidgets_CheckAlive(self->pImpl)) {
+        return NULL;
+    }
+    SchedulerStats stats = Scheduler_GetStats(self->pImpl);
+    return Py_BuildValue("{sKsKsKsKsKsKsK}",
+        "ticks", (unsigned long long)stats.ticks,
+        "fires", (unsigned long long)stats.fires,
+        "coalesced", (unsigned long long)stats.coalesced,
+        "throttled", (unsigned long long)stats.throttled,
+        "overruns", (unsigned long long)stats.overruns,
+        "timers", (unsigned long long)stats.timers,
+        "frame_interval_ns", (unsigned long long)stats.frameIntervalNs);
+}
+
+#endif // PY_WIDGETS_TIMERS_H
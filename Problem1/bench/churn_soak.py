@@ -0,0 +1,63 @@
+"""
+Soak test of the ownership model: creates and destroys a small window with
+children, a clicked callback and a reference cycle through that callback,
+one million times, and checks that the resident set size stays flat.
+Exits with a nonzero status if RSS after warmup grows by more than the limit:
+    PYTHONPATH=<build-dir> python3 churn_soak.py [cycles] [limit-mb]
+"""
+
+import gc
+import os
+import sys
+
+os.environ.setdefault("QT_QPA_PLATFORM", "offscreen")
+
+import pywidgets as pw
+
+CYCLES = int(sys.argv[1]) if len(sys.argv) > 1 else 1000000
+LIMIT_MB = float(sys.argv[2]) if len(sys.argv) > 2 else 8.0
+# Пулы, списки свободных оберток и кэши сигналов заполняются в начале - их не считаем
+WARMUP = min(CYCLES // 10, 50000)
+REPORT_EVERY = max(CYCLES // 20, 1)
+
+
+def rss_mb():
+    with open("/proc/self/statm") as statm:
+        pages = int(statm.read().split()[1])
+    return pages * os.sysconf("SC_PAGE_SIZE") / 2.0 ** 20
+
+
+def cycle(index):
+    window = pw.Widget()
+    layout = pw.VBoxLayout(window)
+    layout.add_widget(pw.Label(window))
+    button = pw.PushButton(window)
+    # Обработчик ссылается на окно: цикл окно -> кнопка -> обработчик -> окно
+    button.set_on_clicked(lambda checked: window.set_window_title("clicked"))
+    if index % 2 == 0:
+        button.click()
+
+
+def main():
+    app = pw.Application()
+    baseline = None
+    for index in range(CYCLES):
+        cycle(index)
+        if index + 1 == WARMUP:
+            gc.collect()
+            baseline = rss_mb()
+        if (index + 1) % REPORT_EVERY == 0:
+            print("%8d cycles  rss %.1f MB" % (index + 1, rss_mb()))
+    gc.collect()
+    final = rss_mb()
+    if baseline is None:
+        baseline = final
+    growth = final - baseline
+    print("rss after warmup %.1f MB, final %.1f MB, growth %.1f MB (limit %.1f MB)"
+          % (baseline, final, growth, LIMIT_MB))
+    del app
+    return 1 if growth > LIMIT_MB else 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
@@ -0,0 +1,93 @@
+"""
+Stress test of calls from worker threads: several threads change texts, titles
+and sizes of shared widgets, create children, read the tree, post updates and
+append to a log view, while the GUI thread runs the event loop. Meant for the
+free-threaded build (python3.13t), where the module runs without the GIL, but
+passes on a regular build too. Exits with a nonzero status on any error:
+    PYTHONPATH=<build-dir> python3 threads_stress.py [threads] [iterations]
+"""
+
+import os
+import sys
+import threading
+import time
+
+os.environ.setdefault("QT_QPA_PLATFORM", "offscreen")
+
+import pywidgets as pw
+
+THREADS = int(sys.argv[1]) if len(sys.argv) > 1 else 8
+ITERATIONS = int(sys.argv[2]) if len(sys.argv) > 2 else 2000
+
+
+def gil_enabled():
+    is_enabled = getattr(sys, "_is_gil_enabled", None)
+    return True if is_enabled is None else is_enabled()
+
+
+def worker(index, app, window, label, log, errors):
+    try:
+        for i in range(ITERATIONS):
+            label.set_text("thread %d: %d" % (index, i))
+            window.set_window_title("thread %d" % index)
+            window.set_size(200 + index, 100 + i % 50)
+            # Дочерние виджеты создаются в GUI-потоке, а обертки остаются у этого
+            child = pw.Label(window)
+            child.set_text(str(i))
+            if child.parent() is not window or label not in window.children():
+                raise AssertionError("widget tree is inconsistent")
+            # Ошибка в GUI-потоке приходит исключением в вызвавший поток
+            try:
+                window.set_size("wide", 1)
+            except TypeError:
+                pass
+            else:
+                raise AssertionError("TypeError was not raised")
+            app.post_set_text([(label, "posted %d" % i)])
+            log.append("thread %d: %d" % (index, i))
+    except BaseException as error:
+        errors.append((index, error))
+
+
+def main():
+    app = pw.Application()
+    window = pw.Widget()
+    layout = pw.VBoxLayout(window)
+    label = pw.Label(window)
+    layout.add_widget(label)
+    log = pw.LogView(window)
+    layout.add_widget(log)
+
+    errors = []
+    threads = [threading.Thread(target=worker, args=(index, app, window, label, log, errors))
+        for index in range(THREADS)]
+    started = time.perf_counter()
+    for thread in threads:
+        thread.start()
+
+    # Потоки ждут GUI-поток, поэтому он крутит цикл событий, пока они не закончат
+    def join():
+        for thread in threads:
+            thread.join()
+
+    loop = app.new_event_loop()
+    try:
+        loop.run_until_complete(loop.run_in_executor(None, join))
+    finally:
+        loop.close()
+    app.flush_updates()
+    elapsed = time.perf_counter() - started
+
+    calls = THREADS * ITERATIONS
+    print("%d threads x %d iterations in %.2f s, %.1f us per iteration, gil %s"
+          % (THREADS, ITERATIONS, elapsed, elapsed * 1e6 / calls,
+             "enabled" if gil_enabled() else "disabled"))
+    print("children: %d" % len(window.children()))
+    for index, error in errors:
+        print("thread %d: %r" % (index, error))
+    del app
+    return 1 if errors else 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
@@ -0,0 +1,402 @@
+/*
+ * Бенчмарк C++ библиотеки: задержка вызовов, скорость создания виджетов,
+ *  стоимость вставки в layout, время от нажатия до обработчика, память при
+ *  постоянном пересоздании виджетов, время кадра ListView в зависимости от длины списка
+ *  и время сортировки и фильтрации TableView, время кадра Plot и добавления в него точек,
+ *  задержка цикла событий при потоке строк в LogView из другого потока, стоимость кадра
+ *  сеттеров свойств с одинаковыми и с новыми значениями.
+ * Результат пишется в JSON (в файл из первого аргумента или в stdout)
+ */
+
+#include "widgets.h"
+
+#include <QPixmap>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <functional>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include <unistd.h>
+
+namespace {
+
+typedef std::vector<std::pair<std::string, double>> Results;
+
+const int CallIterations = 100000;
+const int CreateIterations = 10000;
+const int Repeats = 5;
+const int ChurnRounds = 100;
+const int ChurnWidgets = 1000;
+const int ListFrames = 100;
+const int ListSizes[] = {10, 1000, 100000, 10000000};
+const int TableRows = 1000000;
+const int PlotFrames = 20;
+const int PlotSizes[] = {1000, 100000, 1000000, 10000000};
+const int PlotChunk = 1000;
+const int LogLinesPerSec = 100000;
+const int LogSeconds = 2;
+const int UpdateLabels = 1000;
+const int UpdateWritesPerFrame = 10;
+const int UpdateFrames = 100;
+
+double NowNs() {
+    return std::chrono::duration<double, std::nano>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+// Лучшее из Repeats среднее время одного вызова, нс
+double MeasureNs(int iterations, const std::function<void()>& call) {
+    double best = 0;
+    for (int repeat = 0; repeat < Repeats; ++repeat) {
+        double start = NowNs();
+        for (int i = 0; i < iterations; ++i) {
+            call();
+        }
+        double elapsed = (NowNs() - start) / iterations;
+        best = (repeat == 0) ? elapsed : std::min(best, elapsed);
+    }
+    return best;
+}
+
+void BenchCalls(Results& results, Widget* window, VBoxLayout* layout, Label* label, PushButton* button) {
+    results.emplace_back("Widget_SetWindowTitle",
+        MeasureNs(CallIterations, [=] { Widget_SetWindowTitle(window, "title"); }));
+    results.emplace_back("Widget_SetSize",
+        MeasureNs(CallIterations, [=] { Widget_SetSize(window, 400, 300); }));
+    results.emplace_back("Widget_SetVisible",
+        MeasureNs(CallIterations, [=] { Widget_SetVisible(window, false); }));
+    results.emplace_back("Widget_SetLayout",
+        MeasureNs(CallIterations, [=] { Widget_SetLayout(window, layout); }));
+    results.emplace_back("Label_SetText",
+        MeasureNs(CallIterations, [=] { Label_SetText(label, "text"); }));
+    results.emplace_back("PushButton_SetText",
+        MeasureNs(CallIterations, [=] { PushButton_SetText(button, "text"); }));
+    results.emplace_back("Object_GetClassName",
+        MeasureNs(CallIterations, [=] { Object_GetClassName(label); }));
+}
+
+// Число созданных объектов в секунду; созданное удаляется вместе с родителем
+template <typename Create>
+double MeasureCreatePerSec(Create create) {
+    double best = 0;
+    for (int repeat = 0; repeat < Repeats; ++repeat) {
+        Widget* parent = Widget_New(NULL);
+        double start = NowNs();
+        for (int i = 0; i < CreateIterations; ++i) {
+            create(parent);
+        }
+        double perSec = CreateIterations / ((NowNs() - start) * 1e-9);
+        best = std::max(best, perSec);
+        Object_Delete(parent);
+    }
+    return best;
+}
+
+void BenchCreate(Results& results) {
+    results.emplace_back("Widget_New", MeasureCreatePerSec([](Widget* parent) {
+        Widget_New(parent);
+    }));
+    results.emplace_back("Label_New", MeasureCreatePerSec([](Widget* parent) {
+        Label_New(parent);
+    }));
+    results.emplace_back("PushButton_New", MeasureCreatePerSec([](Widget* parent) {
+        PushButton_New(parent);
+    }));
+}
+
+// Среднее время одной вставки при заполнении layout до count детей.
+//  Повторно добавлять один и тот же виджет нельзя, поэтому Layout_AddWidget меряется только здесь
+void BenchLayoutInsert(Results& results) {
+    const int counts[] = {10, 100, 1000, 10000};
+    for (int count : counts) {
+        Widget* window = Widget_New(NULL);
+        VBoxLayout* layout = VBoxLayout_New(window);
+        std::vector<Label*> labels;
+        for (int i = 0; i < count; ++i) {
+            labels.push_back(Label_New(window));
+        }
+        double start = NowNs();
+        for (Label* label : labels) {
+            Layout_AddWidget(layout, label);
+        }
+        results.emplace_back(std::to_string(count), (NowNs() - start) / count);
+        Object_Delete(window);
+    }
+}
+
+double BenchClick(PushButton* button) {
+    static volatile int clicks = 0;
+    PushButton_SetOnClicked(button, [](Object*) {
+        clicks = clicks + 1;
+    });
+    return MeasureNs(CallIterations, [=] { PushButton_Click(button); });
+}
+
+// Текущий RSS процесса в КБ (0, если /proc недоступен)
+double CurrentRssKb() {
+    FILE* statm = fopen("/proc/self/statm", "r");
+    if (statm == NULL) {
+        return 0;
+    }
+    long size = 0, resident = 0;
+    if (fscanf(statm, "%ld %ld", &size, &resident) != 2) {
+        resident = 0;
+    }
+    fclose(statm);
+    return resident * (sysconf(_SC_PAGESIZE) / 1024.0);
+}
+
+// Пересоздает экран из ChurnWidgets меток и кнопок ChurnRounds раз. Пулы должны
+//  переиспользовать блоки: обращений к куче (chunks) не больше, чем нужно на один круг
+void BenchChurn(Results& results) {
+    PoolStats labelsBefore = Label::GetPool().GetStats();
+    PoolStats buttonsBefore = PushButton::GetPool().GetStats();
+    double rssBefore = CurrentRssKb();
+    double start = NowNs();
+    for (int round = 0; round < ChurnRounds; ++round) {
+        Widget* window = Widget_New(NULL);
+        for (int i = 0; i < ChurnWidgets; ++i) {
+            Label_New(window);
+            PushButton_New(window);
+        }
+        Object_Delete(window);
+    }
+    double elapsed = NowNs() - start;
+
+    PoolStats labels = Label::GetPool().GetStats();
+    PoolStats buttons = PushButton::GetPool().GetStats();
+    results.emplace_back("cycles_per_sec", 2.0 * ChurnRounds * ChurnWidgets / (elapsed * 1e-9));
+    results.emplace_back("pool_allocations", labels.allocations - labelsBefore.allocations +
+        buttons.allocations - buttonsBefore.allocations);
+    results.emplace_back("pool_reused", labels.reused - labelsBefore.reused +
+        buttons.reused - buttonsBefore.reused);
+    results.emplace_back("pool_chunks", labels.chunks - labelsBefore.chunks +
+        buttons.chunks - buttonsBefore.chunks);
+    results.emplace_back("rss_before_kb", rssBefore);
+    results.emplace_back("rss_after_kb", CurrentRssKb());
+}
+
+// Строки вида "row N": строятся при запросе и нигде не хранятся
+struct NumberedListSource : public ListSource {
+    explicit NumberedListSource(int _count) : count(_count) {}
+
+    int GetRowCount() override {
+        return count;
+    }
+
+    QString GetRowText(int row) override {
+        return QString("row %1").arg(row);
+    }
+
+    int count;
+};
+
+// Время отрисовки кадра (grab рисует и скрытый виджет) и прирост RSS для списков разной
+//  длины; при виртуализации оба не должны зависеть от числа строк
+void BenchListView(Results& frameNs, Results& rssKb) {
+    for (int count : ListSizes) {
+        double rssBefore = CurrentRssKb();
+        Widget* window = Widget_New(NULL);
+        ListView* view = ListView_New(window);
+        view->resize(300, 600);
+        ListView_SetSource(view, new NumberedListSource(count));
+        frameNs.emplace_back(std::to_string(count), MeasureNs(ListFrames, [=] {
+            view->grab();
+        }));
+        rssKb.emplace_back(std::to_string(count), CurrentRssKb() - rssBefore);
+        Object_Delete(window);
+    }
+}
+
+// Сортировка и фильтр по столбцам из TableRows псевдослучайных значений, мс
+void BenchTableView(Results& results) {
+    std::shared_ptr<std::vector<int64_t>> ints = std::make_shared<std::vector<int64_t>>(TableRows);
+    std::shared_ptr<std::vector<double>> doubles = std::make_shared<std::vector<double>>(TableRows);
+    uint64_t state = 88172645463325252ull;
+    for (int row = 0; row < TableRows; ++row) {
+        state ^= state << 13;
+        state ^= state >> 7;
+        state ^= state << 17;
+        (*ints)[row] = (int64_t)(state % 1000000);
+        (*doubles)[row] = (double)(state >> 11) / (double)(1ull << 53);
+    }
+    std::vector<TableColumn> columns(2);
+    columns[0] = {"ints", TableColumnType_Int64, TableRows, ints->data(), NULL, ints};
+    columns[1] = {"doubles", TableColumnType_Float64, TableRows, doubles->data(), NULL, doubles};
+
+    Widget* window = Widget_New(NULL);
+    TableView* view = TableView_New(window);
+    TableView_SetColumns(view, std::move(columns));
+    const int iterations = 5;
+    results.emplace_back("sort_int64_ms",
+        MeasureNs(iterations, [=] { TableView_Sort(view, 0, false); TableView_Sort(view, -1, false); }) * 1e-6);
+    results.emplace_back("sort_float64_ms",
+        MeasureNs(iterations, [=] { TableView_Sort(view, 1, true); TableView_Sort(view, -1, false); }) * 1e-6);
+    results.emplace_back("filter_range_ms",
+        MeasureNs(iterations, [=] { TableView_FilterRange(view, 1, 0.25, 0.75); }) * 1e-6);
+    Object_Delete(window);
+}
+
+// Кадр Plot для рядов разной длины: рисуется не больше 2 * ширина точек, поэтому растет
+//  только прореживание, линейно и векторизованно. Плюс добавление порции из PlotChunk точек
+void BenchPlot(Results& results) {
+    std::vector<double> values(PlotSizes[sizeof(PlotSizes) / sizeof(PlotSizes[0]) - 1]);
+    for (size_t i = 0; i < values.size(); ++i) {
+        values[i] = (double)(i % 977) * ((i & 1) ? 1 : -1);
+    }
+    Widget* window = Widget_New(NULL);
+    Plot* plot = Plot_New(window);
+    plot->resize(1000, 300);
+    for (int count : PlotSizes) {
+        Plot_SetCapacity(plot, count);
+        Plot_SetSeries(plot, values.data(), count);
+        results.emplace_back("frame_ns_" + std::to_string(count), MeasureNs(PlotFrames, [=] {
+            plot->grab();
+        }));
+    }
+    results.emplace_back("append_chunk_ns", MeasureNs(CallIterations / 10, [&] {
+        Plot_Append(plot, values.data(), PlotChunk);
+    }));
+    Object_Delete(window);
+}
+
+// Поток пишет LogLinesPerSec строк в секунду по одной, а GUI-поток крутит цикл событий и
+//  рисует журнал раз в кадр. Самая долгая итерация показывает, тормозит ли журнал GUI
+void BenchLogView(Results& results) {
+    Widget* window = Widget_New(NULL);
+    LogView* view = LogView_New(window);
+    view->resize(600, 400);
+    std::atomic<bool> isDone(false);
+    std::atomic<long long> appended(0);
+    std::thread producer([&] {
+        double start = NowNs();
+        const int batch = LogLinesPerSec / 1000;
+        for (long long line = 0; NowNs() - start < LogSeconds * 1e9; ) {
+            for (int i = 0; i < batch; ++i, ++line) {
+                LogView_Append(view, QString("line %1: some log message").arg(line));
+            }
+            appended += batch;
+            // Держим темп: строка line должна выйти не раньше line / LogLinesPerSec секунд
+            while (NowNs() - start < line * 1e9 / LogLinesPerSec) {
+                std::this_thread::yield();
+            }
+        }
+        isDone = true;
+    });
+    double maxIterationNs = 0;
+    double lastPaint = NowNs();
+    while (!isDone) {
+        double start = NowNs();
+        QCoreApplication::processEvents();
+        if (start - lastPaint > 16e6) {
+            view->grab();
+            lastPaint = start;
+        }
+        maxIterationNs = std::max(maxIterationNs, NowNs() - start);
+    }
+    producer.join();
+    QCoreApplication::processEvents();
+    results.emplace_back("lines_per_sec", (double)appended / LogSeconds);
+    results.emplace_back("max_event_loop_iteration_ms", maxIterationNs * 1e-6);
+    results.emplace_back("line_count", LogView_GetLineCount(view));
+    Object_Delete(window);
+}
+
+// Кадр, в котором каждая из UpdateLabels меток получает UpdateWritesPerFrame записей текста
+//  через очередь: записи схлопываются в одно обновление на метку, а если текст не изменился -
+//  в ноль
+void BenchUpdates(Results& results) {
+    Widget* window = Widget_New(NULL);
+    std::vector<Label*> labels;
+    for (int i = 0; i < UpdateLabels; ++i) {
+        labels.push_back(Label_New(window));
+    }
+    int frame = 0;
+    auto writeFrame = [&](bool isChanged) {
+        std::string value = "value " + std::to_string(isChanged ? ++frame : 0);
+        QString text = QString::fromUtf8(value.c_str());
+        for (int write = 0; write < UpdateWritesPerFrame; ++write) {
+            for (Label* label : labels) {
+                Application_PostUpdate(Update_LabelText(label, text));
+            }
+        }
+        Application_FlushUpdates();
+    };
+    UpdateStats before = Application_GetUpdateStats();
+    results.emplace_back("changed_frame_ns", MeasureNs(UpdateFrames, [&] { writeFrame(true); }));
+    results.emplace_back("unchanged_frame_ns", MeasureNs(UpdateFrames, [&] { writeFrame(false); }));
+    UpdateStats after = Application_GetUpdateStats();
+    results.emplace_back("posted", after.posted - before.posted);
+    results.emplace_back("coalesced", after.coalesced - before.coalesced);
+    results.emplace_back("cancelled", after.cancelled - before.cancelled);
+    results.emplace_back("unchanged", after.unchanged - before.unchanged);
+    results.emplace_back("applied", after.applied - before.applied);
+    Object_Delete(window);
+}
+
+void WriteResults(FILE* out, const char* name, const Results& results) {
+    fprintf(out, "  \"%s\": {", name);
+    for (size_t i = 0; i < results.size(); ++i) {
+        fprintf(out, "%s\n    \"%s\": %.1f", i == 0 ? "" : ",", results[i].first.c_str(), results[i].second);
+    }
+    fprintf(out, "\n  },\n");
+}
+
+} // namespace
+
+int main(int argc, char* argv[]) {
+    if (getenv("QT_QPA_PLATFORM") == NULL) {
+        setenv("QT_QPA_PLATFORM", "offscreen", 1);
+    }
+
+    Application* app = Application_New();
+    Widget* window = Widget_New(NULL);
+    VBoxLayout* layout = VBoxLayout_New(window);
+    Widget_SetLayout(window, layout);
+    Label* label = Label_New(window);
+    PushButton* button = PushButton_New(window);
+
+    Results calls, create, layoutInsert, churn, listFrame, listRss, table, plot, log, updates;
+    BenchCalls(calls, window, layout, label, button);
+    BenchCreate(create);
+    BenchLayoutInsert(layoutInsert);
+    double click = BenchClick(button);
+    BenchChurn(churn);
+    BenchListView(listFrame, listRss);
+    BenchTableView(table);
+    BenchPlot(plot);
+    BenchLogView(log);
+    BenchUpdates(updates);
+
+    FILE* out = (argc > 1) ? fopen(argv[1], "w") : stdout;
+    if (out == NULL) {
+        perror(argv[1]);
+        return 1;
+    }
+    fprintf(out, "{\n  \"benchmark\": \"widgets_bench\",\n");
+    WriteResults(out, "calls_ns", calls);
+    WriteResults(out, "create_per_sec", create);
+    WriteResults(out, "layout_insert_ns", layoutInsert);
+    WriteResults(out, "churn", churn);
+    WriteResults(out, "list_view_frame_ns", listFrame);
+    WriteResults(out, "list_view_rss_kb", listRss);
+    WriteResults(out, "table_view", table);
+    WriteResults(out, "plot", plot);
+    WriteResults(out, "log_view", log);
+    WriteResults(out, "property_updates", updates);
+    fprintf(out, "  \"click_roundtrip_ns\": %.1f\n}\n", click);
+    if (out != stdout) {
+        fclose(out);
+    }
+
+    Object_Delete(window);
+    Object_Delete(app);
+    return 0;
+}
@@ -0,0 +1,680 @@
+"""
+Benchmark of the Python bindings, the counterpart of widgets_bench.cpp.
+
+Measures per-call latency of every _pywidgets function and pywidgets method,
+then throughput, scaling and memory of the heavier paths: widget creation and
+churn, layouts, click callbacks, views, text, apply_state, templates, the
+asyncio loop, background tasks and timers. Results are written as JSON to
+stdout or to the file given as the first argument:
+    PYTHONPATH=<build-dir> python3 widgets_bench.py [output.json]
+"""
+
+import array
+import asyncio
+import ctypes
+import itertools
+import json
+import os
+import socket
+import sys
+import time
+import timeit
+
+os.environ.setdefault("QT_QPA_PLATFORM", "offscreen")
+
+import _pywidgets as w
+import pywidgets as pw
+
+NUMBER = 100000
+# Конструкторы создают настоящие виджеты, поэтому их меряем на меньшем числе вызовов
+NEW_NUMBER = 10000
+REPEAT = 5
+LAYOUT_SIZES = (10, 100, 1000, 10000)
+CHURN_ROUNDS = 100
+CHURN_WIDGETS = 1000
+LIST_SIZES = (10, 1000, 100000, 10000000)
+IMAGE_SIZES = ((64, 64), (640, 480), (1920, 1080), (3840, 2160))
+LOG_BATCH = 1000
+TEXT_LENGTHS = (16, 10000)
+TEXT_OBJECTS = 256
+STATE_ROWS = (10, 100, 1000)
+STATE_NUMBER = 100
+TEMPLATE_INSTANCES = 10000
+LOOP_NUMBER = 10000
+TASK_NUMBER = 10000
+TIMER_COUNT = 1000
+TIMER_SECONDS = 1.0
+TEXT_ALPHABETS = (("latin1", "abcd\xe9"), ("ucs2", "abcd\u0436"), ("ucs4", "abcd\U0001f600"))
+
+
+def measure_ns(stmt, number=NUMBER):
+    return round(min(timeit.repeat(stmt, number=number, repeat=REPEAT)) / number * 1e9, 1)
+
+
+def fresh(make):
+    # Аргументы, которые нельзя переиспользовать между вызовами (виджет повторно
+    #  в layout не добавить, второй layout на виджет не поставить), готовим заранее
+    return iter([make() for _ in range(NEW_NUMBER * REPEAT)])
+
+
+def add_widget_stmt(add_widget, layout, new_label):
+    labels = fresh(new_label)
+    return lambda: add_widget(layout, next(labels))
+
+
+def new_layout_stmt(new_layout, new_widget):
+    parents = fresh(new_widget)
+    return lambda: new_layout(next(parents))
+
+
+def run_until(app, done, count):
+    # Завершения задач и post доставляются в GUI-поток, поэтому ждем их в цикле событий
+    async def wait_all():
+        while len(done) < count:
+            await asyncio.sleep(0)
+
+    loop = w.Application_NewEventLoop(app)
+    try:
+        loop.run_until_complete(wait_all())
+    finally:
+        loop.close()
+
+
+def table_columns(rows):
+    words = [("row %d" % i).encode() for i in range(rows)]
+    offsets = array.array("q", [0])
+    offsets.extend(itertools.accumulate(map(len, words)))
+    return [("id", array.array("q", range(rows))),
+            ("value", array.array("d", (i * 0.5 for i in range(rows)))),
+            ("name", offsets, b"".join(words))]
+
+
+def tick(*args):
+    pass
+
+
+def bench_functions(app):
+    window = w.Widget_New()
+    layout = w.VBoxLayout_New(window)
+    w.Widget_SetLayout(window, layout)
+    label = w.Label_New(window)
+    button = w.PushButton_New(window)
+    list_items = list(range(100))
+    list_view = w.ListView_New(window)
+    w.ListView_SetItems(list_view, list_items)
+    columns = table_columns(100)
+    table_view = w.TableView_New(window)
+    w.TableView_SetColumns(table_view, columns)
+    image = w.Image_New(window)
+    frame = bytearray(64 * 64 * 4)
+    plot = w.Plot_New(window)
+    points = array.array("d", range(100))
+    log = w.LogView_New(window)
+    lines = ["log line %d" % i for i in range(10)]
+    connected = w.PushButton_New(w.Widget_New())
+    done = []
+
+    def insert_and_remove():
+        list_items.append(0)
+        w.ListView_RowsInserted(list_view, 100, 100)
+        list_items.pop()
+        w.ListView_RowsRemoved(list_view, 100, 100)
+
+    results = {
+        "Widget_SetWindowTitle": measure_ns(lambda: w.Widget_SetWindowTitle(window, "title")),
+        "Widget_SetSize": measure_ns(lambda: w.Widget_SetSize(window, 400, 300)),
+        "Widget_SetVisible": measure_ns(lambda: w.Widget_SetVisible(window, False)),
+        "Widget_SetLayout": measure_ns(lambda: w.Widget_SetLayout(window, layout)),
+        "Label_SetText": measure_ns(lambda: w.Label_SetText(label, "text")),
+        "PushButton_SetText": measure_ns(lambda: w.PushButton_SetText(button, "text")),
+        "Object_GetClassName": measure_ns(lambda: w.Object_GetClassName(label)),
+        "Object_GetParent": measure_ns(lambda: w.Object_GetParent(label)),
+        "Object_GetHandle": measure_ns(lambda: w.Object_GetHandle(label)),
+        "Object_GetChildren": measure_ns(lambda: w.Object_GetChildren(button)),
+        "Object_Connect": measure_ns(lambda: w.Object_Connect(connected, "clicked", tick), NEW_NUMBER),
+        "ListView_SetItems": measure_ns(lambda: w.ListView_SetItems(list_view, list_items)),
+        "ListView_RowsChanged": measure_ns(lambda: w.ListView_RowsChanged(list_view, 0, 9)),
+        "ListView_RowsInserted+RowsRemoved": measure_ns(insert_and_remove),
+        "ListView_Reset": measure_ns(lambda: w.ListView_Reset(list_view)),
+        "TableView_SetColumns": measure_ns(lambda: w.TableView_SetColumns(table_view, columns), NEW_NUMBER),
+        "TableView_Sort": measure_ns(lambda: w.TableView_Sort(table_view, 1, True), NEW_NUMBER),
+        "TableView_FilterRange": measure_ns(lambda: w.TableView_FilterRange(table_view, 0, 10, 90), NEW_NUMBER),
+        "TableView_FilterContains": measure_ns(lambda: w.TableView_FilterContains(table_view, 2, "1"), NEW_NUMBER),
+        "TableView_ClearFilter": measure_ns(lambda: w.TableView_ClearFilter(table_view), NEW_NUMBER),
+        "TableView_Refresh": measure_ns(lambda: w.TableView_Refresh(table_view), NEW_NUMBER),
+        "Image_SetFrame": measure_ns(lambda: w.Image_SetFrame(image, frame, 64, 64, "rgba8888")),
+        "Image_GetStats": measure_ns(lambda: w.Image_GetStats(image)),
+        "Plot_SetSeries": measure_ns(lambda: w.Plot_SetSeries(plot, points)),
+        "Plot_Append": measure_ns(lambda: w.Plot_Append(plot, 1.0)),
+        "Plot_SetCapacity": measure_ns(lambda: w.Plot_SetCapacity(plot, 1000)),
+        "Plot_Clear": measure_ns(lambda: w.Plot_Clear(plot)),
+        "Plot_GetSize": measure_ns(lambda: w.Plot_GetSize(plot)),
+        "LogView_Append": measure_ns(lambda: w.LogView_Append(log, "log line")),
+        "LogView_AppendMany": measure_ns(lambda: w.LogView_AppendMany(log, lines)),
+        "LogView_SetMaxLines": measure_ns(lambda: w.LogView_SetMaxLines(log, 1000)),
+        "LogView_Clear": measure_ns(lambda: w.LogView_Clear(log)),
+        "LogView_GetLineCount": measure_ns(lambda: w.LogView_GetLineCount(log)),
+        "Application_PostSetText": measure_ns(lambda: w.Application_PostSetText([(label, "text")])),
+        "Application_PostSetWindowTitle": measure_ns(lambda: w.Application_PostSetWindowTitle([(window, "title")])),
+        "Application_PostSetSize": measure_ns(lambda: w.Application_PostSetSize([(window, 400, 300)])),
+        "Application_PostSetVisible": measure_ns(lambda: w.Application_PostSetVisible([(window, False)])),
+        "Application_FlushUpdates": measure_ns(lambda: w.Application_FlushUpdates(app)),
+        "Application_GetUpdateStats": measure_ns(lambda: w.Application_GetUpdateStats(app)),
+        "Application_NewEventLoop": measure_ns(lambda: w.Application_NewEventLoop(app).close(), NEW_NUMBER),
+        "Application_Submit": measure_ns(lambda: w.Application_Submit(app, abs, -1, on_done=done.append), NEW_NUMBER),
+        "Application_GetTaskStats": measure_ns(lambda: w.Application_GetTaskStats(app)),
+        # Таймер сразу отменяется, поэтому в строку входит и cancel
+        "Application_SetInterval": measure_ns(lambda: w.Application_SetInterval(app, 1000, tick).cancel(), NEW_NUMBER),
+        "Application_SetTimeout": measure_ns(lambda: w.Application_SetTimeout(app, 1000, tick).cancel(), NEW_NUMBER),
+        "Application_RequestFrame": measure_ns(lambda: w.Application_RequestFrame(app, tick).cancel(), NEW_NUMBER),
+        "Application_GetSchedulerStats": measure_ns(lambda: w.Application_GetSchedulerStats(app)),
+        "Layout_AddWidget": measure_ns(
+            add_widget_stmt(w.Layout_AddWidget, layout, lambda: w.Label_New(window)), NEW_NUMBER),
+        "Widget_New": measure_ns(lambda: w.Widget_New(), NEW_NUMBER),
+        "VBoxLayout_New": measure_ns(new_layout_stmt(w.VBoxLayout_New, w.Widget_New), NEW_NUMBER),
+        "Label_New": measure_ns(lambda: w.Label_New(window), NEW_NUMBER),
+        "PushButton_New": measure_ns(lambda: w.PushButton_New(window), NEW_NUMBER),
+        "ListView_New": measure_ns(lambda: w.ListView_New(window), NEW_NUMBER),
+        "TableView_New": measure_ns(lambda: w.TableView_New(window), NEW_NUMBER),
+        "Image_New": measure_ns(lambda: w.Image_New(window), NEW_NUMBER),
+        "Plot_New": measure_ns(lambda: w.Plot_New(window), NEW_NUMBER),
+        "LogView_New": measure_ns(lambda: w.LogView_New(window), NEW_NUMBER),
+    }
+    # Application_Exec крутит цикл событий до выхода, его стоимость видна в event_loop
+    run_until(app, done, NEW_NUMBER * REPEAT)
+    return results
+
+
+def bench_methods(app):
+    window = pw.Widget()
+    layout = pw.VBoxLayout(window)
+    window.set_layout(layout)
+    label = pw.Label(window)
+    button = pw.PushButton(window)
+    list_items = list(range(100))
+    list_view = pw.ListView(window)
+    list_view.set_items(list_items)
+    columns = table_columns(100)
+    table_view = pw.TableView(window)
+    table_view.set_columns(columns)
+    image = pw.Image(window)
+    frame = bytearray(64 * 64 * 4)
+    plot = pw.Plot(window)
+    points = array.array("d", range(100))
+    log = pw.LogView(window)
+    lines = ["log line %d" % i for i in range(10)]
+    connected = pw.PushButton(pw.Widget())
+    label_handle = label.handle()
+    window_handle = window.handle()
+    done = []
+    posted = []
+
+    def insert_and_remove():
+        list_items.append(0)
+        list_view.rows_inserted(100, 100)
+        list_items.pop()
+        list_view.rows_removed(100, 100)
+
+    results = {
+        "Widget.set_window_title": measure_ns(lambda: window.set_window_title("title")),
+        "Widget.set_size": measure_ns(lambda: window.set_size(400, 300)),
+        "Widget.set_visible": measure_ns(lambda: window.set_visible(False)),
+        "Widget.set_layout": measure_ns(lambda: window.set_layout(layout)),
+        "Object.get_class_name": measure_ns(lambda: label.get_class_name()),
+        "Object.parent": measure_ns(lambda: label.parent()),
+        "Object.handle": measure_ns(lambda: label.handle()),
+        "Object.children": measure_ns(lambda: button.children()),
+        "Object.connect": measure_ns(lambda: connected.connect("clicked", tick), NEW_NUMBER),
+        "Label.set_text": measure_ns(lambda: label.set_text("text")),
+        "PushButton.set_text": measure_ns(lambda: button.set_text("text")),
+        "ListView.set_items": measure_ns(lambda: list_view.set_items(list_items)),
+        "ListView.rows_changed": measure_ns(lambda: list_view.rows_changed(0, 9)),
+        "ListView.rows_inserted+rows_removed": measure_ns(insert_and_remove),
+        "ListView.reset": measure_ns(lambda: list_view.reset()),
+        "TableView.set_columns": measure_ns(lambda: table_view.set_columns(columns), NEW_NUMBER),
+        "TableView.sort": measure_ns(lambda: table_view.sort(1, True), NEW_NUMBER),
+        "TableView.filter_range": measure_ns(lambda: table_view.filter_range(0, 10, 90), NEW_NUMBER),
+        "TableView.filter_contains": measure_ns(lambda: table_view.filter_contains(2, "1"), NEW_NUMBER),
+        "TableView.clear_filter": measure_ns(lambda: table_view.clear_filter(), NEW_NUMBER),
+        "TableView.refresh": measure_ns(lambda: table_view.refresh(), NEW_NUMBER),
+        "TableView.row_count": measure_ns(lambda: table_view.row_count()),
+        "TableView.source_row": measure_ns(lambda: table_view.source_row(5)),
+        "Image.set_frame": measure_ns(lambda: image.set_frame(frame, 64, 64, "rgba8888")),
+        "Image.stats": measure_ns(lambda: image.stats()),
+        "Plot.set_series": measure_ns(lambda: plot.set_series(points)),
+        "Plot.append": measure_ns(lambda: plot.append(1.0)),
+        "Plot.set_capacity": measure_ns(lambda: plot.set_capacity(1000)),
+        "Plot.clear": measure_ns(lambda: plot.clear()),
+        "Plot.size": measure_ns(lambda: plot.size()),
+        "LogView.append": measure_ns(lambda: log.append("log line")),
+        "LogView.append_many": measure_ns(lambda: log.append_many(lines)),
+        "LogView.set_max_lines": measure_ns(lambda: log.set_max_lines(1000)),
+        "LogView.clear": measure_ns(lambda: log.clear()),
+        "LogView.line_count": measure_ns(lambda: log.line_count()),
+        "Application.post": measure_ns(lambda: app.post(lambda: posted.append(None)), NEW_NUMBER),
+        # Приложение создано через _pywidgets и обертки pywidgets не принимает, а handle - да
+        "Application.post_set_text": measure_ns(lambda: app.post_set_text([(label_handle, "text")])),
+        "Application.post_set_window_title": measure_ns(lambda: app.post_set_window_title([(window_handle, "title")])),
+        "Application.post_set_size": measure_ns(lambda: app.post_set_size([(window_handle, 400, 300)])),
+        "Application.post_set_visible": measure_ns(lambda: app.post_set_visible([(window_handle, False)])),
+        "Application.flush_updates": measure_ns(lambda: app.flush_updates()),
+        "Application.update_stats": measure_ns(lambda: app.update_stats()),
+        "Application.new_event_loop": measure_ns(lambda: app.new_event_loop().close(), NEW_NUMBER),
+        "Application.submit": measure_ns(lambda: app.submit(abs, -1, on_done=done.append), NEW_NUMBER),
+        "Application.task_stats": measure_ns(lambda: app.task_stats()),
+        "Application.set_interval": measure_ns(lambda: app.set_interval(1000, tick).cancel(), NEW_NUMBER),
+        "Application.set_timeout": measure_ns(lambda: app.set_timeout(1000, tick).cancel(), NEW_NUMBER),
+        "Application.request_frame": measure_ns(lambda: app.request_frame(tick).cancel(), NEW_NUMBER),
+        "Application.scheduler_stats": measure_ns(lambda: app.scheduler_stats()),
+        "VBoxLayout.add_widget": measure_ns(
+            add_widget_stmt(pw.VBoxLayout.add_widget, layout, lambda: pw.Label(window)), NEW_NUMBER),
+        "Widget()": measure_ns(lambda: pw.Widget(), NEW_NUMBER),
+        "VBoxLayout()": measure_ns(new_layout_stmt(pw.VBoxLayout, pw.Widget), NEW_NUMBER),
+        "Label()": measure_ns(lambda: pw.Label(window), NEW_NUMBER),
+        "PushButton()": measure_ns(lambda: pw.PushButton(window), NEW_NUMBER),
+        "ListView()": measure_ns(lambda: pw.ListView(window), NEW_NUMBER),
+        "TableView()": measure_ns(lambda: pw.TableView(window), NEW_NUMBER),
+        "Image()": measure_ns(lambda: pw.Image(window), NEW_NUMBER),
+        "Plot()": measure_ns(lambda: pw.Plot(window), NEW_NUMBER),
+        "LogView()": measure_ns(lambda: pw.LogView(window), NEW_NUMBER),
+    }
+    run_until(app, done, NEW_NUMBER * REPEAT)
+    run_until(app, posted, NEW_NUMBER * REPEAT)
+    return results
+
+
+def bench_create():
+    results = {}
+    for name, create in (("Widget_New", lambda parent: w.Widget_New()),
+                         ("Label_New", w.Label_New),
+                         ("PushButton_New", w.PushButton_New)):
+        best = 0.0
+        for _ in range(REPEAT):
+            parent = w.Widget_New()
+            created = []
+            start = time.perf_counter()
+            for _ in range(NEW_NUMBER):
+                created.append(create(parent))
+            best = max(best, NEW_NUMBER / (time.perf_counter() - start))
+            del created
+        results[name] = round(best, 1)
+    return results
+
+
+def bench_layout_insert():
+    results = {}
+    for count in LAYOUT_SIZES:
+        window = pw.Widget()
+        layout = pw.VBoxLayout(window)
+        labels = [pw.Label(window) for _ in range(count)]
+        start = time.perf_counter()
+        for label in labels:
+            layout.add_widget(label)
+        results[str(count)] = round((time.perf_counter() - start) / count * 1e9, 1)
+    return results
+
+
+def bench_click():
+    window = pw.Widget()
+    button = pw.PushButton(window)
+    clicks = []
+    button.set_on_clicked(clicks.append)
+    latency = measure_ns(button.click)
+    if not clicks:
+        raise RuntimeError("on_clicked callback was not called")
+    return latency
+
+
+def bench_connect():
+    # Тот же сигнал через Object.connect: аргумент checked проходит через план преобразования
+    window = pw.Widget()
+    button = pw.PushButton(window)
+    clicks = []
+    button.connect("clicked", clicks.append)
+    latency = measure_ns(button.click)
+    if not clicks:
+        raise RuntimeError("connected callback was not called")
+    return latency
+
+
+def current_rss_kb():
+    try:
+        with open("/proc/self/statm") as statm:
+            return int(statm.read().split()[1]) * os.sysconf("SC_PAGE_SIZE") // 1024
+    except (OSError, ValueError):
+        return 0
+
+
+def bench_churn():
+    # Обертки освобождаются в список свободных, виджеты - в пулы библиотеки, поэтому
+    #  после первого круга ни число блоков Python, ни RSS расти не должны
+    rss_before = current_rss_kb()
+    blocks_before = None
+    start = time.perf_counter()
+    for _ in range(CHURN_ROUNDS):
+        window = w.Widget_New()
+        children = [w.Label_New(window) for _ in range(CHURN_WIDGETS)]
+        children += [w.PushButton_New(window) for _ in range(CHURN_WIDGETS)]
+        del children, window
+        if blocks_before is None:
+            blocks_before = sys.getallocatedblocks()
+    elapsed = time.perf_counter() - start
+    return {
+        "cycles_per_sec": round(2 * CHURN_ROUNDS * CHURN_WIDGETS / elapsed, 1),
+        "allocated_blocks_growth": sys.getallocatedblocks() - blocks_before,
+        "rss_before_kb": rss_before,
+        "rss_after_kb": current_rss_kb(),
+    }
+
+
+def bench_list_view():
+    # Строки читаются только при отрисовке, поэтому привязка и уведомление не зависят
+    #  от длины: range и array.array не копируются
+    window = pw.Widget()
+    view = pw.ListView(window)
+    results = {}
+    for size in LIST_SIZES:
+        numbers = array.array("d", bytes(8 * min(size, 100000)))
+        results[str(size)] = {
+            "set_items_range_ns": measure_ns(lambda: view.set_items(range(size)), NEW_NUMBER),
+            "set_items_buffer_ns": measure_ns(lambda: view.set_items(numbers), NEW_NUMBER),
+            "rows_changed_ns": measure_ns(lambda: view.rows_changed(0, size - 1)),
+        }
+    return results
+
+
+def bench_image():
+    # Кадр не копируется, поэтому set_frame не должен зависеть от размера кадра.
+    #  Цикл событий не крутится, и все кадры, кроме последнего, пропускаются
+    window = pw.Widget()
+    image = pw.Image(window)
+    results = {}
+    for width, height in IMAGE_SIZES:
+        frames = [bytearray(width * height * 4) for _ in range(2)]
+        counter = itertools.count()
+        results["%dx%d" % (width, height)] = {
+            "set_frame_ns": measure_ns(
+                lambda: image.set_frame(frames[next(counter) & 1], width, height, "rgba8888")),
+        }
+    results["stats"] = image.stats()
+    return results
+
+
+def bench_log_view():
+    # Строки копятся в очереди и применяются раз в кадр, поэтому добавление не зависит
+    #  от длины журнала
+    window = pw.Widget()
+    log = pw.LogView(window)
+    lines = ["log line %d: some message" % i for i in range(LOG_BATCH)]
+    return {
+        "append_ns": measure_ns(lambda: log.append("log line: some message")),
+        "append_many_per_line_ns": round(measure_ns(lambda: log.append_many(lines), NEW_NUMBER // 10) / LOG_BATCH, 1),
+    }
+
+
+def bench_text():
+    # str не перекодируется в UTF-8: строка копируется из своего представления
+    #  с нужной шириной символа, а длинные строки при повторной установке берутся из кэша
+    window = pw.Widget()
+    label = pw.Label(window)
+    results = {}
+    for name, alphabet in TEXT_ALPHABETS:
+        for length in TEXT_LENGTHS:
+            text = (alphabet * (length // len(alphabet) + 1))[:length]
+            # Разных объектов больше, чем записей в кэше, поэтому каждый вызов - промах
+            texts = [text[:-1] + alphabet[i % len(alphabet)] for i in range(TEXT_OBJECTS)]
+            counter = itertools.count()
+            results["%s_%d" % (name, length)] = {
+                "same_str_ns": measure_ns(lambda: label.set_text(text)),
+                "new_str_ns": measure_ns(lambda: label.set_text(texts[next(counter) % TEXT_OBJECTS])),
+            }
+    return results
+
+
+def screen_state(rows, revision):
+    # Экран целиком, как его строит код приложения из своего состояния: в каждой
+    #  ревизии меняется текст одной строки
+    children = [{"type": "Label", "key": i, "props": {"text": "row %d" % i}} for i in range(rows)]
+    children[revision % rows] = {"type": "Label", "key": revision % rows, "props": {"text": "rev %d" % revision}}
+    children.append({"type": "PushButton", "key": "ok", "props": {"text": "OK"}})
+    return {"type": "Widget", "props": {"title": "screen", "size": (640, 480)}, "children": children}
+
+
+def bench_apply_state():
+    # Повторное применение трогает только изменившиеся свойства, поэтому стоит
+    #  разбора дерева, а не пересоздания виджетов
+    results = {}
+    for rows in STATE_ROWS:
+        window = pw.Widget()
+        start = time.perf_counter()
+        first = window.apply_state(screen_state(rows, 0))
+        mount_ns = (time.perf_counter() - start) * 1e9
+        states = [screen_state(rows, revision) for revision in range(1, STATE_NUMBER + 1)]
+        counter = itertools.count()
+        results[str(rows)] = {
+            "mount_ns": round(mount_ns, 1),
+            "mount": first,
+            "refresh_ns": measure_ns(lambda: window.apply_state(states[next(counter) % STATE_NUMBER]), STATE_NUMBER),
+            "refresh": window.apply_state(states[0]),
+        }
+    return results
+
+
+def card_texts(count):
+    return [text for i in range(count) for text in ("Card %d" % i, "details of card %d" % i)]
+
+
+def build_cards_per_call(layout, texts):
+    # Карточка - Widget с VBoxLayout, двумя Label и PushButton, по вызову на операцию
+    for i in range(len(texts) // 2):
+        card = w.Widget_New()
+        card_layout = w.VBoxLayout_New(card)
+        w.Widget_SetLayout(card, card_layout)
+        title = w.Label_New(card)
+        w.Label_SetText(title, texts[2 * i])
+        details = w.Label_New(card)
+        w.Label_SetText(details, texts[2 * i + 1])
+        button = w.PushButton_New(card)
+        w.PushButton_SetText(button, "Open")
+        w.Layout_AddWidget(card_layout, title)
+        w.Layout_AddWidget(card_layout, details)
+        w.Layout_AddWidget(card_layout, button)
+        w.Layout_AddWidget(layout, card)
+
+
+def card_template():
+    template = w.Template()
+    card = template.widget_new()
+    card_layout = template.vbox_layout_new(card)
+    title = template.label_new(card)
+    template.label_set_text(title, 0)
+    details = template.label_new(card)
+    template.label_set_text(details, 1)
+    button = template.push_button_new(card)
+    template.push_button_set_text(button, "Open")
+    for item in (title, details, button):
+        template.layout_add_widget(card_layout, item)
+    return template
+
+
+def bench_template(app):
+    # Те же карточки обоими способами: шаблон строит их одним вызовом, а тексты
+    #  берет из общего буфера UTF-8 по смещениям
+    texts = card_texts(TEMPLATE_INSTANCES)
+    encoded = [text.encode() for text in texts]
+    offsets = array.array("q", [0])
+    offsets.extend(itertools.accumulate(map(len, encoded)))
+    params = (offsets, b"".join(encoded))
+    template = card_template()
+    per_call = instantiate = float("inf")
+    for _ in range(REPEAT):
+        window = w.Widget_New()
+        layout = w.VBoxLayout_New(window)
+        w.Widget_SetLayout(window, layout)
+        start = time.perf_counter()
+        build_cards_per_call(layout, texts)
+        per_call = min(per_call, time.perf_counter() - start)
+
+        window = w.Widget_New()
+        w.Widget_SetLayout(window, w.VBoxLayout_New(window))
+        start = time.perf_counter()
+        template.instantiate(window, TEMPLATE_INSTANCES, params)
+        instantiate = min(instantiate, time.perf_counter() - start)
+    return {
+        "instances": TEMPLATE_INSTANCES,
+        "per_call_ms": round(per_call * 1e3, 2),
+        "instantiate_ms": round(instantiate * 1e3, 2),
+        "speedup": round(per_call / instantiate, 1),
+    }
+
+
+async def loop_iterations(count):
+    for _ in range(count):
+        await asyncio.sleep(0)
+
+
+async def loop_ping_pong(count):
+    # Байт туда и обратно через socketpair: ожидание готовности дескриптора в цикле
+    loop = asyncio.get_running_loop()
+    a, b = socket.socketpair()
+    a.setblocking(False)
+    b.setblocking(False)
+    with a, b:
+        for _ in range(count):
+            await loop.sock_sendall(a, b"x")
+            await loop.sock_recv(b, 1)
+            await loop.sock_sendall(b, b"y")
+            await loop.sock_recv(a, 1)
+
+
+def bench_event_loop(app):
+    # Цикл поверх Qt на каждой итерации обрабатывает события Qt, поэтому сравнивается
+    #  со стандартным SelectorEventLoop, который их не видит
+    results = {}
+    for name, new_loop in (("qt", lambda: w.Application_NewEventLoop(app)), ("default", asyncio.new_event_loop)):
+        loop = new_loop()
+        try:
+            results[name] = {
+                "iteration_ns": round(measure_ns(
+                    lambda: loop.run_until_complete(loop_iterations(LOOP_NUMBER)), 1) / LOOP_NUMBER, 1),
+                "ping_pong_ns": round(measure_ns(
+                    lambda: loop.run_until_complete(loop_ping_pong(LOOP_NUMBER // 10)), 1) / (LOOP_NUMBER // 10), 1),
+            }
+        finally:
+            loop.close()
+    return results
+
+
+def native_strlen_task(buffer):
+    # Капсула с strlen из libc: задача, которая выполняется без GIL
+    api = ctypes.pythonapi
+    api.PyCapsule_New.restype = ctypes.py_object
+    api.PyCapsule_New.argtypes = [ctypes.c_void_p, ctypes.c_char_p, ctypes.c_void_p]
+    api.PyCapsule_SetContext.argtypes = [ctypes.py_object, ctypes.c_void_p]
+    strlen = ctypes.cast(ctypes.CDLL(None).strlen, ctypes.c_void_p)
+    capsule = api.PyCapsule_New(strlen, b"pywidgets.native_task", None)
+    api.PyCapsule_SetContext(capsule, ctypes.addressof(buffer))
+    return capsule
+
+
+def bench_tasks(app):
+    # Завершения доставляются в GUI-поток, поэтому между отправкой и проверкой крутится цикл
+    results = {}
+    buffer = ctypes.create_string_buffer(b"native task")
+    loop = w.Application_NewEventLoop(app)
+    try:
+        for name, fn, args in (("python", abs, (-1,)), ("native", native_strlen_task(buffer), ())):
+            best = float("inf")
+            for _ in range(REPEAT):
+                done = []
+                before = w.Application_GetTaskStats(app)
+                start = time.perf_counter()
+                for _ in range(TASK_NUMBER):
+                    w.Application_Submit(app, fn, *args, on_done=done.append)
+
+                async def wait_all():
+                    while len(done) < TASK_NUMBER:
+                        await asyncio.sleep(0)
+
+                loop.run_until_complete(wait_all())
+                best = min(best, time.perf_counter() - start)
+            stats = w.Application_GetTaskStats(app)
+            results[name] = {
+                "tasks_per_sec": round(TASK_NUMBER / best),
+                "tasks_per_batch": round(TASK_NUMBER / max(1, stats["batches"] - before["batches"]), 1),
+                "avg_wait_ns": stats["avg_wait_ns"],
+                "avg_delivery_ns": stats["avg_delivery_ns"],
+            }
+        results["threads"] = stats["threads"]
+    finally:
+        loop.close()
+    return results
+
+
+def bench_timers(app):
+    # Интервалы с одним периодом попадают в одни кадры и вызываются одним проходом.
+    #  Окно показано, иначе таймеры притормаживаются как у скрытого окна
+    window = w.Widget_New()
+    w.Widget_SetVisible(window, True)
+    count = [0]
+
+    def tick():
+        count[0] += 1
+
+    before = w.Application_GetSchedulerStats(app)
+    timers = [w.Application_SetInterval(app, 16, tick, window) for _ in range(TIMER_COUNT)]
+    loop = w.Application_NewEventLoop(app)
+    try:
+        loop.run_until_complete(asyncio.sleep(TIMER_SECONDS))
+    finally:
+        loop.close()
+    after = w.Application_GetSchedulerStats(app)
+    stats = [timer.stats() for timer in timers]
+    for timer in timers:
+        timer.cancel()
+    w.Widget_SetVisible(window, False)
+    ticks = max(1, after["ticks"] - before["ticks"])
+    return {
+        "timers": TIMER_COUNT,
+        "fires": count[0],
+        "ticks": ticks,
+        "fires_per_tick": round(count[0] / ticks, 1),
+        "avg_run_ns": round(sum(s["avg_run_ns"] for s in stats) / len(stats), 1),
+        "avg_late_ns": round(sum(s["avg_late_ns"] for s in stats) / len(stats), 1),
+        "frame_interval_ns": after["frame_interval_ns"],
+    }
+
+
+def main():
+    # QApplication один на процесс, поэтому pywidgets использует приложение,
+    #  созданное через _pywidgets
+    app = w.Application_New()
+    results = {
+        "benchmark": "widgets_bench.py",
+        "functions_ns": bench_functions(app),
+        "methods_ns": bench_methods(app),
+        "create_per_sec": bench_create(),
+        "layout_insert_ns": bench_layout_insert(),
+        "click_roundtrip_ns": bench_click(),
+        "connect_roundtrip_ns": bench_connect(),
+        "churn": bench_churn(),
+        "list_view": bench_list_view(),
+        "image": bench_image(),
+        "log_view": bench_log_view(),
+        "text": bench_text(),
+        "apply_state": bench_apply_state(),
+        "template": bench_template(app),
+        "event_loop": bench_event_loop(app),
+        "tasks": bench_tasks(app),
+        "timers": bench_timers(app),
+    }
+    if len(sys.argv) > 1:
+        with open(sys.argv[1], "w") as out:
+            json.dump(results, out, indent=2)
+    else:
+        json.dump(results, sys.stdout, indent=2)
+        print()
+
+
+if __name__ == "__main__":
+    main()
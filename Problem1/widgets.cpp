@@ -4,25 +4,2635 @@
 
 #include "widgets.h"
 
-// Определяем конструкторы в .cpp файле, чтобы не мусорить наружу
-//  констатными строками с названиями классов (хоть и жертвуем inline-ом)
+#include <QFontMetrics>
+#include <QHash>
+#include <QHeaderView>
+#include <QPainter>
+#include <QPointer>
+#include <QRunnable>
+#include <QScreen>
+#include <QScrollBar>
+#include <QThreadPool>
+#include <QTimer>
 
-const char* ApplicationClassName = "Application";
-const char* WidgetClassName = "Widget";
-const char* VBoxLayoutClassName = "VBoxLayout";
-const char* PushButtonClassName = "PushButton";
+// AVX-ядра компилируются через __attribute__((target("avx"))) и выбираются во время
+//  выполнения, поэтому сборка без -mavx работает и на процессорах без AVX
+#if (defined(__GNUC__) || defined(__clang__)) && (defined(__x86_64__) || defined(__i386__)) && defined(__SSE2__)
+#define WIDGETS_AVX_DISPATCH
+#include <immintrin.h>
+#elif defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+#include <algorithm>
+#include <atomic>
+#include <limits>
+#include <cmath>
+#include <cstddef>
+#include <condition_variable>
+#include <cstring>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+namespace {
+
+// Каждый блок должен быть выровнен так же, как результат обычного operator new
+size_t AlignBlockSize(size_t size) {
+    const size_t alignment = alignof(std::max_align_t);
+    return (size + alignment - 1) / alignment * alignment;
+}
+
+} // namespace
+
+BlockPool::BlockPool(size_t _blockSize) :
+    blockSize(AlignBlockSize(std::max(_blockSize, sizeof(FreeBlock)))), freeList(NULL), stats() {}
+
+void* BlockPool::Allocate(size_t size) {
+    if (AlignBlockSize(size) != blockSize) {
+        return ::operator new(size);
+    }
+    if (freeList == NULL) {
+        char* chunk = static_cast<char*>(::operator new(blockSize * BlocksPerChunk));
+        for (size_t i = BlocksPerChunk; i > 0; --i) {
+            FreeBlock* block = reinterpret_cast<FreeBlock*>(chunk + (i - 1) * blockSize);
+            block->next = freeList;
+            freeList = block;
+        }
+        ++stats.chunks;
+    } else {
+        ++stats.reused;
+    }
+    FreeBlock* block = freeList;
+    freeList = block->next;
+    ++stats.allocations;
+    ++stats.inUse;
+    return block;
+}
+
+void BlockPool::Free(void* block, size_t size) {
+    if (block == NULL) {
+        return;
+    }
+    if (AlignBlockSize(size) != blockSize) {
+        ::operator delete(block);
+        return;
+    }
+    FreeBlock* freeBlock = static_cast<FreeBlock*>(block);
+    freeBlock->next = freeList;
+    freeList = freeBlock;
+    --stats.inUse;
+}
+
+PoolStats BlockPool::GetStats() const {
+    return stats;
+}
+
+//----------------------------------------------------------------------------------------
+
+// Определения нужны для odr-использования констант с именами классов
+
+constexpr const char* Application::TypeName;
+constexpr const char* Widget::TypeName;
+constexpr const char* VBoxLayout::TypeName;
+constexpr const char* Label::TypeName;
+constexpr const char* PushButton::TypeName;
+constexpr const char* ListView::TypeName;
+constexpr const char* TableView::TypeName;
+constexpr const char* Image::TypeName;
+constexpr const char* Plot::TypeName;
+constexpr const char* LogView::TypeName;
 
 Application::Application() :
-    QApplication(argc, argv), Object(ApplicationClassName) {}
+    QApplication(argc, argv), Object(TypeName), taskPool(new TaskPool(GetQObject())),
+    scheduler(new Scheduler()) {}
+
+// Пул и планировщик удаляются раньше QApplication, пока получатель завершений пула еще жив
+Application::~Application() {}
 
 int Application::argc = 1;
 char* Application::argv[] = {"Widget.exe"};
 
+namespace {
+
+// Ожидание Application_Invoke
+struct InvokeWait {
+    std::mutex mutex;
+    std::condition_variable finished;
+    bool isFinished = false;
+    bool isExecuted = false;
+};
+
+// Вызов в очереди держит ее через shared_ptr, и последняя копия будит ожидающий поток -
+//  и после выполнения, и когда Qt удаляет невыполненные события вместе с приложением
+struct InvokeCompletion {
+    std::shared_ptr<InvokeWait> wait;
+
+    ~InvokeCompletion() {
+        std::lock_guard<std::mutex> lock(wait->mutex);
+        wait->isFinished = true;
+        wait->finished.notify_all();
+    }
+};
+
+} // namespace
+
+bool Application_Invoke(std::function<void()> task) {
+    QCoreApplication* app = QCoreApplication::instance();
+    if (app == NULL || app->thread() == QThread::currentThread()) {
+        task();
+        return true;
+    }
+    std::shared_ptr<InvokeWait> wait = std::make_shared<InvokeWait>();
+    std::shared_ptr<InvokeCompletion> completion = std::make_shared<InvokeCompletion>();
+    completion->wait = wait;
+    QMetaObject::invokeMethod(app, [completion, task]() {
+        task();
+        std::lock_guard<std::mutex> lock(completion->wait->mutex);
+        completion->wait->isExecuted = true;
+    }, Qt::QueuedConnection);
+    completion.reset();
+
+    std::unique_lock<std::mutex> lock(wait->mutex);
+    wait->finished.wait(lock, [&wait]() { return wait->isFinished; });
+    return wait->isExecuted;
+}
+
 Widget::Widget(Widget* parent) :
-    QWidget(parent), Object(WidgetClassName) {}
+    QWidget(parent), Object(TypeName) {}
 
 VBoxLayout::VBoxLayout(Widget* parent) :
-    QVBoxLayout(parent), Object(VBoxLayoutClassName) {}
+    QVBoxLayout(parent), Object(TypeName) {}
 
 PushButton::PushButton(Widget* parent) :
-    QPushButton(parent), Object(PushButtonClassName) {}
+    QPushButton(parent), Object(TypeName) {}
+
+//----------------------------------------------------------------------------------------
+
+ListModel::ListModel(QObject* parent) :
+    QAbstractListModel(parent), rows(0) {}
+
+void ListModel::SetSource(ListSource* _source) {
+    beginResetModel();
+    source.reset(_source);
+    rows = (source != NULL) ? source->GetRowCount() : 0;
+    endResetModel();
+}
+
+QString ListModel::GetRowText(int row) const {
+    if (source == NULL || row < 0 || row >= rows) {
+        return QString();
+    }
+    return source->GetRowText(row);
+}
+
+void ListModel::RowsChanged(int first, int last) {
+    first = std::max(first, 0);
+    last = std::min(last, rows - 1);
+    if (first <= last) {
+        Q_EMIT dataChanged(index(first), index(last));
+    }
+}
+
+void ListModel::RowsInserted(int first, int last) {
+    if (first < 0 || first > rows || last < first) {
+        return;
+    }
+    beginInsertRows(QModelIndex(), first, last);
+    rows += last - first + 1;
+    endInsertRows();
+}
+
+void ListModel::RowsRemoved(int first, int last) {
+    first = std::max(first, 0);
+    last = std::min(last, rows - 1);
+    if (first > last) {
+        return;
+    }
+    beginRemoveRows(QModelIndex(), first, last);
+    rows -= last - first + 1;
+    endRemoveRows();
+}
+
+void ListModel::Reset() {
+    beginResetModel();
+    rows = (source != NULL) ? source->GetRowCount() : 0;
+    endResetModel();
+}
+
+int ListModel::rowCount(const QModelIndex& parent) const {
+    return parent.isValid() ? 0 : rows;
+}
+
+QVariant ListModel::data(const QModelIndex& index, int role) const {
+    if (role != Qt::DisplayRole || !index.isValid()) {
+        return QVariant();
+    }
+    return GetRowText(index.row());
+}
+
+ListView::ListView(Widget* parent) :
+    QAbstractScrollArea(parent), Object(TypeName), model(new ListModel(GetQObject()))
+{
+    // Сигналы модели приходят и от сторонних представлений, подключенных к ней
+    QObject::connect(model, &QAbstractItemModel::dataChanged, [this]() {
+        viewport()->update();
+    });
+    QObject::connect(model, &QAbstractItemModel::rowsInserted, [this]() {
+        UpdateRows();
+    });
+    QObject::connect(model, &QAbstractItemModel::rowsRemoved, [this]() {
+        UpdateRows();
+    });
+    QObject::connect(model, &QAbstractItemModel::modelReset, [this]() {
+        UpdateRows();
+    });
+    UpdateRows();
+}
+
+int ListView::GetRowHeight() const {
+    return std::max(fontMetrics().height() + 2, 1);
+}
+
+int ListView::GetVisibleRowCount() const {
+    return std::max(viewport()->height() / GetRowHeight(), 1);
+}
+
+// Полоса прокрутки считает в строках, а не в пикселях
+void ListView::UpdateRows() {
+    int visible = GetVisibleRowCount();
+    verticalScrollBar()->setRange(0, std::max(model->rowCount() - visible, 0));
+    verticalScrollBar()->setPageStep(visible);
+    verticalScrollBar()->setSingleStep(1);
+    viewport()->update();
+}
+
+void ListView::paintEvent(QPaintEvent*) {
+    QPainter painter(viewport());
+    int rowHeight = GetRowHeight();
+    int first = verticalScrollBar()->value();
+    // Нижняя строка может быть видна частично
+    int last = std::min(first + GetVisibleRowCount() + 1, model->rowCount());
+    int width = viewport()->width();
+    for (int row = first; row < last; ++row) {
+        QRect rect(4, (row - first) * rowHeight, width - 8, rowHeight);
+        painter.drawText(rect, Qt::AlignLeft | Qt::AlignVCenter, model->GetRowText(row));
+    }
+}
+
+void ListView::resizeEvent(QResizeEvent*) {
+    UpdateRows();
+}
+
+void ListView::scrollContentsBy(int, int) {
+    viewport()->update();
+}
+
+//----------------------------------------------------------------------------------------
+
+namespace {
+
+// Меньше строк сортируем и фильтруем в одном потоке: передача кусков в пул дороже
+const size_t ParallelThreshold = 1 << 16;
+
+size_t GetTaskCount(size_t count) {
+    size_t threads = std::max(std::thread::hardware_concurrency(), 1u);
+    return std::max<size_t>(std::min(threads, count / (ParallelThreshold / 2)), 1);
+}
+
+// Общее состояние одного RunParallel. Куски разбирают вызывающий поток и потоки
+//  глобального пула; поток пула, запущенный после разбора всех кусков, сразу выходит
+struct ParallelRun {
+    const std::function<void(size_t task)>* task;
+    size_t tasks;
+    std::atomic<size_t> next{0};
+    std::mutex mutex;
+    std::condition_variable finished;
+    size_t done = 0;
+
+    void RunTasks() {
+        for (size_t i = next++; i < tasks; i = next++) {
+            (*task)(i);
+            std::lock_guard<std::mutex> lock(mutex);
+            if (++done == tasks) {
+                finished.notify_all();
+            }
+        }
+    }
+};
+
+class ParallelRunnable : public QRunnable {
+public:
+    explicit ParallelRunnable(std::shared_ptr<ParallelRun> _state) : state(std::move(_state)) {}
+
+    void run() override {
+        state->RunTasks();
+    }
+
+private:
+    std::shared_ptr<ParallelRun> state;
+};
+
+// Выполняет task(0) ... task(tasks - 1) в вызывающем потоке и потоках QThreadPool::globalInstance().
+//  Ждет только выполнения кусков, а не запуска помощников: если пул занят задачами TaskPool,
+//  вызывающий поток доделает все сам
+void RunParallel(size_t tasks, const std::function<void(size_t task)>& task) {
+    if (tasks <= 1) {
+        if (tasks == 1) {
+            task(0);
+        }
+        return;
+    }
+    std::shared_ptr<ParallelRun> state = std::make_shared<ParallelRun>();
+    state->task = &task;
+    state->tasks = tasks;
+    QThreadPool* pool = QThreadPool::globalInstance();
+    size_t helpers = std::min<size_t>(tasks - 1, (size_t)std::max(pool->maxThreadCount(), 1));
+    for (size_t i = 0; i < helpers; ++i) {
+        pool->start(new ParallelRunnable(state));
+    }
+    state->RunTasks();
+    std::unique_lock<std::mutex> lock(state->mutex);
+    state->finished.wait(lock, [&] { return state->done == tasks; });
+}
+
+// Сортирует куски order параллельно и сливает их попарно, тоже параллельно
+template <typename Less>
+void ParallelSort(std::vector<int>& order, Less less) {
+    size_t tasks = GetTaskCount(order.size());
+    std::vector<size_t> bounds;
+    for (size_t i = 0; i <= tasks; ++i) {
+        bounds.push_back(order.size() * i / tasks);
+    }
+    RunParallel(tasks, [&](size_t task) {
+        std::sort(order.begin() + bounds[task], order.begin() + bounds[task + 1], less);
+    });
+    while (bounds.size() > 2) {
+        size_t merges = (bounds.size() - 1) / 2;
+        RunParallel(merges, [&](size_t merge) {
+            std::inplace_merge(order.begin() + bounds[2 * merge], order.begin() + bounds[2 * merge + 1],
+                order.begin() + bounds[2 * merge + 2], less);
+        });
+        std::vector<size_t> merged;
+        for (size_t i = 0; i < bounds.size(); i += 2) {
+            merged.push_back(bounds[i]);
+        }
+        if (merged.back() != bounds.back()) {
+            merged.push_back(bounds.back());
+        }
+        bounds.swap(merged);
+    }
+}
+
+// Номера строк, для которых keep истинно, в порядке возрастания
+std::vector<int> ParallelFilter(int rows, const std::function<bool(int row)>& keep) {
+    size_t tasks = GetTaskCount(rows);
+    std::vector<std::vector<int>> parts(tasks);
+    RunParallel(tasks, [&](size_t task) {
+        int begin = (int)(rows * (int64_t)task / tasks);
+        int end = (int)(rows * (int64_t)(task + 1) / tasks);
+        for (int row = begin; row < end; ++row) {
+            if (keep(row)) {
+                parts[task].push_back(row);
+            }
+        }
+    });
+    std::vector<int> result;
+    for (const std::vector<int>& part : parts) {
+        result.insert(result.end(), part.begin(), part.end());
+    }
+    return result;
+}
+
+// Сравнение значений: отрицательное, ноль или положительное
+template <typename T>
+int CompareValues(T a, T b) {
+    return (a < b) ? -1 : (a > b);
+}
+
+// Порядок байтов UTF-8 совпадает с порядком кодовых точек
+int CompareStrings(const TableColumn& column, int a, int b) {
+    const char* data = (const char*)column.values;
+    int64_t lengthA = column.offsets[a + 1] - column.offsets[a];
+    int64_t lengthB = column.offsets[b + 1] - column.offsets[b];
+    int result = memcmp(data + column.offsets[a], data + column.offsets[b], std::min(lengthA, lengthB));
+    return (result != 0) ? result : CompareValues(lengthA, lengthB);
+}
+
+// Равные значения остаются в исходном порядке строк, поэтому результат не зависит
+//  от разбиения на куски
+template <typename Compare>
+void SortRows(std::vector<int>& order, Compare compare) {
+    ParallelSort(order, [&](int a, int b) {
+        int result = compare(a, b);
+        return (result != 0) ? result < 0 : a < b;
+    });
+}
+
+} // namespace
+
+TableModel::TableModel(QObject* parent) :
+    QAbstractTableModel(parent), rows(0), sortColumn(-1), sortOrder(Qt::AscendingOrder) {}
+
+void TableModel::SetColumns(std::vector<TableColumn> _columns) {
+    beginResetModel();
+    columns = std::move(_columns);
+    rows = columns.empty() ? 0 : columns[0].rows;
+    filter = nullptr;
+    sortColumn = -1;
+    order.clear();
+    for (int row = 0; row < rows; ++row) {
+        order.push_back(row);
+    }
+    endResetModel();
+}
+
+const TableColumn* TableModel::GetColumn(int column) const {
+    return (column >= 0 && column < (int)columns.size()) ? &columns[column] : NULL;
+}
+
+int TableModel::GetSourceRow(int row) const {
+    return (row >= 0 && row < (int)order.size()) ? order[row] : -1;
+}
+
+void TableModel::sort(int column, Qt::SortOrder _order) {
+    sortColumn = (GetColumn(column) != NULL) ? column : -1;
+    sortOrder = _order;
+    Rebuild();
+}
+
+void TableModel::FilterRange(int column, double low, double high) {
+    const TableColumn* target = GetColumn(column);
+    if (target == NULL || target->type == TableColumnType_String) {
+        return;
+    }
+    if (target->type == TableColumnType_Int64) {
+        // Границы округляются внутрь и сравниваются как int64: double теряет точность
+        //  значений больше 2^53. NaN в границах не оставляет ни одной строки
+        const double limit = 9223372036854775808.0;  // 2^63
+        low = std::ceil(low);
+        high = std::floor(high);
+        if (!(low <= high) || low >= limit || high < -limit) {
+            filter = [](int) { return false; };
+        } else {
+            FilterRangeInt64(column, (low < -limit) ? std::numeric_limits<int64_t>::min() : (int64_t)low,
+                (high >= limit) ? std::numeric_limits<int64_t>::max() : (int64_t)high);
+            return;
+        }
+    } else {
+        const double* values = (const double*)target->values;
+        filter = [values, low, high](int row) {
+            return low <= values[row] && values[row] <= high;
+        };
+    }
+    Rebuild();
+}
+
+void TableModel::FilterRangeInt64(int column, int64_t low, int64_t high) {
+    const TableColumn* target = GetColumn(column);
+    if (target == NULL || target->type != TableColumnType_Int64) {
+        FilterRange(column, (double)low, (double)high);
+        return;
+    }
+    const int64_t* values = (const int64_t*)target->values;
+    filter = [values, low, high](int row) {
+        return low <= values[row] && values[row] <= high;
+    };
+    Rebuild();
+}
+
+void TableModel::FilterContains(int column, const QByteArray& utf8) {
+    const TableColumn* target = GetColumn(column);
+    if (target == NULL || target->type != TableColumnType_String) {
+        return;
+    }
+    std::string needle(utf8.constData(), utf8.size());
+    const char* data = (const char*)target->values;
+    const int64_t* offsets = target->offsets;
+    filter = [needle, data, offsets](int row) {
+        const char* begin = data + offsets[row];
+        const char* end = data + offsets[row + 1];
+        return std::search(begin, end, needle.begin(), needle.end()) != end;
+    };
+    Rebuild();
+}
+
+void TableModel::ClearFilter() {
+    filter = nullptr;
+    Rebuild();
+}
+
+void TableModel::Refresh() {
+    Rebuild();
+}
+
+// Столбцы могут удерживаться другим кодом, поэтому порядок строится заново целиком
+void TableModel::Rebuild() {
+    beginResetModel();
+    if (filter) {
+        order = ParallelFilter(rows, filter);
+    } else {
+        order.resize(rows);
+        for (int row = 0; row < rows; ++row) {
+            order[row] = row;
+        }
+    }
+    const TableColumn* column = GetColumn(sortColumn);
+    int sign = (sortOrder == Qt::DescendingOrder) ? -1 : 1;
+    if (column != NULL && column->type == TableColumnType_Int64) {
+        const int64_t* values = (const int64_t*)column->values;
+        SortRows(order, [values, sign](int a, int b) {
+            return sign * CompareValues(values[a], values[b]);
+        });
+    } else if (column != NULL && column->type == TableColumnType_Float64) {
+        const double* values = (const double*)column->values;
+        SortRows(order, [values, sign](int a, int b) {
+            // NaN в конце при любом направлении
+            if (std::isnan(values[a]) || std::isnan(values[b])) {
+                return (int)std::isnan(values[a]) - (int)std::isnan(values[b]);
+            }
+            return sign * CompareValues(values[a], values[b]);
+        });
+    } else if (column != NULL) {
+        SortRows(order, [column, sign](int a, int b) {
+            return sign * CompareStrings(*column, a, b);
+        });
+    }
+    endResetModel();
+}
+
+int TableModel::rowCount(const QModelIndex& parent) const {
+    return parent.isValid() ? 0 : (int)order.size();
+}
+
+int TableModel::columnCount(const QModelIndex& parent) const {
+    return parent.isValid() ? 0 : (int)columns.size();
+}
+
+QVariant TableModel::data(const QModelIndex& index, int role) const {
+    const TableColumn* column = GetColumn(index.column());
+    int row = GetSourceRow(index.row());
+    if (column == NULL || row < 0) {
+        return QVariant();
+    }
+    if (role == Qt::TextAlignmentRole) {
+        int horizontal = (column->type == TableColumnType_String) ? Qt::AlignLeft : Qt::AlignRight;
+        return QVariant(horizontal | Qt::AlignVCenter);
+    }
+    if (role != Qt::DisplayRole) {
+        return QVariant();
+    }
+    switch (column->type) {
+    case TableColumnType_Int64:
+        return QString::number((qlonglong)((const int64_t*)column->values)[row]);
+    case TableColumnType_Float64:
+        return QString::number(((const double*)column->values)[row]);
+    default:
+        return QString::fromUtf8((const char*)column->values + column->offsets[row],
+            (int)(column->offsets[row + 1] - column->offsets[row]));
+    }
+}
+
+QVariant TableModel::headerData(int section, Qt::Orientation orientation, int role) const {
+    if (role != Qt::DisplayRole) {
+        return QVariant();
+    }
+    if (orientation == Qt::Vertical) {
+        return section + 1;
+    }
+    const TableColumn* column = GetColumn(section);
+    return (column != NULL) ? QVariant(column->name) : QVariant();
+}
+
+TableView::TableView(Widget* parent) :
+    QTableView(parent), Object(TypeName), model(new TableModel(GetQObject()))
+{
+    setModel(model);
+    setWordWrap(false);
+    // Строки одной высоты: Qt не спрашивает размер каждой строки у модели
+    verticalHeader()->setSectionResizeMode(QHeaderView::Fixed);
+    horizontalHeader()->setSortIndicator(-1, Qt::AscendingOrder);
+    setSortingEnabled(true);
+}
+
+void TableView_SetColumns(TableView* view, std::vector<TableColumn> columns) {
+    view->GetModel()->SetColumns(std::move(columns));
+    view->horizontalHeader()->setSortIndicator(-1, Qt::AscendingOrder);
+}
+
+void TableView_Sort(TableView* view, int column, bool descending) {
+    Qt::SortOrder order = descending ? Qt::DescendingOrder : Qt::AscendingOrder;
+    if (column < 0) {
+        view->horizontalHeader()->setSortIndicator(-1, order);
+        view->GetModel()->sort(-1, order);
+    } else {
+        view->sortByColumn(column, order);
+    }
+}
+
+//----------------------------------------------------------------------------------------
+
+Image::Image(Widget* parent) :
+    QWidget(parent), Object(TypeName), hasBack(false), isUpdateScheduled(false), stats() {}
+
+// Другие потоки доходят до виджета через обертку: отвязываем ее, пока кадры еще живы
+Image::~Image() {
+    NotifyDestroyed();
+}
+
+void Image::SetFrame(ImageFrame frame) {
+    ImageFrame dropped;
+    bool shouldSchedule = false;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        if (hasBack) {
+            dropped = std::move(back);
+            ++stats.dropped;
+        }
+        back = std::move(frame);
+        hasBack = true;
+        ++stats.submitted;
+        shouldSchedule = !isUpdateScheduled;
+        isUpdateScheduled = true;
+    }
+    // Одна перерисовка на сколько угодно кадров, пришедших до нее. Если виджет удален
+    //  раньше, Qt отменит вызов вместе с ним
+    if (shouldSchedule) {
+        QMetaObject::invokeMethod(GetQObject(), [this]() {
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                isUpdateScheduled = false;
+            }
+            update();
+        }, Qt::QueuedConnection);
+    }
+}
+
+ImageStats Image::GetStats() {
+    std::lock_guard<std::mutex> lock(mutex);
+    return stats;
+}
+
+// Предыдущий кадр отпускается после отрисовки, вне блокировки: освобождение чужой памяти
+//  может ждать (для буфера Python - GIL)
+void Image::paintEvent(QPaintEvent*) {
+    ImageFrame previous;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        if (hasBack) {
+            previous = std::move(front);
+            front = std::move(back);
+            back = ImageFrame();
+            hasBack = false;
+            ++stats.shown;
+        }
+    }
+    if (front.image.isNull()) {
+        return;
+    }
+    // Вписываем с сохранением пропорций
+    QSize size = front.image.size().scaled(width(), height(), Qt::KeepAspectRatio);
+    QRect target((width() - size.width()) / 2, (height() - size.height()) / 2, size.width(), size.height());
+    QPainter painter(this);
+    painter.drawImage(target, front.image);
+}
+
+//----------------------------------------------------------------------------------------
+
+namespace {
+
+// Ядра MinMax обрабатывают начало data целыми блоками, расширяя [*low, *high], и
+//  возвращают число обработанных значений; хвост доделывает MinMax. min_pd(v, acc)
+//  при NaN в v возвращает acc, поэтому NaN пропускаются без отдельной проверки,
+//  как и в скалярном хвосте. Два независимых аккумулятора, чтобы не ждать задержки min/max
+#if defined(WIDGETS_AVX_DISPATCH)
+__attribute__((target("avx")))
+size_t MinMaxAvx(const double* data, size_t count, double* low, double* high) {
+    if (count < 8) {
+        return 0;
+    }
+    __m256d low0 = _mm256_set1_pd(*low), low1 = low0;
+    __m256d high0 = _mm256_set1_pd(*high), high1 = high0;
+    size_t i = 0;
+    for (; i + 8 <= count; i += 8) {
+        __m256d v0 = _mm256_loadu_pd(data + i);
+        __m256d v1 = _mm256_loadu_pd(data + i + 4);
+        low0 = _mm256_min_pd(v0, low0);
+        low1 = _mm256_min_pd(v1, low1);
+        high0 = _mm256_max_pd(v0, high0);
+        high1 = _mm256_max_pd(v1, high1);
+    }
+    double lows[4], highs[4];
+    _mm256_storeu_pd(lows, _mm256_min_pd(low0, low1));
+    _mm256_storeu_pd(highs, _mm256_max_pd(high0, high1));
+    for (int lane = 0; lane < 4; ++lane) {
+        *low = std::min(*low, lows[lane]);
+        *high = std::max(*high, highs[lane]);
+    }
+    return i;
+}
+
+// Проверка один раз на процесс
+bool HasAvx() {
+    static const bool hasAvx = [] {
+        __builtin_cpu_init();
+        return __builtin_cpu_supports("avx") != 0;
+    }();
+    return hasAvx;
+}
+#endif
+
+#if defined(__SSE2__)
+size_t MinMaxSse2(const double* data, size_t count, double* low, double* high) {
+    if (count < 4) {
+        return 0;
+    }
+    __m128d low0 = _mm_set1_pd(*low), low1 = low0;
+    __m128d high0 = _mm_set1_pd(*high), high1 = high0;
+    size_t i = 0;
+    for (; i + 4 <= count; i += 4) {
+        __m128d v0 = _mm_loadu_pd(data + i);
+        __m128d v1 = _mm_loadu_pd(data + i + 2);
+        low0 = _mm_min_pd(v0, low0);
+        low1 = _mm_min_pd(v1, low1);
+        high0 = _mm_max_pd(v0, high0);
+        high1 = _mm_max_pd(v1, high1);
+    }
+    double lows[2], highs[2];
+    _mm_storeu_pd(lows, _mm_min_pd(low0, low1));
+    _mm_storeu_pd(highs, _mm_max_pd(high0, high1));
+    for (int lane = 0; lane < 2; ++lane) {
+        *low = std::min(*low, lows[lane]);
+        *high = std::max(*high, highs[lane]);
+    }
+    return i;
+}
+#endif
+
+// Расширяет [*minValue, *maxValue] значениями data, пропуская NaN. AVX - если его
+//  поддерживает процессор, иначе SSE2, который есть на любом x86-64
+void MinMax(const double* data, size_t count, double* minValue, double* maxValue) {
+    double low = *minValue, high = *maxValue;
+    size_t i = 0;
+#if defined(WIDGETS_AVX_DISPATCH)
+    i = HasAvx() ? MinMaxAvx(data, count, &low, &high) : MinMaxSse2(data, count, &low, &high);
+#elif defined(__SSE2__)
+    i = MinMaxSse2(data, count, &low, &high);
+#endif
+    for (; i < count; ++i) {
+        double value = data[i];
+        if (value < low) {
+            low = value;
+        }
+        if (value > high) {
+            high = value;
+        }
+    }
+    *minValue = low;
+    *maxValue = high;
+}
+
+} // namespace
+
+Plot::Plot(Widget* parent) :
+    QWidget(parent), Object(TypeName),
+    capacity(PlotDefaultCapacity), head(0), size(0), isUpdateScheduled(false) {}
+
+// Как ~Image
+Plot::~Plot() {
+    NotifyDestroyed();
+}
+
+void Plot::SetCapacity(size_t newCapacity) {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        // Разворачиваем кольцо, оставляя последние точки
+        std::vector<double> points;
+        size_t kept = std::min(size, newCapacity);
+        if (kept > 0) {
+            points.resize(newCapacity);
+            for (size_t i = 0; i < kept; ++i) {
+                points[i] = ring[(head + size - kept + i) % capacity];
+            }
+        }
+        ring.swap(points);
+        capacity = newCapacity;
+        head = 0;
+        size = kept;
+    }
+    ScheduleUpdate();
+}
+
+void Plot::SetSeries(const double* values, size_t count) {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        head = 0;
+        size = 0;
+        AppendLocked(values, count);
+    }
+    ScheduleUpdate();
+}
+
+void Plot::Append(const double* values, size_t count) {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        AppendLocked(values, count);
+    }
+    ScheduleUpdate();
+}
+
+size_t Plot::GetSize() {
+    std::lock_guard<std::mutex> lock(mutex);
+    return size;
+}
+
+void Plot::AppendLocked(const double* values, size_t count) {
+    if (count == 0) {
+        return;
+    }
+    if (ring.size() != capacity) {
+        ring.resize(capacity);
+    }
+    // Из слишком длинной порции нужен только хвост
+    if (count >= capacity) {
+        memcpy(ring.data(), values + (count - capacity), capacity * sizeof(double));
+        head = 0;
+        size = capacity;
+        return;
+    }
+    // Не больше двух копирований: до конца кольца и с его начала
+    size_t tail = (head + size) % capacity;
+    size_t first = std::min(count, capacity - tail);
+    memcpy(ring.data() + tail, values, first * sizeof(double));
+    memcpy(ring.data(), values + first, (count - first) * sizeof(double));
+    if (size + count > capacity) {
+        head = (head + size + count - capacity) % capacity;
+        size = capacity;
+    } else {
+        size += count;
+    }
+}
+
+// Как у Image: одна перерисовка на все добавления, пришедшие до нее
+void Plot::ScheduleUpdate() {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        if (isUpdateScheduled) {
+            return;
+        }
+        isUpdateScheduled = true;
+    }
+    QMetaObject::invokeMethod(GetQObject(), [this]() {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            isUpdateScheduled = false;
+        }
+        update();
+    }, Qt::QueuedConnection);
+}
+
+// Столбец c покрывает точки [c * size / columns, (c + 1) * size / columns). Столбцы
+//  независимы, поэтому длинный ряд сводится параллельно, как сортируется таблица.
+//  Блокировка держится только на время прореживания, рисование идет уже без нее
+void Plot::paintEvent(QPaintEvent*) {
+    int columns = 0;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        columns = (int)std::min<size_t>(size, (size_t)std::max(width(), 0));
+        if (columns == 0) {
+            return;
+        }
+        columnMin.assign(columns, std::numeric_limits<double>::infinity());
+        columnMax.assign(columns, -std::numeric_limits<double>::infinity());
+        // Кольцо - два непрерывных куска: [head, end) и [0, остаток)
+        const double* firstPart = ring.data() + head;
+        size_t firstSize = std::min(size, capacity - head);
+        size_t tasks = GetTaskCount(size);
+        size_t count = size;
+        RunParallel(tasks, [&](size_t task) {
+            int end = (int)((task + 1) * columns / tasks);
+            for (int column = (int)(task * columns / tasks); column < end; ++column) {
+                size_t from = (size_t)column * count / columns;
+                size_t to = (size_t)(column + 1) * count / columns;
+                if (from < firstSize) {
+                    MinMax(firstPart + from, std::min(to, firstSize) - from, &columnMin[column], &columnMax[column]);
+                }
+                if (to > firstSize) {
+                    from = std::max(from, firstSize);
+                    MinMax(ring.data() + (from - firstSize), to - from, &columnMin[column], &columnMax[column]);
+                }
+            }
+        });
+    }
+
+    double low = std::numeric_limits<double>::infinity();
+    double high = -low;
+    for (int column = 0; column < columns; ++column) {
+        low = std::min(low, columnMin[column]);
+        high = std::max(high, columnMax[column]);
+    }
+    if (low > high) {
+        return;  // одни NaN
+    }
+    if (low == high) {
+        low -= 1;
+        high += 1;
+    }
+
+    // Ломаная идет через min и max каждого столбца: вертикальный отрезок внутри столбца
+    //  и переход к следующему
+    double xScale = (columns > 1) ? (double)(width() - 1) / (columns - 1) : 0;
+    double yScale = (height() - 1) / (high - low);
+    std::vector<QPointF> points;
+    points.reserve(2 * columns);
+    for (int column = 0; column < columns; ++column) {
+        if (columnMin[column] > columnMax[column]) {
+            continue;
+        }
+        double x = column * xScale;
+        points.emplace_back(x, (high - columnMin[column]) * yScale);
+        if (columnMax[column] != columnMin[column]) {
+            points.emplace_back(x, (high - columnMax[column]) * yScale);
+        }
+    }
+    QPainter painter(this);
+    if (points.size() == 1) {
+        painter.drawPoint(points[0]);
+    } else {
+        painter.drawPolyline(points.data(), (int)points.size());
+    }
+}
+
+//----------------------------------------------------------------------------------------
+
+LogSource::LogSource(int _capacity) :
+    capacity(_capacity), head(0) {}
+
+void LogSource::SetCapacity(int newCapacity) {
+    int kept = std::min((int)ring.size(), newCapacity);
+    std::vector<QString> lines;
+    lines.reserve(kept);
+    for (int row = (int)ring.size() - kept; row < (int)ring.size(); ++row) {
+        lines.push_back(std::move(ring[(head + row) % ring.size()]));
+    }
+    ring.swap(lines);
+    capacity = newCapacity;
+    head = 0;
+}
+
+int LogSource::Append(std::vector<QString>& lines) {
+    int evicted = 0;
+    for (QString& line : lines) {
+        if ((int)ring.size() < capacity) {
+            ring.push_back(std::move(line));
+        } else {
+            ring[head] = std::move(line);
+            head = (head + 1) % capacity;
+            ++evicted;
+        }
+    }
+    return evicted;
+}
+
+void LogSource::Clear() {
+    ring.clear();
+    head = 0;
+}
+
+int LogSource::GetRowCount() {
+    return (int)ring.size();
+}
+
+QString LogSource::GetRowText(int row) {
+    if (row < 0 || row >= (int)ring.size()) {
+        return QString();
+    }
+    return ring[(head + row) % ring.size()];
+}
+
+// Object и QAbstractScrollArea - виртуальные базы, их создает самый производный класс
+LogView::LogView(Widget* parent) :
+    QAbstractScrollArea(parent), Object(TypeName), ListView(parent),
+    maxLines(LogViewDefaultMaxLines), lineCount(0), isClearPending(false), isFlushScheduled(false),
+    source(new LogSource(LogViewDefaultMaxLines)), lastFlush()
+{
+    GetModel()->SetSource(source);
+}
+
+// Как ~Image
+LogView::~LogView() {
+    NotifyDestroyed();
+}
+
+void LogView::SetMaxLines(int newMaxLines) {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        maxLines = newMaxLines;
+        lineCount = std::min(lineCount, maxLines);
+        while ((int)pending.size() > maxLines) {
+            pending.pop_front();
+        }
+    }
+    ScheduleFlush();
+}
+
+// Очередь не длиннее maxLines: остальное все равно вытеснилось бы при применении
+void LogView::AppendLocked(QString& line) {
+    pending.push_back(std::move(line));
+    if ((int)pending.size() > maxLines) {
+        pending.pop_front();
+    }
+    lineCount = std::min(lineCount + 1, maxLines);
+}
+
+void LogView::Append(QString line) {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        AppendLocked(line);
+    }
+    ScheduleFlush();
+}
+
+void LogView::AppendMany(std::vector<QString>& lines) {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        for (QString& line : lines) {
+            AppendLocked(line);
+        }
+    }
+    lines.clear();
+    ScheduleFlush();
+}
+
+void LogView::Clear() {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        pending.clear();
+        isClearPending = true;
+        lineCount = 0;
+    }
+    ScheduleFlush();
+}
+
+int LogView::GetLineCount() {
+    std::lock_guard<std::mutex> lock(mutex);
+    return lineCount;
+}
+
+// Сначала переходим в GUI-поток, а там откладываем применение до конца кадра,
+//  отсчитанного от предыдущего применения. Если виджет удален раньше, Qt отменит оба вызова
+void LogView::ScheduleFlush() {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        if (isFlushScheduled) {
+            return;
+        }
+        isFlushScheduled = true;
+    }
+    QMetaObject::invokeMethod(GetQObject(), [this]() {
+        std::chrono::milliseconds elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(
+            std::chrono::steady_clock::now() - lastFlush);
+        int delay = std::max(LogViewFrameMs - (int)elapsed.count(), 0);
+        QTimer::singleShot(delay, GetQObject(), [this]() {
+            Flush();
+        });
+    }, Qt::QueuedConnection);
+}
+
+void LogView::Flush() {
+    std::vector<QString> lines;
+    bool shouldClear = false;
+    int capacity = 0;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        lines.reserve(pending.size());
+        for (QString& line : pending) {
+            lines.push_back(std::move(line));
+        }
+        pending.clear();
+        shouldClear = isClearPending;
+        isClearPending = false;
+        capacity = maxLines;
+        isFlushScheduled = false;
+    }
+    lastFlush = std::chrono::steady_clock::now();
+
+    bool isReset = shouldClear || capacity != source->GetCapacity();
+    if (shouldClear) {
+        source->Clear();
+    }
+    if (capacity != source->GetCapacity()) {
+        source->SetCapacity(capacity);
+    }
+    int before = source->GetRowCount();
+    int evicted = source->Append(lines);
+    int after = source->GetRowCount();
+
+    // Уведомления о вытеснении сверху и добавлении снизу дешевле сброса модели:
+    //  представления сохраняют выделение и положение
+    ListModel* model = GetModel();
+    QScrollBar* scrollBar = verticalScrollBar();
+    bool isAtEnd = scrollBar->value() >= scrollBar->maximum();
+    int scrollValue = scrollBar->value();
+    if (isReset) {
+        model->Reset();
+    } else {
+        if (evicted > 0) {
+            model->RowsRemoved(0, evicted - 1);
+        }
+        int inserted = after - (before - evicted);
+        if (inserted > 0) {
+            model->RowsInserted(after - inserted, after - 1);
+        }
+    }
+    if (isAtEnd) {
+        scrollBar->setValue(scrollBar->maximum());
+    } else if (!isReset) {
+        // Те же строки остаются на экране, пока не вытеснены
+        scrollBar->setValue(scrollValue - evicted);
+    }
+}
+
+//----------------------------------------------------------------------------------------
+
+namespace {
+
+struct SignalKey {
+    const QMetaObject* metaObject;
+    std::string name;
+
+    bool operator==(const SignalKey& other) const {
+        return metaObject == other.metaObject && name == other.name;
+    }
+};
+
+struct SignalKeyHash {
+    size_t operator()(const SignalKey& key) const {
+        return std::hash<const QMetaObject*>()(key.metaObject) ^ std::hash<std::string>()(key.name);
+    }
+};
+
+// Принимает сигнал вместо слота без moc: Qt вызывает qt_metacall с индексом
+//  метода сразу за последним методом QObject, его и используем при подключении
+class SignalRelay : public QObject {
+public:
+    SignalRelay(Object* _sender, SignalHandler _handler) :
+        QObject(_sender->GetQObject()), sender(_sender), handler(std::move(_handler)) {}
+
+    static int SlotIndex() {
+        return QObject::staticMetaObject.methodCount();
+    }
+
+    int qt_metacall(QMetaObject::Call call, int id, void** args) override {
+        id = QObject::qt_metacall(call, id, args);
+        if (id < 0 || call != QMetaObject::InvokeMetaMethod) {
+            return id;
+        }
+        if (id == 0) {
+            // args[0] - место под возвращаемое значение
+            handler(sender, args + 1);
+        }
+        return id - 1;
+    }
+
+private:
+    Object* sender;
+    SignalHandler handler;
+};
+
+int FindSignalIndex(const QMetaObject* metaObject, const char* name) {
+    if (strchr(name, '(') != NULL) {
+        return metaObject->indexOfSignal(QMetaObject::normalizedSignature(name).constData());
+    }
+    int index = -1;
+    int parameterCount = -1;
+    for (int i = 0; i < metaObject->methodCount(); ++i) {
+        QMetaMethod method = metaObject->method(i);
+        if (method.methodType() == QMetaMethod::Signal && method.name() == name &&
+            method.parameterCount() > parameterCount)
+        {
+            index = i;
+            parameterCount = method.parameterCount();
+        }
+    }
+    return index;
+}
+
+} // namespace
+
+const SignalSignature* Object_FindSignal(Object* object, const char* name) {
+    static std::unordered_map<SignalKey, std::unique_ptr<SignalSignature>, SignalKeyHash> cache;
+
+    SignalKey key = {object->GetQObject()->metaObject(), name};
+    auto it = cache.find(key);
+    if (it != cache.end()) {
+        return it->second.get();
+    }
+
+    std::unique_ptr<SignalSignature> signal;
+    int index = FindSignalIndex(key.metaObject, name);
+    if (index >= 0) {
+        QMetaMethod method = key.metaObject->method(index);
+        signal.reset(new SignalSignature());
+        signal->methodIndex = index;
+        signal->signature = method.methodSignature();
+        for (int i = 0; i < method.parameterCount(); ++i) {
+            signal->parameterTypes.push_back(method.parameterType(i));
+        }
+    }
+    return cache.emplace(std::move(key), std::move(signal)).first->second.get();
+}
+
+bool Object_Connect(Object* object, const SignalSignature* signal, SignalHandler handler) {
+    // Relay становится дочерним объектом отправителя и удаляется вместе с ним
+    SignalRelay* relay = new SignalRelay(object, std::move(handler));
+    if (!QMetaObject::connect(object->GetQObject(), signal->methodIndex, relay, SignalRelay::SlotIndex())) {
+        delete relay;
+        return false;
+    }
+    return true;
+}
+
+//----------------------------------------------------------------------------------------
+
+SignalBatch::SignalBatch(Handler _handler, bool _deduplicate) :
+    handler(std::move(_handler)), deduplicate(_deduplicate), isFlushScheduled(false) {}
+
+void SignalBatch::Push(Object* sender) {
+    if (deduplicate && !queued.insert(sender).second) {
+        return;
+    }
+    senders.push_back(sender);
+    if (isFlushScheduled) {
+        return;
+    }
+
+    QCoreApplication* app = QCoreApplication::instance();
+    if (app == NULL) {
+        Flush();
+        return;
+    }
+    isFlushScheduled = true;
+    // Пачка держит себя живой, пока вызов в очереди цикла событий
+    std::shared_ptr<SignalBatch> self = shared_from_this();
+    QMetaObject::invokeMethod(app, [self]() {
+        self->Flush();
+    }, Qt::QueuedConnection);
+}
+
+void SignalBatch::Forget(Object* sender) {
+    senders.erase(std::remove(senders.begin(), senders.end(), sender), senders.end());
+    queued.erase(sender);
+}
+
+void SignalBatch::Flush() {
+    // Обработчик может испустить сигналы снова - они уйдут в следующую пачку
+    std::vector<Object*> batch;
+    batch.swap(senders);
+    queued.clear();
+    isFlushScheduled = false;
+    if (!batch.empty()) {
+        handler(batch);
+    }
+}
+
+//----------------------------------------------------------------------------------------
+
+namespace {
+
+struct UpdateKey {
+    Object* object;
+    UpdateProperty property;
+
+    bool operator==(const UpdateKey& other) const {
+        return object == other.object && property == other.property;
+    }
+};
+
+struct UpdateKeyHash {
+    size_t operator()(const UpdateKey& key) const {
+        return std::hash<Object*>()(key.object) * UpdateProperty_Count + key.property;
+    }
+};
+
+// Цели объекта для каждого свойства, вычисленные в Object_GetHandle, пока объект жив. По ним
+//  обновление по handle разрешается под мьютексом, не трогая объект, который в это время
+//  может разрушаться в GUI-потоке
+struct HandleTarget {
+    Object* object;
+    Widget* widget;
+    QWidget* qwidget;
+    Label* label;
+    PushButton* button;
+};
+
+// Пачка в FlushUpdates: updates[*next] и дальше еще не применены
+struct FlushingBatch {
+    std::vector<PropertyUpdate>* updates;
+    const size_t* next;
+};
+
+struct UpdateQueue {
+    std::mutex mutex;
+    std::vector<PropertyUpdate> pending;
+    // Пачки, которые сейчас применяет FlushUpdates (вложенный вызов из обработчика сигнала
+    //  добавляет свою). Деструктор Object снимает и их обновления, иначе обработчик,
+    //  удаливший виджет, оставил бы в пачке висячий указатель
+    std::vector<FlushingBatch> flushing;
+    std::unordered_map<UpdateKey, size_t, UpdateKeyHash> positions;  // индекс в pending
+    std::unordered_map<uint64_t, HandleTarget> targets;              // по handle
+    std::unordered_map<Object*, uint64_t> handles;
+    uint64_t nextHandle = 1;
+    bool isFlushScheduled = false;
+    UpdateStats stats = {};
+};
+
+// Очередь не разрушается, чтобы объекты, удаляемые при завершении программы,
+//  не обращались к уже разрушенному мьютексу
+UpdateQueue& GetUpdateQueue() {
+    static UpdateQueue* queue = new UpdateQueue();
+    return *queue;
+}
+
+// Сравнение с текущим значением виджета: Qt хранит его сам, поэтому отдельный кэш
+//  не нужен, а QString сравнивается сначала по длине. Возвращает false, если значение
+//  не изменилось и применять нечего
+bool ApplyUpdate(const PropertyUpdate& update) {
+    switch (update.property) {
+    case UpdateProperty_WindowTitle: {
+        Widget* widget = static_cast<Widget*>(update.target);
+        if (widget->windowTitle() == update.text) {
+            return false;
+        }
+        widget->setWindowTitle(update.text);
+        return true;
+    }
+    case UpdateProperty_Size: {
+        Widget* widget = static_cast<Widget*>(update.target);
+        if (widget->size() == QSize(update.x, update.y)) {
+            return false;
+        }
+        widget->resize(update.x, update.y);
+        return true;
+    }
+    case UpdateProperty_Visible:
+        // setVisible сам ничего не делает, если видимость не меняется
+        static_cast<QWidget*>(update.target)->setVisible(update.x != 0);
+        return true;
+    case UpdateProperty_LabelText: {
+        Label* label = static_cast<Label*>(update.target);
+        if (label->text() == update.text) {
+            return false;
+        }
+        label->setText(update.text);
+        return true;
+    }
+    case UpdateProperty_PushButtonText: {
+        PushButton* button = static_cast<PushButton*>(update.target);
+        if (button->text() == update.text) {
+            return false;
+        }
+        button->setText(update.text);
+        return true;
+    }
+    case UpdateProperty_Count:
+        break;
+    }
+    return false;
+}
+
+// Обработчики сигналов, вызванные при применении, могут ставить новые обновления:
+//  они попадут в следующую пачку
+//  Пачку меняет только деструктор Object, который выполняется в этом же потоке, поэтому
+//  target читается без мьютекса
+void FlushUpdates() {
+    UpdateQueue& queue = GetUpdateQueue();
+    std::vector<PropertyUpdate> updates;
+    size_t next = 0;
+    {
+        std::lock_guard<std::mutex> lock(queue.mutex);
+        updates.swap(queue.pending);
+        queue.positions.clear();
+        queue.isFlushScheduled = false;
+        queue.flushing.push_back(FlushingBatch{&updates, &next});
+    }
+    uint64_t applied = 0, unchanged = 0;
+    while (next < updates.size()) {
+        const PropertyUpdate& update = updates[next++];
+        if (update.target == NULL) {
+            continue;
+        }
+        if (ApplyUpdate(update)) {
+            ++applied;
+        } else {
+            ++unchanged;
+        }
+    }
+    std::lock_guard<std::mutex> lock(queue.mutex);
+    queue.flushing.erase(std::find_if(queue.flushing.begin(), queue.flushing.end(),
+        [&updates](const FlushingBatch& batch) { return batch.updates == &updates; }));
+    queue.stats.applied += applied;
+    queue.stats.unchanged += unchanged;
+}
+
+// Для синхронных сеттеров (только GUI-поток): значение применяется сразу, а поставленное
+//  раньше значение того же свойства снимается и из очереди, и из еще не примененной части
+//  пачек FlushUpdates (сеттер мог вызвать обработчик сигнала посреди пачки), иначе пачка
+//  потом вернула бы старое
+void ApplyUpdateNow(const PropertyUpdate& update) {
+    UpdateQueue& queue = GetUpdateQueue();
+    {
+        std::lock_guard<std::mutex> lock(queue.mutex);
+        if (!queue.positions.empty()) {
+            UpdateKey key = {update.object, update.property};
+            auto it = queue.positions.find(key);
+            if (it != queue.positions.end()) {
+                queue.pending[it->second].target = NULL;
+                queue.positions.erase(it);
+                ++queue.stats.cancelled;
+            }
+        }
+        for (const FlushingBatch& batch : queue.flushing) {
+            for (size_t i = *batch.next; i < batch.updates->size(); ++i) {
+                PropertyUpdate& queued = (*batch.updates)[i];
+                if (queued.target != NULL && queued.object == update.object && queued.property == update.property) {
+                    queued.target = NULL;
+                    ++queue.stats.cancelled;
+                }
+            }
+        }
+    }
+    bool isApplied = ApplyUpdate(update);
+    std::lock_guard<std::mutex> lock(queue.mutex);
+    if (isApplied) {
+        ++queue.stats.applied;
+    } else {
+        ++queue.stats.unchanged;
+    }
+}
+
+// Заполняет object и target обновления по handle. Текст уходит в то свойство, которое
+//  есть у объекта
+bool ResolveHandleLocked(UpdateQueue& queue, PropertyUpdate& update) {
+    auto it = queue.targets.find(update.handle);
+    if (it == queue.targets.end()) {
+        return false;
+    }
+    const HandleTarget& target = it->second;
+    switch (update.property) {
+    case UpdateProperty_WindowTitle:
+    case UpdateProperty_Size:
+        update.target = target.widget;
+        break;
+    case UpdateProperty_Visible:
+        update.target = target.qwidget;
+        break;
+    case UpdateProperty_LabelText:
+    case UpdateProperty_PushButtonText:
+        if (target.label != NULL) {
+            update.property = UpdateProperty_LabelText;
+            update.target = target.label;
+        } else {
+            update.property = UpdateProperty_PushButtonText;
+            update.target = target.button;
+        }
+        break;
+    case UpdateProperty_Count:
+        break;
+    }
+    update.object = target.object;
+    return update.target != NULL;
+}
+
+// Возвращает true, если пачку нужно запланировать
+bool PostUpdateLocked(UpdateQueue& queue, PropertyUpdate& update) {
+    if (update.object == NULL && !ResolveHandleLocked(queue, update)) {
+        ++queue.stats.dropped;
+        return false;
+    }
+    UpdateKey key = {update.object, update.property};
+    auto inserted = queue.positions.insert(std::make_pair(key, queue.pending.size()));
+    if (inserted.second) {
+        queue.pending.push_back(std::move(update));
+    } else {
+        queue.pending[inserted.first->second] = std::move(update);
+        ++queue.stats.coalesced;
+    }
+    ++queue.stats.posted;
+    bool needsFlush = !queue.isFlushScheduled;
+    queue.isFlushScheduled = true;
+    return needsFlush;
+}
+
+void ScheduleFlushUpdates(QCoreApplication* app) {
+    QMetaObject::invokeMethod(app, &FlushUpdates, Qt::QueuedConnection);
+}
+
+} // namespace
+
+// Без приложения нет и цикла событий, который применил бы очередь
+void Application_PostUpdates(std::vector<PropertyUpdate>& updates) {
+    QCoreApplication* app = QCoreApplication::instance();
+    if (updates.empty()) {
+        return;
+    }
+
+    UpdateQueue& queue = GetUpdateQueue();
+    bool needsFlush = false;
+    {
+        std::lock_guard<std::mutex> lock(queue.mutex);
+        for (PropertyUpdate& update : updates) {
+            needsFlush = PostUpdateLocked(queue, update) || needsFlush;
+        }
+    }
+    updates.clear();
+
+    if (app == NULL) {
+        FlushUpdates();
+    } else if (needsFlush) {
+        ScheduleFlushUpdates(app);
+    }
+}
+
+void Application_PostUpdate(PropertyUpdate update) {
+    QCoreApplication* app = QCoreApplication::instance();
+    UpdateQueue& queue = GetUpdateQueue();
+    bool needsFlush = false;
+    {
+        std::lock_guard<std::mutex> lock(queue.mutex);
+        needsFlush = PostUpdateLocked(queue, update);
+    }
+
+    if (app == NULL) {
+        FlushUpdates();
+    } else if (needsFlush) {
+        ScheduleFlushUpdates(app);
+    }
+}
+
+// Уже запланированный вызов FlushUpdates потом найдет пустую очередь
+void Application_FlushUpdates() {
+    FlushUpdates();
+}
+
+UpdateStats Application_GetUpdateStats() {
+    UpdateQueue& queue = GetUpdateQueue();
+    std::lock_guard<std::mutex> lock(queue.mutex);
+    return queue.stats;
+}
+
+void Widget_SetWindowTitle(Widget* widget, const char* title) {
+    Widget_SetWindowTitle(widget, QString::fromUtf8(title));
+}
+
+void Widget_SetWindowTitle(Widget* widget, const QString& title) {
+    ApplyUpdateNow(Update_WindowTitle(widget, title));
+}
+
+void Widget_SetSize(Widget* widget, int w, int h) {
+    ApplyUpdateNow(Update_Size(widget, w, h));
+}
+
+void Label_SetText(Label* label, const char* text) {
+    Label_SetText(label, QString::fromUtf8(text));
+}
+
+void Label_SetText(Label* label, const QString& text) {
+    ApplyUpdateNow(Update_LabelText(label, text));
+}
+
+void PushButton_SetText(PushButton* button, const char* text) {
+    PushButton_SetText(button, QString::fromUtf8(text));
+}
+
+void PushButton_SetText(PushButton* button, const QString& text) {
+    ApplyUpdateNow(Update_PushButtonText(button, text));
+}
+
+uint64_t Object_GetHandle(Object* object) {
+    UpdateQueue& queue = GetUpdateQueue();
+    std::lock_guard<std::mutex> lock(queue.mutex);
+    auto inserted = queue.handles.insert(std::make_pair(object, queue.nextHandle));
+    if (inserted.second) {
+        HandleTarget target = {object, dynamic_cast<Widget*>(object), dynamic_cast<QWidget*>(object),
+            dynamic_cast<Label*>(object), dynamic_cast<PushButton*>(object)};
+        queue.targets[queue.nextHandle++] = target;
+    }
+    return inserted.first->second;
+}
+
+void Object::NotifyDestroyed() {
+    ObjectDestroyedHook hook = destroyedHook;
+    destroyedHook = NULL;
+    if (hook != NULL) {
+        hook(this);
+    }
+}
+
+Object::~Object() {
+    NotifyDestroyed();
+
+    UpdateQueue& queue = GetUpdateQueue();
+    std::lock_guard<std::mutex> lock(queue.mutex);
+    // Обновление по handle, разрешенное до этого места, снимается ниже вместе с остальными
+    if (!queue.handles.empty()) {
+        auto it = queue.handles.find(this);
+        if (it != queue.handles.end()) {
+            queue.targets.erase(it->second);
+            queue.handles.erase(it);
+        }
+    }
+    for (const FlushingBatch& batch : queue.flushing) {
+        for (PropertyUpdate& update : *batch.updates) {
+            if (update.object == this) {
+                update.target = NULL;
+            }
+        }
+    }
+    if (queue.positions.empty()) {
+        return;
+    }
+    for (int property = 0; property < UpdateProperty_Count; ++property) {
+        UpdateKey key = {this, (UpdateProperty) property};
+        auto it = queue.positions.find(key);
+        if (it != queue.positions.end()) {
+            queue.pending[it->second].target = NULL;
+            queue.positions.erase(it);
+        }
+    }
+}
+
+//----------------------------------------------------------------------------------------
+
+// Виджет, созданный по узлу описания, и значения свойств, уже поставленные в очередь
+//  обновлений. Сравнение идет с ними, а не с Qt: свойства, которых нет в описании,
+//  и виджеты, которых нет в дереве, реконсилятор не читает
+struct MountedNode {
+    StateNodeType type = StateNodeType_Widget;
+    unsigned char properties = 0;
+    bool hasKey = false;
+    bool isVisible = false;
+    int width = 0;
+    int height = 0;
+    QString key;
+    QString text;
+    Object* object = NULL;
+    void* target = NULL;          // Widget*, Label* или PushButton*, в зависимости от type
+    QPointer<QWidget> widget;     // обнуляется, если виджет удалили в обход реконсилятора
+    std::vector<MountedNode> children;
+};
+
+Widget::~Widget() {}
+
+namespace {
+
+struct QStringHash {
+    size_t operator()(const QString& key) const {
+        return qHash(key);
+    }
+};
+
+struct ReconcileContext {
+    std::vector<PropertyUpdate> updates;
+    ReconcileStats stats;
+};
+
+void ReconcileNode(MountedNode& mounted, const StateNode& node, ReconcileContext& context);
+
+void PostChangedProperties(MountedNode& mounted, const StateNode& node, ReconcileContext& context) {
+    unsigned char previous = mounted.properties;
+    if ((node.properties & StateProperty_Text) &&
+        (!(previous & StateProperty_Text) || mounted.text != node.text))
+    {
+        switch (mounted.type) {
+        case StateNodeType_Widget:
+            context.updates.push_back(Update_WindowTitle(static_cast<Widget*>(mounted.target), node.text));
+            break;
+        case StateNodeType_Label:
+            context.updates.push_back(Update_LabelText(static_cast<Label*>(mounted.target), node.text));
+            break;
+        case StateNodeType_PushButton:
+            context.updates.push_back(Update_PushButtonText(static_cast<PushButton*>(mounted.target), node.text));
+            break;
+        }
+        mounted.text = node.text;
+    }
+    if ((node.properties & StateProperty_Size) && mounted.type == StateNodeType_Widget &&
+        (!(previous & StateProperty_Size) || mounted.width != node.width || mounted.height != node.height))
+    {
+        context.updates.push_back(Update_Size(static_cast<Widget*>(mounted.target), node.width, node.height));
+        mounted.width = node.width;
+        mounted.height = node.height;
+    }
+    if ((node.properties & StateProperty_Visible) &&
+        (!(previous & StateProperty_Visible) || mounted.isVisible != node.isVisible))
+    {
+        context.updates.push_back(Update_Visible(mounted.object, mounted.widget, node.isVisible));
+        mounted.isVisible = node.isVisible;
+    }
+    mounted.properties = node.properties;
+}
+
+MountedNode MountNode(const StateNode& node, Widget* parent, ReconcileContext& context) {
+    MountedNode mounted;
+    mounted.type = node.type;
+    mounted.hasKey = node.hasKey;
+    mounted.key = node.key;
+    switch (node.type) {
+    case StateNodeType_Widget: {
+        Widget* widget = Widget_New(parent);
+        mounted.object = widget;
+        mounted.target = widget;
+        mounted.widget = widget;
+        break;
+    }
+    case StateNodeType_Label: {
+        Label* label = Label_New(parent);
+        mounted.object = label;
+        mounted.target = label;
+        mounted.widget = label;
+        break;
+    }
+    case StateNodeType_PushButton: {
+        PushButton* button = PushButton_New(parent);
+        mounted.object = button;
+        mounted.target = button;
+        mounted.widget = button;
+        break;
+    }
+    }
+    ++context.stats.created;
+    ReconcileNode(mounted, node, context);
+    return mounted;
+}
+
+uint64_t CountMounted(const MountedNode& mounted) {
+    uint64_t count = 1;
+    for (const MountedNode& child : mounted.children) {
+        count += CountMounted(child);
+    }
+    return count;
+}
+
+void UnmountNode(MountedNode& mounted, QBoxLayout* layout, ReconcileContext& context) {
+    QWidget* widget = mounted.widget;
+    if (widget == NULL) {
+        return;
+    }
+    context.stats.removed += CountMounted(mounted);
+    if (layout != NULL) {
+        layout->removeWidget(widget);
+    }
+    // Потомки удаляются вместе с виджетом, а их обертки узнают об этом через destroyedHook
+    Object_Delete(mounted.object);
+}
+
+// Сопоставляет детей описания с прошлыми: по ключу, а узлы без ключа - по порядку среди
+//  соседей без ключа. Подходит только живой виджет того же типа, остальные создаются заново
+void ReconcileChildren(MountedNode& parent, const std::vector<StateNode>& nodes, ReconcileContext& context) {
+    Widget* widget = static_cast<Widget*>(parent.target);
+    QBoxLayout* layout = dynamic_cast<QBoxLayout*>(widget->layout());
+    if (layout == NULL && widget->layout() == NULL && !nodes.empty()) {
+        // Конструктор с родителем сам ставит layout виджету
+        layout = VBoxLayout_New(widget);
+    }
+
+    std::vector<MountedNode> previous;
+    previous.swap(parent.children);
+    std::vector<bool> isTaken(previous.size(), false);
+    std::vector<size_t> unkeyed;
+    for (size_t i = 0; i < previous.size(); ++i) {
+        if (!previous[i].hasKey) {
+            unkeyed.push_back(i);
+        }
+    }
+    size_t nextUnkeyed = 0;
+    // Индекс ключей строится, только когда порядок изменился
+    std::unordered_map<QString, size_t, QStringHash> keyed;
+    bool isKeyedBuilt = false;
+
+    parent.children.reserve(nodes.size());
+    for (size_t i = 0; i < nodes.size(); ++i) {
+        const StateNode& node = nodes[i];
+        size_t match = previous.size();
+        if (!node.hasKey) {
+            if (nextUnkeyed < unkeyed.size()) {
+                match = unkeyed[nextUnkeyed++];
+            }
+        } else if (i < previous.size() && previous[i].hasKey && !isTaken[i] && previous[i].key == node.key) {
+            match = i;
+        } else {
+            if (!isKeyedBuilt) {
+                for (size_t j = 0; j < previous.size(); ++j) {
+                    if (previous[j].hasKey) {
+                        keyed.insert(std::make_pair(previous[j].key, j));
+                    }
+                }
+                isKeyedBuilt = true;
+            }
+            auto it = keyed.find(node.key);
+            if (it != keyed.end() && !isTaken[it->second]) {
+                match = it->second;
+            }
+        }
+
+        if (match < previous.size() && previous[match].type == node.type &&
+            previous[match].widget != NULL)
+        {
+            isTaken[match] = true;
+            parent.children.push_back(std::move(previous[match]));
+            ReconcileNode(parent.children.back(), node, context);
+        } else {
+            parent.children.push_back(MountNode(node, widget, context));
+        }
+    }
+
+    for (size_t i = 0; i < previous.size(); ++i) {
+        if (!isTaken[i]) {
+            UnmountNode(previous[i], layout, context);
+        }
+    }
+
+    // Виджеты, уже стоящие на своем месте, не трогаем; новые вставляются без перестановок
+    if (layout == NULL) {
+        return;
+    }
+    for (size_t i = 0; i < parent.children.size(); ++i) {
+        QWidget* child = parent.children[i].widget;
+        QLayoutItem* item = layout->itemAt((int) i);
+        if (item != NULL && item->widget() == child) {
+            continue;
+        }
+        if (layout->indexOf(child) >= 0) {
+            layout->removeWidget(child);
+            ++context.stats.moved;
+        }
+        layout->insertWidget((int) i, child);
+    }
+}
+
+void ReconcileNode(MountedNode& mounted, const StateNode& node, ReconcileContext& context) {
+    PostChangedProperties(mounted, node, context);
+    if (mounted.type == StateNodeType_Widget) {
+        ReconcileChildren(mounted, node.children, context);
+    }
+}
+
+} // namespace
+
+bool Widget_ApplyState(Widget* widget, const StateNode& root, ReconcileStats* stats) {
+    QLayout* layout = widget->layout();
+    if (root.type != StateNodeType_Widget || (layout != NULL && dynamic_cast<QBoxLayout*>(layout) == NULL)) {
+        return false;
+    }
+    if (widget->state == NULL) {
+        widget->state.reset(new MountedNode());
+        MountedNode& state = *widget->state;
+        state.object = widget;
+        state.target = widget;
+        state.widget = widget;
+    }
+
+    ReconcileContext context = {};
+    ReconcileNode(*widget->state, root, context);
+    context.stats.updated = context.updates.size();
+    // Все изменившиеся свойства - одной пачкой под одной блокировкой очереди
+    Application_PostUpdates(context.updates);
+    if (stats != NULL) {
+        *stats = context.stats;
+    }
+    return true;
+}
+
+//----------------------------------------------------------------------------------------
+
+int Template_AddObject(Template* tpl, TemplateOp op, int parent) {
+    int slot = (int) tpl->slots.size();
+    tpl->slots.push_back(op);
+    TemplateCommand command = {op, slot, parent, 0};
+    tpl->commands.push_back(command);
+    return slot;
+}
+
+void Template_AddCommand(Template* tpl, TemplateOp op, int target, int arg1, int arg2) {
+    TemplateCommand command = {op, target, arg1, arg2};
+    tpl->commands.push_back(command);
+    bool hasText = op == TemplateOp_WidgetSetWindowTitle || op == TemplateOp_LabelSetText ||
+        op == TemplateOp_PushButtonSetText;
+    if (hasText && arg1 < 0) {
+        tpl->paramCount = std::max(tpl->paramCount, -arg1);
+    }
+}
+
+int Template_AddText(Template* tpl, const QString& text) {
+    tpl->texts.push_back(text);
+    return (int) tpl->texts.size() - 1;
+}
+
+namespace {
+
+// Созданный объект: типизированный указатель для сеттеров и QWidget для layout
+struct TemplateSlot {
+    void* impl;
+    QWidget* widget;
+};
+
+struct TemplateInstance {
+    const Template* tpl;
+    Widget* parent;
+    QLayout* parentLayout;
+    const char* data;
+    const int64_t* params;      // смещения параметров текущего экземпляра
+    std::vector<TemplateSlot> slots;
+
+    Widget* GetOwner(int slot) const {
+        return (slot == TemplateRoot) ? parent : static_cast<Widget*>(slots[slot].impl);
+    }
+
+    // Корни экземпляра встают в layout parent по порядку создания
+    void SetCreated(const TemplateCommand& command, void* impl, QWidget* widget) {
+        slots[command.target] = {impl, widget};
+        if (command.arg1 == TemplateRoot && parentLayout != NULL) {
+            Layout_AddWidget(parentLayout, widget);
+        }
+    }
+
+    QString GetText(int text) const {
+        if (text >= 0) {
+            return tpl->texts[text];
+        }
+        int param = -text - 1;
+        return QString::fromUtf8(data + params[param], (int)(params[param + 1] - params[param]));
+    }
+};
+
+void RunTemplateCommand(TemplateInstance& instance, const TemplateCommand& command) {
+    TemplateSlot& target = instance.slots[command.target];
+    switch (command.op) {
+    case TemplateOp_WidgetNew: {
+        Widget* widget = Widget_New(instance.GetOwner(command.arg1));
+        instance.SetCreated(command, widget, widget);
+        break;
+    }
+    case TemplateOp_VBoxLayoutNew:
+        target = {VBoxLayout_New(instance.GetOwner(command.arg1)), NULL};
+        break;
+    case TemplateOp_LabelNew: {
+        Label* label = Label_New(instance.GetOwner(command.arg1));
+        instance.SetCreated(command, label, label);
+        break;
+    }
+    case TemplateOp_PushButtonNew: {
+        PushButton* button = PushButton_New(instance.GetOwner(command.arg1));
+        instance.SetCreated(command, button, button);
+        break;
+    }
+    case TemplateOp_WidgetSetWindowTitle:
+        static_cast<Widget*>(target.impl)->setWindowTitle(instance.GetText(command.arg1));
+        break;
+    case TemplateOp_WidgetSetSize:
+        static_cast<Widget*>(target.impl)->resize(command.arg1, command.arg2);
+        break;
+    case TemplateOp_WidgetSetVisible:
+        target.widget->setVisible(command.arg1 != 0);
+        break;
+    case TemplateOp_LayoutAddWidget:
+        Layout_AddWidget(static_cast<VBoxLayout*>(target.impl), instance.slots[command.arg1].widget);
+        break;
+    case TemplateOp_LabelSetText:
+        static_cast<Label*>(target.impl)->setText(instance.GetText(command.arg1));
+        break;
+    case TemplateOp_PushButtonSetText:
+        static_cast<PushButton*>(target.impl)->setText(instance.GetText(command.arg1));
+        break;
+    }
+}
+
+} // namespace
+
+void Template_Instantiate(const Template* tpl, Widget* parent, int count, const char* data,
+    const int64_t* offsets)
+{
+    QWidget* window = parent->window();
+    bool isSuspended = window->updatesEnabled();
+    if (isSuspended) {
+        window->setUpdatesEnabled(false);
+    }
+
+    TemplateInstance instance = {tpl, parent, parent->layout(), data, NULL,
+        std::vector<TemplateSlot>(tpl->slots.size())};
+    for (int i = 0; i < count; ++i) {
+        instance.params = (offsets != NULL) ? offsets + (size_t) i * tpl->paramCount : NULL;
+        for (const TemplateCommand& command : tpl->commands) {
+            RunTemplateCommand(instance, command);
+        }
+    }
+
+    if (isSuspended) {
+        window->setUpdatesEnabled(true);
+    }
+}
+
+//----------------------------------------------------------------------------------------
+
+namespace {
+
+// activated у QSocketNotifier перегружен начиная с Qt 5.15, поэтому уведомитель
+//  перехватывает событие сам, без сигнала
+class PollNotifier : public QSocketNotifier {
+public:
+    PollNotifier(intptr_t _fd, Type type, EventPoller* _poller) :
+        QSocketNotifier(_fd, type, _poller), poller(_poller), fd(_fd),
+        pollEvent(type == QSocketNotifier::Read ? PollEvent_Read : PollEvent_Write) {}
+
+protected:
+    bool event(QEvent* e) override {
+        if (e->type() == QEvent::SockAct) {
+            poller->SetReady(fd, pollEvent);
+            return true;
+        }
+        return QSocketNotifier::event(e);
+    }
+
+private:
+    EventPoller* poller;
+    intptr_t fd;
+    int pollEvent;
+};
+
+// Ожидания в одном потоке могут быть вложенными (обработчик запустил другой цикл),
+//  прерывается самое внутреннее
+thread_local EventPoller* waitingPoller = NULL;
+
+} // namespace
+
+EventPoller::EventPoller() :
+    timer(new QTimer(this)), isInterrupted(false), isTimedOut(false)
+{
+    timer->setSingleShot(true);
+    QObject::connect(timer, &QTimer::timeout, this, [this]() {
+        isTimedOut = true;
+    });
+}
+
+void EventPoller::SetEnabled(intptr_t fd, QSocketNotifier*& notifier, int event, bool isEnabled) {
+    if (notifier == NULL && isEnabled) {
+        QSocketNotifier::Type type = (event == PollEvent_Read) ? QSocketNotifier::Read : QSocketNotifier::Write;
+        notifier = new PollNotifier(fd, type, this);
+    } else if (notifier != NULL && notifier->isEnabled() != isEnabled) {
+        notifier->setEnabled(isEnabled);
+    }
+}
+
+void EventPoller::Watch(intptr_t fd, int events) {
+    if (events == 0) {
+        auto it = notifiers.find(fd);
+        if (it != notifiers.end()) {
+            // Снятый дескриптор могут закрыть и выдать снова, уведомители не переиспользуются
+            delete it->second.read;
+            delete it->second.write;
+            notifiers.erase(it);
+        }
+        return;
+    }
+    Notifiers& entry = notifiers.emplace(fd, Notifiers{NULL, NULL}).first->second;
+    SetEnabled(fd, entry.read, PollEvent_Read, (events & PollEvent_Read) != 0);
+    SetEnabled(fd, entry.write, PollEvent_Write, (events & PollEvent_Write) != 0);
+}
+
+void EventPoller::SetReady(intptr_t fd, int event) {
+    // Qt сообщает о готовности, пока она есть, поэтому за одно ожидание дескриптор
+    //  может прийти несколько раз
+    for (PollReady& item : ready) {
+        if (item.fd == fd) {
+            item.events |= event;
+            return;
+        }
+    }
+    ready.push_back(PollReady{fd, event});
+}
+
+std::vector<PollReady> EventPoller::Wait(int timeoutMs) {
+    ready.clear();
+    isInterrupted = false;
+    isTimedOut = timeoutMs == 0;
+    if (timeoutMs > 0) {
+        timer->start(timeoutMs);
+    }
+    EventPoller* outerPoller = waitingPoller;
+    waitingPoller = this;
+
+    // Накопившиеся события обрабатываются при любом timeoutMs, иначе цикл asyncio,
+    //  занятый готовыми задачами, заморозил бы интерфейс
+    QCoreApplication::processEvents(QEventLoop::AllEvents);
+    while (ready.empty() && !isInterrupted && !isTimedOut) {
+        QCoreApplication::processEvents(QEventLoop::WaitForMoreEvents);
+    }
+    // Вне QEventLoop::exec отложенные удаления сами не выполняются
+    QCoreApplication::sendPostedEvents(NULL, QEvent::DeferredDelete);
+
+    waitingPoller = outerPoller;
+    timer->stop();
+    std::vector<PollReady> result;
+    result.swap(ready);
+    return result;
+}
+
+void EventPoller_InterruptWait() {
+    if (waitingPoller != NULL) {
+        waitingPoller->Interrupt();
+    }
+}
+
+//----------------------------------------------------------------------------------------
+
+namespace {
+
+typedef std::chrono::steady_clock TaskClock;
+
+uint64_t GetElapsedNs(TaskClock::time_point from, TaskClock::time_point to) {
+    return (uint64_t)std::chrono::duration_cast<std::chrono::nanoseconds>(to - from).count();
+}
+
+class TaskRunnable;
+
+struct FinishedTask {
+    TaskDoneFunction done;
+    void* context;
+    bool isCancelled;
+    TaskClock::time_point finishedAt;
+};
+
+} // namespace
+
+struct TaskPool::Shared : public std::enable_shared_from_this<TaskPool::Shared> {
+    std::mutex mutex;
+    QObject* receiver;                  // NULL после удаления пула
+    QThreadPool* threads;
+    uint64_t nextId = 1;
+    std::unordered_map<uint64_t, TaskRunnable*> queued;
+    std::vector<FinishedTask> finished;
+    bool isFlushScheduled = false;
+    TaskStats stats = {};
+
+    // Под mutex
+    void Finish(TaskDoneFunction done, void* context, bool isCancelled);
+    void Flush();
+};
+
+namespace {
+
+class TaskRunnable : public QRunnable {
+public:
+    TaskRunnable(std::shared_ptr<TaskPool::Shared> _shared, uint64_t _id, TaskFunction _run,
+        TaskDoneFunction _done, void* _context) :
+        shared(std::move(_shared)), id(_id), runTask(_run), done(_done), context(_context),
+        submittedAt(TaskClock::now()) {}
+
+    TaskDoneFunction GetDone() const {
+        return done;
+    }
+
+    void* GetContext() const {
+        return context;
+    }
+
+    void run() override {
+        TaskClock::time_point startedAt = TaskClock::now();
+        {
+            std::lock_guard<std::mutex> lock(shared->mutex);
+            // Отмененную задачу Cancel уже убрал из очереди и отдал сам
+            if (shared->queued.erase(id) == 0) {
+                return;
+            }
+            uint64_t waitNs = GetElapsedNs(submittedAt, startedAt);
+            shared->stats.waitNs += waitNs;
+            shared->stats.maxWaitNs = std::max(shared->stats.maxWaitNs, waitNs);
+            ++shared->stats.running;
+        }
+        runTask(context);
+        TaskClock::time_point finishedAt = TaskClock::now();
+        std::unique_lock<std::mutex> lock(shared->mutex);
+        --shared->stats.running;
+        ++shared->stats.completed;
+        shared->stats.runNs += GetElapsedNs(startedAt, finishedAt);
+        if (shared->receiver != NULL) {
+            shared->Finish(done, context, false);
+        } else {
+            // Пул удален: GUI-поток уже не ждет эту задачу, поэтому из рабочего потока
+            //  отдается только context
+            lock.unlock();
+            TaskCompletion completion = {context, false, true};
+            done(&completion, 1);
+        }
+    }
+
+private:
+    std::shared_ptr<TaskPool::Shared> shared;
+    uint64_t id;
+    TaskFunction runTask;
+    TaskDoneFunction done;
+    void* context;
+    TaskClock::time_point submittedAt;
+};
+
+// Завершения одной пачки отдаются по функциям в порядке первого появления, порядок
+//  внутри функции сохраняется
+void DeliverTasks(const std::vector<FinishedTask>& tasks) {
+    std::vector<TaskDoneFunction> functions;
+    for (const FinishedTask& task : tasks) {
+        if (std::find(functions.begin(), functions.end(), task.done) == functions.end()) {
+            functions.push_back(task.done);
+        }
+    }
+    std::vector<TaskCompletion> completions;
+    completions.reserve(tasks.size());
+    for (TaskDoneFunction done : functions) {
+        completions.clear();
+        for (const FinishedTask& task : tasks) {
+            if (task.done == done) {
+                completions.push_back(TaskCompletion{task.context, task.isCancelled, false});
+            }
+        }
+        done(completions.data(), completions.size());
+    }
+}
+
+} // namespace
+
+void TaskPool::Shared::Finish(TaskDoneFunction done, void* context, bool isCancelled) {
+    finished.push_back(FinishedTask{done, context, isCancelled, TaskClock::now()});
+    if (isFlushScheduled) {
+        return;
+    }
+    isFlushScheduled = true;
+    std::shared_ptr<Shared> self = shared_from_this();
+    QMetaObject::invokeMethod(receiver, [self]() {
+        self->Flush();
+    }, Qt::QueuedConnection);
+}
+
+void TaskPool::Shared::Flush() {
+    std::vector<FinishedTask> tasks;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        isFlushScheduled = false;
+        tasks.swap(finished);
+        TaskClock::time_point now = TaskClock::now();
+        for (const FinishedTask& task : tasks) {
+            uint64_t deliveryNs = GetElapsedNs(task.finishedAt, now);
+            stats.deliveryNs += deliveryNs;
+            stats.maxDeliveryNs = std::max(stats.maxDeliveryNs, deliveryNs);
+        }
+        ++stats.batches;
+    }
+    DeliverTasks(tasks);
+}
+
+TaskPool::TaskPool(QObject* receiver) :
+    shared(std::make_shared<Shared>())
+{
+    shared->receiver = receiver;
+    shared->threads = QThreadPool::globalInstance();
+}
+
+TaskPool::~TaskPool() {
+    std::vector<FinishedTask> tasks;
+    {
+        std::lock_guard<std::mutex> lock(shared->mutex);
+        shared->receiver = NULL;
+        // Еще не доставленные завершения и не начатые задачи отдаются сейчас
+        tasks.swap(shared->finished);
+        for (auto& item : shared->queued) {
+            TaskRunnable* runnable = item.second;
+            tasks.push_back(FinishedTask{runnable->GetDone(), runnable->GetContext(), true, TaskClock::now()});
+            ++shared->stats.cancelled;
+            // Если поток уже забрал задачу, run увидит, что ее нет в queued, и выйдет
+            if (shared->threads->tryTake(runnable)) {
+                delete runnable;
+            }
+        }
+        shared->queued.clear();
+    }
+    DeliverTasks(tasks);
+}
+
+uint64_t TaskPool::Submit(TaskFunction run, TaskDoneFunction done, void* context) {
+    uint64_t id;
+    TaskRunnable* runnable;
+    {
+        std::lock_guard<std::mutex> lock(shared->mutex);
+        id = shared->nextId++;
+        runnable = new TaskRunnable(shared, id, run, done, context);
+        shared->queued.emplace(id, runnable);
+        ++shared->stats.submitted;
+    }
+    // start вне mutex: свободный поток может сразу войти в run. После start runnable
+    //  может быть уже удален
+    shared->threads->start(runnable);
+    return id;
+}
+
+bool TaskPool::Cancel(uint64_t id) {
+    std::lock_guard<std::mutex> lock(shared->mutex);
+    auto found = shared->queued.find(id);
+    if (found == shared->queued.end()) {
+        return false;
+    }
+    TaskRunnable* runnable = found->second;
+    shared->queued.erase(found);
+    ++shared->stats.cancelled;
+    shared->Finish(runnable->GetDone(), runnable->GetContext(), true);
+    if (shared->threads->tryTake(runnable)) {
+        delete runnable;
+    }
+    return true;
+}
+
+TaskStats TaskPool::GetStats() const {
+    std::lock_guard<std::mutex> lock(shared->mutex);
+    TaskStats stats = shared->stats;
+    stats.queued = shared->queued.size();
+    stats.threadCount = shared->threads->maxThreadCount();
+    return stats;
+}
+
+//----------------------------------------------------------------------------------------
+
+constexpr int Scheduler::ThrottledIntervalMs;
+
+namespace {
+
+// Срок ближе этого считается наступившим: QTimer отмеряет целые миллисекунды
+const int64_t TimerToleranceNs = 1000000;
+
+} // namespace
+
+Scheduler::Scheduler() :
+    timer(new QTimer(this)), origin(std::chrono::steady_clock::now()), nextId(1), runningId(0),
+    throttledCount(0), enterBatch(NULL), leaveBatch(NULL), stats()
+{
+    QScreen* screen = QGuiApplication::primaryScreen();
+    double refreshRate = (screen != NULL) ? screen->refreshRate() : 0;
+    frameNs = (int64_t)(1e9 / ((refreshRate >= 1) ? refreshRate : 60));
+    stats.frameIntervalNs = (uint64_t)frameNs;
+    timer->setSingleShot(true);
+    timer->setTimerType(Qt::PreciseTimer);
+    connect(timer, &QTimer::timeout, this, [this]() {
+        Tick();
+    });
+}
+
+Scheduler::~Scheduler() {
+    while (!timers.empty()) {
+        Finish(timers.begin()->first);
+    }
+}
+
+void Scheduler::SetBatchHooks(TimerBatchEnterFunction enter, TimerBatchLeaveFunction leave) {
+    enterBatch = enter;
+    leaveBatch = leave;
+}
+
+int64_t Scheduler::GetNowNs() const {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - origin).count();
+}
+
+int64_t Scheduler::AlignToFrame(int64_t ns) const {
+    return (ns <= 0) ? 0 : (ns + frameNs - 1) / frameNs * frameNs;
+}
+
+uint64_t Scheduler::Add(TimerKind kind, int intervalMs, QWidget* owner, TimerFunction run,
+    TimerReleaseFunction release, void* context)
+{
+    uint64_t id = nextId++;
+    Entry& entry = timers[id];
+    entry.kind = kind;
+    entry.intervalNs = (kind == TimerKind_Frame) ? 0 : (int64_t)std::max(intervalMs, 0) * 1000000;
+    // Интервал 0 крутился бы без остановки, пусть будет раз в кадр
+    if (kind == TimerKind_Interval && entry.intervalNs == 0) {
+        entry.intervalNs = frameNs;
+    }
+    entry.hasOwner = (owner != NULL);
+    entry.owner = owner;
+    entry.run = run;
+    entry.release = release;
+    entry.context = context;
+    entry.lastRunNs = GetNowNs();
+    entry.isThrottled = false;
+    entry.isRemoved = false;
+    entry.slot = queue.end();
+    entry.stats = TimerStats();
+    int64_t nominalNs = entry.lastRunNs + entry.intervalNs;
+    Schedule(id, entry, nominalNs, AlignToFrame(nominalNs));
+    Arm();
+    return id;
+}
+
+void Scheduler::Schedule(uint64_t id, Entry& entry, int64_t nominalNs, int64_t deadlineNs) {
+    if (entry.slot != queue.end()) {
+        queue.erase(entry.slot);
+    }
+    entry.nominalNs = nominalNs;
+    entry.slot = queue.emplace(deadlineNs, id);
+}
+
+void Scheduler::SetThrottled(Entry& entry, bool isThrottled) {
+    if (entry.isThrottled == isThrottled) {
+        return;
+    }
+    entry.isThrottled = isThrottled;
+    throttledCount += isThrottled ? 1 : -1;
+    // Пока что-то приторможено, ловим показ любого окна, чтобы сразу его догнать
+    if (throttledCount == (isThrottled ? 1 : 0)) {
+        if (isThrottled) {
+            QCoreApplication::instance()->installEventFilter(this);
+        } else {
+            QCoreApplication::instance()->removeEventFilter(this);
+        }
+    }
+}
+
+// Удаляет таймер до вызова release: тот может снять другие таймеры
+void Scheduler::Finish(uint64_t id) {
+    auto found = timers.find(id);
+    if (found == timers.end()) {
+        return;
+    }
+    Entry& entry = found->second;
+    SetThrottled(entry, false);
+    if (entry.slot != queue.end()) {
+        queue.erase(entry.slot);
+    }
+    TimerReleaseFunction release = entry.release;
+    void* context = entry.context;
+    TimerStats timerStats = entry.stats;
+    timers.erase(found);
+    release(context, timerStats);
+}
+
+bool Scheduler::Remove(uint64_t id) {
+    auto found = timers.find(id);
+    if (found == timers.end() || found->second.isRemoved) {
+        return false;
+    }
+    if (id == runningId) {
+        found->second.isRemoved = true;
+        return true;
+    }
+    Finish(id);
+    Arm();
+    return true;
+}
+
+bool Scheduler::GetTimerStats(uint64_t id, TimerStats* timerStats) const {
+    auto found = timers.find(id);
+    if (found == timers.end()) {
+        return false;
+    }
+    *timerStats = found->second.stats;
+    return true;
+}
+
+SchedulerStats Scheduler::GetStats() const {
+    SchedulerStats result = stats;
+    result.timers = timers.size();
+    return result;
+}
+
+// Окна есть, но ни одно не показано
+bool Scheduler::AreWindowsHidden() const {
+    const QWidgetList windows = QApplication::topLevelWidgets();
+    for (QWidget* window : windows) {
+        if (window->isVisible()) {
+            return false;
+        }
+    }
+    return !windows.isEmpty();
+}
+
+bool Scheduler::eventFilter(QObject* watched, QEvent* event) {
+    if (event->type() == QEvent::Show && throttledCount != 0) {
+        // Приторможенные таймеры возвращаются к своим срокам, видимость проверит Tick
+        int64_t nowNs = GetNowNs();
+        for (auto& item : timers) {
+            Entry& entry = item.second;
+            int64_t deadlineNs = AlignToFrame(std::max(entry.nominalNs, nowNs));
+            if (entry.isThrottled && deadlineNs < entry.slot->first) {
+                Schedule(item.first, entry, entry.nominalNs, deadlineNs);
+            }
+        }
+        Arm();
+    }
+    return QObject::eventFilter(watched, event);
+}
+
+void Scheduler::Arm() {
+    if (runningId != 0) {
+        return;
+    }
+    if (queue.empty()) {
+        timer->stop();
+        return;
+    }
+    int64_t waitNs = queue.begin()->first - GetNowNs();
+    timer->start((waitNs <= 0) ? 0 : (int)std::min<int64_t>((waitNs + 999999) / 1000000, std::numeric_limits<int>::max()));
+}
+
+void Scheduler::Tick() {
+    int64_t nowNs = GetNowNs();
+    std::vector<uint64_t> due;
+    for (auto it = queue.begin(); it != queue.end() && it->first <= nowNs + TimerToleranceNs; ++it) {
+        due.push_back(it->second);
+    }
+    // -1 - еще не проверяли
+    int windowsHidden = -1;
+    const int64_t throttledNs = (int64_t)ThrottledIntervalMs * 1000000;
+    void* batchState = NULL;
+    bool isBatchEntered = false;
+    uint64_t fires = 0;
+    for (uint64_t id : due) {
+        // Таймер мог снять вызов из этого же прохода
+        auto found = timers.find(id);
+        if (found == timers.end()) {
+            continue;
+        }
+        Entry& entry = found->second;
+        bool isHidden;
+        if (entry.hasOwner) {
+            QWidget* owner = entry.owner.data();
+            if (owner == NULL) {
+                Finish(id);
+                continue;
+            }
+            isHidden = !owner->isVisible();
+        } else {
+            if (windowsHidden < 0) {
+                windowsHidden = AreWindowsHidden() ? 1 : 0;
+            }
+            isHidden = (windowsHidden != 0);
+        }
+        int64_t deadlineNs = entry.slot->first;
+        if (isHidden && nowNs - entry.lastRunNs < throttledNs) {
+            SetThrottled(entry, true);
+            ++entry.stats.throttled;
+            ++stats.throttled;
+            int64_t resumeNs = std::max(entry.nominalNs, entry.lastRunNs + throttledNs);
+            Schedule(id, entry, entry.nominalNs, AlignToFrame(resumeNs));
+            continue;
+        }
+        SetThrottled(entry, false);
+
+        if (!isBatchEntered && enterBatch != NULL) {
+            batchState = enterBatch();
+        }
+        isBatchEntered = true;
+        double frameTime = std::chrono::duration<double>(origin.time_since_epoch()).count() + deadlineNs * 1e-9;
+        int64_t startedNs = GetNowNs();
+        runningId = id;
+        entry.run(entry.context, frameTime);
+        runningId = 0;
+        int64_t finishedNs = GetNowNs();
+        // Ссылки на элементы unordered_map переживают вставки из вызова, а удаление отложено
+        uint64_t lateNs = (uint64_t)std::max<int64_t>(startedNs - deadlineNs, 0);
+        uint64_t runNs = (uint64_t)(finishedNs - startedNs);
+        TimerStats& timerStats = entry.stats;
+        ++timerStats.fires;
+        timerStats.runNs += runNs;
+        timerStats.maxRunNs = std::max(timerStats.maxRunNs, runNs);
+        timerStats.lateNs += lateNs;
+        timerStats.maxLateNs = std::max(timerStats.maxLateNs, lateNs);
+        int64_t budgetNs = (entry.kind == TimerKind_Interval) ? entry.intervalNs : frameNs;
+        if ((int64_t)runNs > budgetNs) {
+            ++timerStats.overruns;
+            ++stats.overruns;
+        }
+        entry.lastRunNs = startedNs;
+        ++fires;
+
+        if (entry.isRemoved || entry.kind != TimerKind_Interval) {
+            Finish(id);
+            continue;
+        }
+        // Периоды, которые целиком прошли за время вызова, пропускаются, а не нагоняются
+        int64_t nominalNs = entry.nominalNs + entry.intervalNs;
+        if (nominalNs <= finishedNs) {
+            int64_t missed = (finishedNs - entry.nominalNs) / entry.intervalNs;
+            timerStats.skipped += (uint64_t)missed;
+            nominalNs = entry.nominalNs + (missed + 1) * entry.intervalNs;
+        }
+        Schedule(id, entry, nominalNs, AlignToFrame(nominalNs));
+    }
+    if (isBatchEntered && leaveBatch != NULL) {
+        leaveBatch(batchState);
+    }
+    if (fires != 0) {
+        ++stats.ticks;
+        stats.fires += fires;
+        stats.coalesced += fires - 1;
+    }
+    Arm();
+}
@@ -5,35 +5,212 @@
 #ifndef WIDGETS_H
 #define WIDGETS_H
 
+#include <QAbstractListModel>
+#include <QAbstractScrollArea>
+#include <QAbstractTableModel>
 #include <QApplication>
+#include <QImage>
 #include <QLayout>
 #include <QWidget>
 #include <QLabel>
+#include <QPointer>
 #include <QPushButton>
+#include <QSocketNotifier>
+#include <QTableView>
+#include <QThread>
+#include <QTimer>
 
+#include <chrono>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+//----------------------------------------------------------------------------------------
+// Пул памяти для часто создаваемых объектов
+
+struct PoolStats {
+    size_t allocations;  // выдано блоков за все время
+    size_t reused;       // из них взято из списка свободных
+    size_t inUse;
+    size_t chunks;       // обращений к куче
+};
+
+// Раздает блоки одного размера из кусков по BlocksPerChunk штук. Освобожденные блоки
+//  не возвращаются в кучу, а переиспользуются, поэтому память под такие объекты при
+//  постоянном пересоздании не растет выше пика. Только из GUI-потока
+class BlockPool {
+public:
+    static const size_t BlocksPerChunk = 64;
+
+    explicit BlockPool(size_t blockSize);
+
+    void* Allocate(size_t size);
+    void Free(void* block, size_t size);
+    PoolStats GetStats() const;
+
+private:
+    struct FreeBlock {
+        FreeBlock* next;
+    };
+
+    size_t blockSize;
+    FreeBlock* freeList;
+    PoolStats stats;
+};
+
+// Подмешивается в класс библиотеки, чтобы new/delete шли через его пул. Наследники
+//  другого размера обслуживаются обычной кучей
+template <typename T>
+struct Pooled {
+    static void* operator new(size_t size) {
+        return GetPool().Allocate(size);
+    }
+
+    static void operator delete(void* block, size_t size) {
+        GetPool().Free(block, size);
+    }
+
+    // Пул не разрушается: объекты могут удаляться и после выхода из main
+    static BlockPool& GetPool() {
+        static BlockPool* pool = new BlockPool(sizeof(T));
+        return *pool;
+    }
+};
+
+//----------------------------------------------------------------------------------------
+
+struct Object;
+
+// Вызывается из деструктора Object (у Image, Plot и LogView - раньше, см. NotifyDestroyed),
+//  пока родитель и дочерние объекты еще живы
+typedef void (*ObjectDestroyedHook)(Object* object);
+
+// Каждый класс-наследник хранит свое имя в константе времени компиляции TypeName,
+//  а Object лишь запоминает указатель на нее.
+// Классы Qt наследуют QObject невиртуально, поэтому у наследников Object два подобъекта
+//  QObject. Родитель, сигналы и метаобъект есть только у того, что пришел от класса Qt, -
+//  его возвращает GetQObject.
+// Binding - непрозрачный указатель для биндингов (например, на обертку) и обработчик,
+//  которым биндинги узнают об уничтожении объекта. Библиотека их не трогает
 struct Object : public virtual QObject {
-    Object(const char* _name) : name(_name) {}
+    Object(const char* _name) : name(_name), binding(NULL), destroyedHook(NULL) {}
+    // Вызывает destroyedHook, снимает с объекта еще не примененные обновления
+    //  из Application_PostUpdates и освобождает его handle
+    ~Object();
 
     const char* GetClassName() const {
         return name;
     }
 
+    virtual QObject* GetQObject() = 0;
+
+    void* GetBinding() const {
+        return binding;
+    }
+
+    void SetBinding(void* _binding, ObjectDestroyedHook hook) {
+        binding = _binding;
+        destroyedHook = hook;
+    }
+
+protected:
+    // Вызывает destroyedHook не больше одного раза. Наследники, методы которых можно вызывать
+    //  из любого потока, вызывают его первым делом в своем деструкторе: биндинги отвязываются,
+    //  пока поля наследника еще живы
+    void NotifyDestroyed();
+
 private:
     const char* name;
+    void* binding;
+    ObjectDestroyedHook destroyedHook;
 };
 
 inline const char* Object_GetClassName(Object* obj) {
     return obj->GetClassName();
 }
 
+inline void* Object_GetBinding(Object* object) {
+    return object->GetBinding();
+}
+
+inline void Object_SetBinding(Object* object, void* binding, ObjectDestroyedHook hook) {
+    object->SetBinding(binding, hook);
+}
+
+// Объектом с родителем владеет родитель (Qt удалит его вместе с собой),
+//  объектом без родителя - тот, кто его создал
+inline bool Object_HasParent(Object* object) {
+    return object->GetQObject()->parent() != NULL;
+}
+
+// Родитель Qt, если это объект библиотеки, иначе NULL
+inline Object* Object_GetParent(Object* object) {
+    return dynamic_cast<Object*>(object->GetQObject()->parent());
+}
+
+// Прямые дочерние объекты библиотеки в порядке добавления
+inline std::vector<Object*> Object_GetChildren(Object* object) {
+    std::vector<Object*> children;
+    for (QObject* child : object->GetQObject()->children()) {
+        Object* childObject = dynamic_cast<Object*>(child);
+        if (childObject != NULL) {
+            children.push_back(childObject);
+        }
+    }
+    return children;
+}
+
 inline void Object_Delete(Object* object) {
     delete object;
 }
 
+// Вызывает visit для всех объектов библиотеки среди потомков qobject (на любой глубине)
+template <typename Visitor>
+inline void Object_ForEachDescendant(QObject* qobject, Visitor& visit) {
+    for (QObject* child : qobject->children()) {
+        Object* object = dynamic_cast<Object*>(child);
+        if (object != NULL) {
+            visit(object);
+        }
+        Object_ForEachDescendant(child, visit);
+    }
+}
+
+// Удаляет объект сразу, если вызвана из его потока, иначе - в его цикле событий
+inline void Object_Release(Object* object) {
+    QObject* qobject = object->GetQObject();
+    if (qobject->thread() == QThread::currentThread()) {
+        delete object;
+    } else {
+        qobject->deleteLater();
+    }
+}
+
 //----------------------------------------------------------------------------------------
 
+class TaskPool;
+class Scheduler;
+
 struct Application : public virtual QApplication, public virtual Object {
+    static constexpr const char* TypeName = "Application";
+
+    QObject* GetQObject() override {
+        return static_cast<QApplication*>(this);
+    }
+
     Application();
+    ~Application();
+
+    // Фоновые задачи, см. TaskPool_Submit
+    std::unique_ptr<TaskPool> taskPool;
+    // Таймеры и кадры, см. Scheduler_Add
+    std::unique_ptr<Scheduler> scheduler;
 
 private:
     // Затычка для поддержки заданного интерфейса (Application_New без параметров)
@@ -49,23 +226,53 @@ inline int Application_Exec(Application* app) {
     return app->exec();
 }
 
+// Выполняет task в GUI-потоке на одной из следующих итераций цикла событий.
+//  Можно вызывать из любого потока
+inline void Application_Post(Application* app, std::function<void()> task) {
+    QMetaObject::invokeMethod(app->GetQObject(), std::move(task), Qt::QueuedConnection);
+}
+
+// Поток, в котором живут объекты Qt. Пока приложения нет, им считается любой
+inline bool Application_IsGuiThread() {
+    QCoreApplication* app = QCoreApplication::instance();
+    return app == NULL || app->thread() == QThread::currentThread();
+}
+
+// Выполняет task в GUI-потоке и ждет его завершения; из GUI-потока - сразу.
+//  Возвращает false, если приложение удалено раньше, чем task выполнился.
+//  GUI-поток должен при этом крутить цикл событий, иначе вызов не вернется
+bool Application_Invoke(std::function<void()> task);
+
 //----------------------------------------------------------------------------------------
 
-struct Widget : public virtual QWidget, public virtual Object {
+struct MountedNode;
+
+struct Widget : public virtual QWidget, public virtual Object, public Pooled<Widget> {
+    static constexpr const char* TypeName = "Widget";
+
+    QObject* GetQObject() override {
+        return static_cast<QWidget*>(this);
+    }
+
     Widget(Widget* parent);
+    ~Widget();
+
+    // Последнее примененное Widget_ApplyState дерево или NULL
+    std::unique_ptr<MountedNode> state;
 };
 
 inline Widget* Widget_New(Widget* parent) {
     return new Widget(parent);
 }
 
-inline void Widget_SetWindowTitle(Widget* widget, const char* title) {
-    widget->setWindowTitle(title);
-}
-
-inline void Widget_SetSize(Widget* widget, int w, int h) {
-    widget->resize(w, h);
-}
+// Сеттеры свойств применяют значение сразу, в порядке вызовов, но значение, равное
+//  текущему, не применяют, и Qt не пересчитывает layout и не перерисовывает виджет зря.
+//  Значение того же свойства, поставленное раньше в очередь Application_PostUpdates,
+//  отменяется. Схлопывание записей за проход цикла событий - через Application_PostUpdates
+//  Текст принимается и как UTF-8, и готовой QString, которую не нужно перекодировать
+void Widget_SetWindowTitle(Widget* widget, const char* title);
+void Widget_SetWindowTitle(Widget* widget, const QString& title);
+void Widget_SetSize(Widget* widget, int w, int h);
 
 inline void Widget_SetVisible(Widget* widget, bool isVisible) {
     widget->setVisible(isVisible);
@@ -76,17 +283,25 @@ inline void Widget_SetVisible(Widget* widget, bool isVisible) {
 struct Layout : public virtual QLayout, public virtual Object {
 };
 
-inline void Layout_AddWidget(Layout* layout, Widget* widget) {
+// Принимаем базовые классы Qt, чтобы VBoxLayout, Label и PushButton (не наследники
+//  Layout и Widget) приводились неявно, а не через reinterpret-приведения
+inline void Layout_AddWidget(QLayout* layout, QWidget* widget) {
     layout->addWidget(widget);
 }
 
-inline void Widget_SetLayout(Widget* widget, Layout* layout) {
+inline void Widget_SetLayout(QWidget* widget, QLayout* layout) {
     widget->setLayout(layout);
 }
 
 //----------------------------------------------------------------------------------------
 
 struct VBoxLayout : public virtual QVBoxLayout, public virtual Object {
+    static constexpr const char* TypeName = "VBoxLayout";
+
+    QObject* GetQObject() override {
+        return static_cast<QVBoxLayout*>(this);
+    }
+
     VBoxLayout(Widget* parent);
 };
 
@@ -96,21 +311,33 @@ inline struct VBoxLayout* VBoxLayout_New(Widget* parent) {
 
 //----------------------------------------------------------------------------------------
 
-struct Label : public virtual QLabel, public virtual Object {
-    Label(Widget* parent) : QLabel(parent), Object("Label") {}
+struct Label : public virtual QLabel, public virtual Object, public Pooled<Label> {
+    static constexpr const char* TypeName = "Label";
+
+    QObject* GetQObject() override {
+        return static_cast<QLabel*>(this);
+    }
+
+    Label(Widget* parent) : QLabel(parent), Object(TypeName) {}
 };
 
 inline Label* Label_New(Widget* parent) {
     return new Label(parent);
 }
 
-inline void Label_SetText(Label* label, const char* text) {
-    label->setText(text);
-}
+// Сразу, как Widget_SetWindowTitle
+void Label_SetText(Label* label, const char* text);
+void Label_SetText(Label* label, const QString& text);
 
 //----------------------------------------------------------------------------------------
 
-struct PushButton : public virtual QPushButton, public virtual Object {
+struct PushButton : public virtual QPushButton, public virtual Object, public Pooled<PushButton> {
+    static constexpr const char* TypeName = "PushButton";
+
+    QObject* GetQObject() override {
+        return static_cast<QPushButton*>(this);
+    }
+
     PushButton(Widget* parent);
 };
 
@@ -118,8 +345,13 @@ inline PushButton* PushButton_New(Widget* widget) {
     return new PushButton(widget);
 }
 
-inline void PushButton_SetText(PushButton* button, const char* text) {
-    button->setText(text);
+// Сразу, как Widget_SetWindowTitle
+void PushButton_SetText(PushButton* button, const char* text);
+void PushButton_SetText(PushButton* button, const QString& text);
+
+// Программное нажатие: синхронно испускает clicked (используется в бенчмарках)
+inline void PushButton_Click(PushButton* button) {
+    button->click();
 }
 
 template <typename Callable>
@@ -129,4 +361,993 @@ inline void PushButton_SetOnClicked(PushButton* button, Callable handler) {
     });
 }
 
+//----------------------------------------------------------------------------------------
+// Список с ленивым чтением строк
+
+// Источник строк для ListModel. Строки запрашиваются только при отрисовке, то есть лишь
+//  видимые, и нигде не копируются. Вызывается из GUI-потока
+struct ListSource {
+    virtual ~ListSource() {}
+    virtual int GetRowCount() = 0;
+    virtual QString GetRowText(int row) = 0;
+};
+
+// Модель над ListSource. Число строк запоминается при установке источника и меняется только
+//  уведомлениями: Qt требует, чтобы модель менялась между begin*Rows и end*Rows, а источник
+//  (например, список Python) к моменту уведомления уже изменен
+class ListModel : public QAbstractListModel {
+public:
+    explicit ListModel(QObject* parent);
+
+    // Забирает источник во владение; NULL - пустой список
+    void SetSource(ListSource* source);
+    QString GetRowText(int row) const;
+
+    // Границы включительно, как в сигналах QAbstractItemModel
+    void RowsChanged(int first, int last);
+    void RowsInserted(int first, int last);
+    void RowsRemoved(int first, int last);
+    // Перечитывает число строк источника
+    void Reset();
+
+    int rowCount(const QModelIndex& parent = QModelIndex()) const override;
+    QVariant data(const QModelIndex& index, int role = Qt::DisplayRole) const override;
+
+private:
+    std::unique_ptr<ListSource> source;
+    int rows;
+};
+
+// Прокручиваемый список строк одной высоты. QListView хранит позицию каждой строки,
+//  поэтому здесь своя отрисовка: видимые строки вычисляются по положению полосы прокрутки,
+//  и память и время кадра не зависят от длины списка
+struct ListView : public virtual QAbstractScrollArea, public virtual Object {
+    static constexpr const char* TypeName = "ListView";
+
+    QObject* GetQObject() override {
+        return static_cast<QAbstractScrollArea*>(this);
+    }
+
+    ListView(Widget* parent);
+
+    ListModel* GetModel() {
+        return model;
+    }
+
+    // Вызывается моделью после изменения строк
+    void UpdateRows();
+
+protected:
+    void paintEvent(QPaintEvent* event) override;
+    void resizeEvent(QResizeEvent* event) override;
+    void scrollContentsBy(int dx, int dy) override;
+
+private:
+    int GetRowHeight() const;
+    int GetVisibleRowCount() const;
+
+    ListModel* model;  // дочерний объект
+};
+
+inline ListView* ListView_New(Widget* parent) {
+    return new ListView(parent);
+}
+
+inline void ListView_SetSource(ListView* view, ListSource* source) {
+    view->GetModel()->SetSource(source);
+}
+
+inline void ListView_RowsChanged(ListView* view, int first, int last) {
+    view->GetModel()->RowsChanged(first, last);
+}
+
+inline void ListView_RowsInserted(ListView* view, int first, int last) {
+    view->GetModel()->RowsInserted(first, last);
+}
+
+inline void ListView_RowsRemoved(ListView* view, int first, int last) {
+    view->GetModel()->RowsRemoved(first, last);
+}
+
+inline void ListView_Reset(ListView* view) {
+    view->GetModel()->Reset();
+}
+
+//----------------------------------------------------------------------------------------
+// Таблица над столбцами во внешней памяти
+
+enum TableColumnType : unsigned char {
+    TableColumnType_Int64,
+    TableColumnType_Float64,
+    TableColumnType_String
+};
+
+// Столбец не копирует данные: values указывает на rows значений int64_t или double,
+//  а для строк - на байты UTF-8, где строка i занимает [offsets[i], offsets[i + 1]).
+//  keeper держит эту память, пока столбец нужен модели
+struct TableColumn {
+    QString name;
+    TableColumnType type;
+    int rows;
+    const void* values;
+    const int64_t* offsets;
+    std::shared_ptr<void> keeper;
+};
+
+// Модель показывает строки столбцов в порядке перестановки: фильтр отбирает номера строк,
+//  сортировка их переставляет, сами столбцы не меняются. Qt запрашивает только видимые
+//  ячейки. Фильтр и сортировка на больших таблицах выполняются в нескольких потоках,
+//  остальное - только из GUI-потока
+class TableModel : public QAbstractTableModel {
+public:
+    explicit TableModel(QObject* parent);
+
+    // Все столбцы должны быть одной длины; сбрасывает фильтр и сортировку
+    void SetColumns(std::vector<TableColumn> columns);
+    const TableColumn* GetColumn(int column) const;
+    // Номер строки в столбцах для строки модели
+    int GetSourceRow(int row) const;
+
+    // Устойчивая сортировка; column < 0 возвращает исходный порядок.
+    //  NaN всегда оказываются в конце
+    void sort(int column, Qt::SortOrder order = Qt::AscendingOrder) override;
+    // Оставляет строки, где low <= значение <= high (для числовых столбцов)
+    //  Для столбцов int64 границы округляются внутрь и значения сравниваются как целые
+    void FilterRange(int column, double low, double high);
+    // То же с целыми границами, без потери точности для больших int64
+    void FilterRangeInt64(int column, int64_t low, int64_t high);
+    // Оставляет строки, содержащие подстроку utf8 (для строковых столбцов)
+    void FilterContains(int column, const QByteArray& utf8);
+    void ClearFilter();
+    // Заново применяет фильтр и сортировку после изменения данных на месте
+    void Refresh();
+
+    int rowCount(const QModelIndex& parent = QModelIndex()) const override;
+    int columnCount(const QModelIndex& parent = QModelIndex()) const override;
+    QVariant data(const QModelIndex& index, int role = Qt::DisplayRole) const override;
+    QVariant headerData(int section, Qt::Orientation orientation, int role = Qt::DisplayRole) const override;
+
+private:
+    void Rebuild();
+
+    std::vector<TableColumn> columns;
+    int rows;
+    std::vector<int> order;
+    std::function<bool(int sourceRow)> filter;  // пустой - все строки
+    int sortColumn;
+    Qt::SortOrder sortOrder;
+};
+
+// Строки одной высоты, щелчок по заголовку сортирует столбец
+struct TableView : public virtual QTableView, public virtual Object {
+    static constexpr const char* TypeName = "TableView";
+
+    QObject* GetQObject() override {
+        return static_cast<QTableView*>(this);
+    }
+
+    TableView(Widget* parent);
+
+    TableModel* GetModel() {
+        return model;
+    }
+
+private:
+    TableModel* model;  // дочерний объект
+};
+
+inline TableView* TableView_New(Widget* parent) {
+    return new TableView(parent);
+}
+
+// Снимает и индикатор сортировки в заголовке
+void TableView_SetColumns(TableView* view, std::vector<TableColumn> columns);
+
+// column < 0 - исходный порядок строк
+void TableView_Sort(TableView* view, int column, bool descending);
+
+inline void TableView_FilterRange(TableView* view, int column, double low, double high) {
+    view->GetModel()->FilterRange(column, low, high);
+}
+
+inline void TableView_FilterRangeInt64(TableView* view, int column, int64_t low, int64_t high) {
+    view->GetModel()->FilterRangeInt64(column, low, high);
+}
+
+inline void TableView_FilterContains(TableView* view, int column, const QByteArray& utf8) {
+    view->GetModel()->FilterContains(column, utf8);
+}
+
+inline void TableView_ClearFilter(TableView* view) {
+    view->GetModel()->ClearFilter();
+}
+
+inline void TableView_Refresh(TableView* view) {
+    view->GetModel()->Refresh();
+}
+
+//----------------------------------------------------------------------------------------
+// Показ кадров из чужой памяти
+
+// Кадр не копируется: QImage смотрит прямо в data, а keeper держит эту память,
+//  пока кадр может понадобиться для отрисовки
+struct ImageFrame {
+    QImage image;
+    std::shared_ptr<void> keeper;
+};
+
+struct ImageStats {
+    uint64_t submitted;  // переданных кадров
+    uint64_t shown;      // нарисованных
+    uint64_t dropped;    // замененных следующим кадром до отрисовки
+};
+
+// Двойная буферизация: SetFrame кладет кадр в задний слот, а отрисовка забирает его
+//  в передний и рисует уже без блокировки. Кадр, не дождавшийся отрисовки, пропускается
+//  и сразу отпускается. Сам переданный буфер производитель не должен менять, пока кадр
+//  не заменен, - для этого он чередует хотя бы два буфера
+struct Image : public virtual QWidget, public virtual Object {
+    static constexpr const char* TypeName = "Image";
+
+    QObject* GetQObject() override {
+        return static_cast<QWidget*>(this);
+    }
+
+    Image(Widget* parent);
+    ~Image();
+
+    // Можно вызывать из любого потока
+    void SetFrame(ImageFrame frame);
+    ImageStats GetStats();
+
+protected:
+    void paintEvent(QPaintEvent* event) override;
+
+private:
+    std::mutex mutex;
+    ImageFrame back;
+    bool hasBack;
+    bool isUpdateScheduled;
+    ImageStats stats;
+    ImageFrame front;  // только из GUI-потока
+};
+
+inline Image* Image_New(Widget* parent) {
+    return new Image(parent);
+}
+
+// data должна жить, пока жив keeper
+inline void Image_SetFrame(Image* image, const uchar* data, int width, int height, int bytesPerLine,
+    QImage::Format format, std::shared_ptr<void> keeper)
+{
+    ImageFrame frame = {QImage(data, width, height, bytesPerLine, format), std::move(keeper)};
+    image->SetFrame(std::move(frame));
+}
+
+inline ImageStats Image_GetStats(Image* image) {
+    return image->GetStats();
+}
+
+//----------------------------------------------------------------------------------------
+// График длинного ряда
+
+// Сколько последних точек Plot хранит по умолчанию
+const size_t PlotDefaultCapacity = 1 << 20;
+
+// Точки лежат в кольцевом буфере: добавление копирует только новые значения, а самые
+//  старые при переполнении вытесняются. Перед отрисовкой ряд сводится к паре min/max
+//  на столбец пикселей, поэтому рисуется не больше 2 * width() точек при любой длине ряда.
+//  NaN пропускаются
+struct Plot : public virtual QWidget, public virtual Object {
+    static constexpr const char* TypeName = "Plot";
+
+    QObject* GetQObject() override {
+        return static_cast<QWidget*>(this);
+    }
+
+    Plot(Widget* parent);
+    ~Plot();
+
+    // Можно вызывать из любого потока
+    void SetCapacity(size_t capacity);
+    void SetSeries(const double* values, size_t count);
+    void Append(const double* values, size_t count);
+    size_t GetSize();
+
+protected:
+    void paintEvent(QPaintEvent* event) override;
+
+private:
+    void AppendLocked(const double* values, size_t count);
+    void ScheduleUpdate();
+
+    std::mutex mutex;
+    std::vector<double> ring;  // выделяется при первом добавлении
+    size_t capacity;
+    size_t head;  // индекс самой старой точки
+    size_t size;
+    bool isUpdateScheduled;
+    std::vector<double> columnMin, columnMax;  // только из GUI-потока
+};
+
+inline Plot* Plot_New(Widget* parent) {
+    return new Plot(parent);
+}
+
+// Оставляет последние capacity точек, capacity > 0
+inline void Plot_SetCapacity(Plot* plot, size_t capacity) {
+    plot->SetCapacity(capacity);
+}
+
+inline void Plot_SetSeries(Plot* plot, const double* values, size_t count) {
+    plot->SetSeries(values, count);
+}
+
+inline void Plot_Append(Plot* plot, const double* values, size_t count) {
+    plot->Append(values, count);
+}
+
+inline void Plot_Clear(Plot* plot) {
+    plot->SetSeries(NULL, 0);
+}
+
+inline size_t Plot_GetSize(Plot* plot) {
+    return plot->GetSize();
+}
+
+//----------------------------------------------------------------------------------------
+// Журнал строк
+
+// Сколько последних строк LogView хранит по умолчанию
+const int LogViewDefaultMaxLines = 100000;
+// Не чаще одного применения добавленных строк за это время, мс
+const int LogViewFrameMs = 16;
+
+// Последние capacity строк в кольце. Только из GUI-потока
+class LogSource : public ListSource {
+public:
+    explicit LogSource(int capacity);
+
+    int GetCapacity() const {
+        return capacity;
+    }
+
+    void SetCapacity(int capacity);
+    // Добавляет строки, вытесняя самые старые; возвращает число вытесненных
+    int Append(std::vector<QString>& lines);
+    void Clear();
+
+    int GetRowCount() override;
+    QString GetRowText(int row) override;
+
+private:
+    std::vector<QString> ring;  // растет до capacity, дальше перезаписывается по кругу
+    int capacity;
+    int head;  // индекс самой старой строки
+};
+
+// Список (ListView) над кольцом строк. Append можно вызывать из любого потока с любой
+//  частотой: строки копятся в очереди, ограниченной тем же числом строк, и применяются
+//  в GUI-потоке одной пачкой не чаще раза в LogViewFrameMs - одно уведомление модели и
+//  одна перерисовка на кадр. Прокрученный до конца журнал следует за новыми строками
+struct LogView : public ListView {
+    static constexpr const char* TypeName = "LogView";
+
+    LogView(Widget* parent);
+    ~LogView();
+
+    // Можно вызывать из любого потока
+    void SetMaxLines(int maxLines);
+    void Append(QString line);
+    void AppendMany(std::vector<QString>& lines);
+    void Clear();
+    // Число строк с учетом еще не примененных
+    int GetLineCount();
+
+private:
+    void AppendLocked(QString& line);
+    void ScheduleFlush();
+    void Flush();
+
+    std::mutex mutex;
+    std::deque<QString> pending;
+    int maxLines;
+    int lineCount;  // с учетом очереди
+    bool isClearPending;
+    bool isFlushScheduled;
+    LogSource* source;  // принадлежит модели
+    std::chrono::steady_clock::time_point lastFlush;  // только из GUI-потока
+};
+
+inline LogView* LogView_New(Widget* parent) {
+    return new LogView(parent);
+}
+
+// maxLines > 0
+inline void LogView_SetMaxLines(LogView* view, int maxLines) {
+    view->SetMaxLines(maxLines);
+}
+
+inline void LogView_Append(LogView* view, const QString& line) {
+    view->Append(line);
+}
+
+// lines после вызова пуст
+inline void LogView_AppendMany(LogView* view, std::vector<QString>& lines) {
+    view->AppendMany(lines);
+}
+
+inline void LogView_Clear(LogView* view) {
+    view->Clear();
+}
+
+inline int LogView_GetLineCount(LogView* view) {
+    return view->GetLineCount();
+}
+
+//----------------------------------------------------------------------------------------
+// Подключение к произвольному сигналу по имени
+
+// Сигнал, найденный через QMetaObject
+struct SignalSignature {
+    int methodIndex;
+    QByteArray signature;             // нормализованная, например "clicked(bool)"
+    std::vector<int> parameterTypes;  // идентификаторы QMetaType
+};
+
+// Находит сигнал по имени ("clicked") или по сигнатуре ("clicked(bool)"); из перегрузок
+//  с одним именем берется сигнал с наибольшим числом параметров. Результат (в том числе
+//  отсутствие сигнала - NULL) кэшируется для пары (класс Qt, имя). Только из GUI-потока
+const SignalSignature* Object_FindSignal(Object* object, const char* name);
+
+// args[i] указывает на значение i-го параметра сигнала
+typedef std::function<void(Object* sender, void** args)> SignalHandler;
+
+// Подключает handler к сигналу; подключение живет, пока жив object
+bool Object_Connect(Object* object, const SignalSignature* signal, SignalHandler handler);
+
+//----------------------------------------------------------------------------------------
+// Пакетная доставка сигналов
+
+// Копит испускания сигналов и отдает их обработчику одним списком отправителей
+//  на следующей итерации цикла событий. При deduplicate каждый отправитель попадает
+//  в пачку один раз. Одну пачку можно подключить к нескольким объектам; живет в GUI-потоке
+class SignalBatch : public std::enable_shared_from_this<SignalBatch> {
+public:
+    typedef std::function<void(const std::vector<Object*>& senders)> Handler;
+
+    SignalBatch(Handler handler, bool deduplicate);
+
+    void Push(Object* sender);
+    // Убирает из пачки удаленный отправитель
+    void Forget(Object* sender);
+
+private:
+    void Flush();
+
+    Handler handler;
+    bool deduplicate;
+    bool isFlushScheduled;
+    std::vector<Object*> senders;
+    std::unordered_set<Object*> queued;  // только при deduplicate
+};
+
+inline std::shared_ptr<SignalBatch> SignalBatch_New(SignalBatch::Handler handler, bool deduplicate) {
+    return std::make_shared<SignalBatch>(std::move(handler), deduplicate);
+}
+
+inline void PushButton_SetOnClickedBatched(PushButton* button, const std::shared_ptr<SignalBatch>& batch) {
+    PushButton_SetOnClicked(button, [batch](Object* sender) {
+        batch->Push(sender);
+    });
+    Object* sender = button;
+    QObject::connect(button->GetQObject(), &QObject::destroyed, [batch, sender]() {
+        batch->Forget(sender);
+    });
+}
+
+//----------------------------------------------------------------------------------------
+// Потокобезопасная очередь обновлений свойств
+
+enum UpdateProperty : unsigned char {
+    UpdateProperty_WindowTitle,
+    UpdateProperty_Size,
+    UpdateProperty_Visible,
+    UpdateProperty_LabelText,
+    UpdateProperty_PushButtonText,
+    UpdateProperty_Count
+};
+
+struct PropertyUpdate {
+    Object* object;           // вместе с property - ключ схлопывания
+    void* target;             // Widget*, Label*, PushButton* или QWidget*, в зависимости от property
+    UpdateProperty property;
+    QString text;
+    int x;
+    int y;
+    uint64_t handle;          // при object == NULL объект ищется по handle, см. Object_GetHandle
+};
+
+inline PropertyUpdate Update_WindowTitle(Widget* widget, const QString& title) {
+    PropertyUpdate update = {widget, widget, UpdateProperty_WindowTitle, title, 0, 0};
+    return update;
+}
+
+inline PropertyUpdate Update_Size(Widget* widget, int w, int h) {
+    PropertyUpdate update = {widget, widget, UpdateProperty_Size, QString(), w, h};
+    return update;
+}
+
+// Видимость есть у любого виджета, поэтому target здесь - QWidget*
+inline PropertyUpdate Update_Visible(Object* object, QWidget* widget, bool isVisible) {
+    PropertyUpdate update = {object, widget, UpdateProperty_Visible, QString(), isVisible, 0};
+    return update;
+}
+
+inline PropertyUpdate Update_Visible(Widget* widget, bool isVisible) {
+    return Update_Visible(widget, widget, isVisible);
+}
+
+inline PropertyUpdate Update_LabelText(Label* label, const QString& text) {
+    PropertyUpdate update = {label, label, UpdateProperty_LabelText, text, 0, 0};
+    return update;
+}
+
+inline PropertyUpdate Update_PushButtonText(PushButton* button, const QString& text) {
+    PropertyUpdate update = {button, button, UpdateProperty_PushButtonText, text, 0, 0};
+    return update;
+}
+
+// Handle - номер объекта для кода, у которого нет указателя на него (например, для другого
+//  интерпретатора Python). Выдается при первом запросе, пропадает вместе с объектом и повторно
+//  не используется. Только пока объект жив
+uint64_t Object_GetHandle(Object* object);
+
+// Обновление объекта по handle. Цель находится при постановке в очередь; текст подходит и для
+//  Label, и для PushButton. Обновление удаленного объекта или объекта без такого свойства
+//  отбрасывается
+inline PropertyUpdate Update_ByHandle(uint64_t handle, UpdateProperty property, const QString& text, int x, int y) {
+    PropertyUpdate update = {NULL, NULL, property, text, x, y, handle};
+    return update;
+}
+
+// Ставит обновления в очередь, которая применяется в GUI-потоке одной пачкой.
+//  Пока пачка не применена, новое значение свойства объекта заменяет старое, а при
+//  применении значение, равное текущему значению виджета, пропускается.
+//  Можно вызывать из любого потока; updates после вызова пуст
+void Application_PostUpdates(std::vector<PropertyUpdate>& updates);
+void Application_PostUpdate(PropertyUpdate update);
+
+// Применяет очередь сразу, не дожидаясь цикла событий. Только из GUI-потока
+void Application_FlushUpdates();
+
+struct UpdateStats {
+    uint64_t posted;     // поставлено в очередь
+    uint64_t coalesced;  // заменено более новым значением до применения
+    uint64_t cancelled;  // снято до применения: синхронный сеттер записал значение сам
+    uint64_t unchanged;  // пропущено при применении или сеттером: значение не изменилось
+    uint64_t applied;    // передано в Qt, в том числе синхронными сеттерами
+    uint64_t dropped;    // отброшено при постановке: handle недействителен или не подходит к свойству
+};
+
+UpdateStats Application_GetUpdateStats();
+
+//----------------------------------------------------------------------------------------
+// Декларативное описание интерфейса
+
+enum StateNodeType : unsigned char {
+    StateNodeType_Widget,
+    StateNodeType_Label,
+    StateNodeType_PushButton
+};
+
+// Маска свойств, заданных в узле. Незаданное свойство Widget_ApplyState не трогает
+enum StateProperty : unsigned char {
+    StateProperty_Text = 1,      // text у Label и PushButton, заголовок окна у Widget
+    StateProperty_Size = 2,      // только у Widget
+    StateProperty_Visible = 4
+};
+
+// Узел описания: виджет, его свойства и дочерние узлы, которые у Widget по порядку
+//  лежат в его VBoxLayout. Ключ сопоставляет узел с виджетом, созданным по прошлому
+//  описанию; узлы без ключа сопоставляются по порядку среди соседей без ключа
+struct StateNode {
+    StateNodeType type;
+    unsigned char properties;
+    bool hasKey;
+    bool isVisible;
+    int width;
+    int height;
+    QString key;
+    QString text;
+    std::vector<StateNode> children;
+};
+
+struct ReconcileStats {
+    uint64_t created;   // создано виджетов
+    uint64_t removed;   // удалено виджетов, вместе с потомками
+    uint64_t moved;     // переставлено внутри layout
+    uint64_t updated;   // поставлено обновлений свойств в Application_PostUpdates
+};
+
+// Приводит виджет к описанию root (тип - Widget, свойства относятся к самому виджету),
+//  сравнивая его с прошлым примененным описанием: виджеты переиспользуются по ключу,
+//  пропавшие узлы удаляются, а в очередь обновлений уходят только изменившиеся свойства.
+//  Дочерние виджеты ставятся в начало layout виджета, который создается при
+//  необходимости. Возвращает false, если root - не Widget или у виджета уже есть layout,
+//  но не QBoxLayout. Только из GUI-потока
+bool Widget_ApplyState(Widget* widget, const StateNode& root, ReconcileStats* stats);
+
+//----------------------------------------------------------------------------------------
+// Шаблон поддерева: программа построения, записанная один раз и выполняемая для каждого
+//  экземпляра целиком в C++
+
+enum TemplateOp : unsigned char {
+    TemplateOp_WidgetNew,
+    TemplateOp_VBoxLayoutNew,
+    TemplateOp_LabelNew,
+    TemplateOp_PushButtonNew,
+    TemplateOp_WidgetSetWindowTitle,
+    TemplateOp_WidgetSetSize,
+    TemplateOp_WidgetSetVisible,
+    TemplateOp_LayoutAddWidget,
+    TemplateOp_LabelSetText,
+    TemplateOp_PushButtonSetText
+};
+
+// target - слот объекта, который команда создает или меняет. arg1 - слот родителя
+//  (TemplateRoot - корень экземпляра), добавляемого виджета, ширина, видимость или
+//  источник текста, arg2 - высота
+struct TemplateCommand {
+    TemplateOp op;
+    int target;
+    int arg1;
+    int arg2;
+};
+
+const int TemplateRoot = -1;
+
+// Источник текста: номер строки в Template::texts или параметр экземпляра
+inline int TemplateText_Param(int index) {
+    return -index - 1;
+}
+
+struct Template {
+    std::vector<TemplateCommand> commands;
+    std::vector<TemplateOp> slots;      // создающая команда каждого слота
+    std::vector<QString> texts;         // общие для всех экземпляров, не копируются
+    int paramCount = 0;
+};
+
+inline Template* Template_New() {
+    return new Template();
+}
+
+inline void Template_Delete(Template* tpl) {
+    delete tpl;
+}
+
+// Функции записи возвращают слот созданного объекта. Типы слотов проверяют биндинги
+int Template_AddObject(Template* tpl, TemplateOp op, int parent);
+void Template_AddCommand(Template* tpl, TemplateOp op, int target, int arg1, int arg2);
+int Template_AddText(Template* tpl, const QString& text);
+
+inline int Template_WidgetNew(Template* tpl, int parent) {
+    return Template_AddObject(tpl, TemplateOp_WidgetNew, parent);
+}
+
+inline int Template_VBoxLayoutNew(Template* tpl, int widget) {
+    return Template_AddObject(tpl, TemplateOp_VBoxLayoutNew, widget);
+}
+
+inline int Template_LabelNew(Template* tpl, int parent) {
+    return Template_AddObject(tpl, TemplateOp_LabelNew, parent);
+}
+
+inline int Template_PushButtonNew(Template* tpl, int parent) {
+    return Template_AddObject(tpl, TemplateOp_PushButtonNew, parent);
+}
+
+inline void Template_LayoutAddWidget(Template* tpl, int layout, int widget) {
+    Template_AddCommand(tpl, TemplateOp_LayoutAddWidget, layout, widget, 0);
+}
+
+inline void Template_WidgetSetSize(Template* tpl, int widget, int w, int h) {
+    Template_AddCommand(tpl, TemplateOp_WidgetSetSize, widget, w, h);
+}
+
+inline void Template_WidgetSetVisible(Template* tpl, int widget, bool isVisible) {
+    Template_AddCommand(tpl, TemplateOp_WidgetSetVisible, widget, isVisible, 0);
+}
+
+// text - результат Template_AddText или TemplateText_Param
+inline void Template_WidgetSetWindowTitle(Template* tpl, int widget, int text) {
+    Template_AddCommand(tpl, TemplateOp_WidgetSetWindowTitle, widget, text, 0);
+}
+
+inline void Template_LabelSetText(Template* tpl, int label, int text) {
+    Template_AddCommand(tpl, TemplateOp_LabelSetText, label, text, 0);
+}
+
+inline void Template_PushButtonSetText(Template* tpl, int button, int text) {
+    Template_AddCommand(tpl, TemplateOp_PushButtonSetText, button, text, 0);
+}
+
+// Строит count экземпляров. Корни экземпляров становятся дочерними виджетами parent
+//  и по порядку добавляются в его layout, если он есть. Свойства только что созданных
+//  виджетов задаются сразу, мимо очереди обновлений, а перерисовка окна на время
+//  построения отключается. Параметр p экземпляра i - байты UTF-8
+//  [offsets[k], offsets[k + 1]) в data, где k = i * paramCount + p; смещения проверяют
+//  биндинги. Только из GUI-потока
+void Template_Instantiate(const Template* tpl, Widget* parent, int count, const char* data,
+    const int64_t* offsets);
+
+//----------------------------------------------------------------------------------------
+// Ожидание готовности дескрипторов внутри цикла событий Qt, на нем держится цикл asyncio
+
+// Значения совпадают с selectors.EVENT_READ и selectors.EVENT_WRITE
+enum PollEvent : int {
+    PollEvent_Read = 1,
+    PollEvent_Write = 2
+};
+
+struct PollReady {
+    intptr_t fd;
+    int events;     // маска PollEvent
+};
+
+// Готовность дескрипторов отслеживают QSocketNotifier, срок ожидания - QTimer, так что
+//  пока Wait ждет, Qt как обычно обрабатывает ввод, перерисовку и очередь обновлений.
+//  Живет в GUI-потоке
+class EventPoller : public QObject {
+public:
+    EventPoller();
+
+    // events - маска PollEvent, 0 снимает дескриптор с отслеживания
+    void Watch(intptr_t fd, int events);
+    // Обрабатывает события Qt, пока не готов хотя бы один дескриптор, не прошло timeoutMs
+    //  (-1 - без ограничения, 0 - только уже накопившиеся события) или не вызван Interrupt
+    std::vector<PollReady> Wait(int timeoutMs);
+
+    void Interrupt() {
+        isInterrupted = true;
+    }
+
+    // Вызывается уведомителями из цикла событий
+    void SetReady(intptr_t fd, int event);
+
+private:
+    struct Notifiers {
+        QSocketNotifier* read;
+        QSocketNotifier* write;
+    };
+
+    // Уведомители создаются один раз на дескриптор и потом только включаются и выключаются:
+    //  asyncio меняет маску записи при каждом заполнении и опустошении буфера
+    void SetEnabled(intptr_t fd, QSocketNotifier*& notifier, int event, bool isEnabled);
+
+    std::unordered_map<intptr_t, Notifiers> notifiers;
+    std::vector<PollReady> ready;
+    QTimer* timer;
+    bool isInterrupted;
+    bool isTimedOut;
+};
+
+inline EventPoller* EventPoller_New() {
+    return new EventPoller();
+}
+
+// Удаляет сразу, если вызвана из GUI-потока, иначе - в его цикле событий
+inline void EventPoller_Delete(EventPoller* poller) {
+    if (poller->thread() == QThread::currentThread()) {
+        delete poller;
+    } else {
+        poller->deleteLater();
+    }
+}
+
+inline void EventPoller_Watch(EventPoller* poller, intptr_t fd, int events) {
+    poller->Watch(fd, events);
+}
+
+inline std::vector<PollReady> EventPoller_Wait(EventPoller* poller, int timeoutMs) {
+    return poller->Wait(timeoutMs);
+}
+
+// Прерывает EventPoller_Wait, идущий в текущем потоке, если такой есть. Биндинги
+//  вызывают ее после каждого обработчика, вызванного из цикла событий: обработчик мог
+//  поставить работу в цикл asyncio, и ждать дальше нельзя
+void EventPoller_InterruptWait();
+
+//----------------------------------------------------------------------------------------
+// Фоновые задачи на QThreadPool с доставкой завершений в GUI-поток пачками
+
+typedef void (*TaskFunction)(void* context);
+
+struct TaskCompletion {
+    void* context;
+    bool isCancelled;   // задача отменена до запуска, TaskFunction не вызывалась
+    bool isDropped;     // пул удален, пока задача выполнялась: только освободить context
+};
+
+// Получает пачку завершений задач, поставленных с этой функцией. Вызывается в GUI-потоке,
+//  кроме завершений с isDropped: они приходят из рабочего потока, и результат в них
+//  не доставляется
+typedef void (*TaskDoneFunction)(const TaskCompletion* completions, size_t count);
+
+struct TaskStats {
+    uint64_t submitted;
+    uint64_t completed;
+    uint64_t cancelled;
+    uint64_t queued;            // ждут свободного потока сейчас
+    uint64_t running;           // выполняются сейчас
+    uint64_t batches;           // доставлено пачек завершений
+    uint64_t waitNs;            // сумма по задачам: от постановки до запуска
+    uint64_t maxWaitNs;
+    uint64_t runNs;
+    uint64_t deliveryNs;        // сумма по задачам: от завершения до вызова TaskDoneFunction
+    uint64_t maxDeliveryNs;
+    int threadCount;
+};
+
+// Задачи выполняет QThreadPool::globalInstance (потоков по числу ядер). Завершения копятся
+//  и отдаются в GUI-поток одной пачкой на проход цикла событий, как у SignalBatch
+class TaskPool {
+public:
+    struct Shared;
+
+    explicit TaskPool(QObject* receiver);
+    // Снимает с очереди не начатые задачи (их завершения отдаются сразу) и не ждет
+    //  выполняющиеся: они могут ждать GIL у того, кто удаляет приложение. Их завершения
+    //  приходят потом из рабочего потока с isDropped
+    ~TaskPool();
+
+    uint64_t Submit(TaskFunction run, TaskDoneFunction done, void* context);
+    bool Cancel(uint64_t id);
+    TaskStats GetStats() const;
+
+private:
+    // Общее с задачами, которые могут пережить пул
+    std::shared_ptr<Shared> shared;
+};
+
+// Ставит run(context) в очередь и возвращает номер задачи. Можно вызывать из любого потока
+inline uint64_t TaskPool_Submit(Application* app, TaskFunction run, TaskDoneFunction done, void* context) {
+    return app->taskPool->Submit(run, done, context);
+}
+
+// Снимает задачу, если она еще не запущена; ее завершение придет с isCancelled
+inline bool TaskPool_Cancel(Application* app, uint64_t id) {
+    return app->taskPool->Cancel(id);
+}
+
+inline TaskStats TaskPool_GetStats(Application* app) {
+    return app->taskPool->GetStats();
+}
+
+//----------------------------------------------------------------------------------------
+// Таймеры и кадры на одном QTimer с выравниванием по обновлению экрана
+
+enum TimerKind {
+    TimerKind_Timeout,      // один раз через intervalMs
+    TimerKind_Interval,     // каждые intervalMs
+    TimerKind_Frame         // один раз в ближайший кадр
+};
+
+struct TimerStats {
+    uint64_t fires;
+    uint64_t overruns;      // вызов дольше периода; у кадра и разового таймера - дольше кадра
+    uint64_t skipped;       // периоды интервала, пропущенные из-за долгих вызовов
+    uint64_t throttled;     // срабатывания, отложенные, пока окно скрыто
+    uint64_t runNs;
+    uint64_t maxRunNs;
+    uint64_t lateNs;        // от срока до вызова
+    uint64_t maxLateNs;
+};
+
+struct SchedulerStats {
+    uint64_t ticks;         // проходы, в которых были вызовы
+    uint64_t fires;
+    uint64_t coalesced;     // вызовы, попавшие в один проход с другими
+    uint64_t throttled;
+    uint64_t overruns;
+    uint64_t timers;        // активных сейчас
+    uint64_t frameIntervalNs;
+};
+
+// frameTime - срок кадра в секундах по steady_clock (в Python - шкала time.monotonic)
+typedef void (*TimerFunction)(void* context, double frameTime);
+// Таймер снят: отработал разовый, отменен или удален его виджет
+typedef void (*TimerReleaseFunction)(void* context, const TimerStats& stats);
+// Обрамляют все вызовы одного прохода, например чтобы брать GIL один раз
+typedef void* (*TimerBatchEnterFunction)();
+typedef void (*TimerBatchLeaveFunction)(void* state);
+
+// Все таймеры приложения на одном QTimer. Сроки округляются вверх до границы кадра
+//  (частота основного экрана), поэтому таймеры, которым пора в одном кадре, вызываются
+//  одним проходом. Пока окно таймера скрыто, он срабатывает не чаще ThrottledIntervalMs.
+//  Только из GUI-потока
+class Scheduler : public QObject {
+public:
+    static constexpr int ThrottledIntervalMs = 1000;
+
+    Scheduler();
+    // Снимает оставшиеся таймеры, вызывая их TimerReleaseFunction
+    ~Scheduler();
+
+    void SetBatchHooks(TimerBatchEnterFunction enter, TimerBatchLeaveFunction leave);
+    // owner - виджет, по окну которого таймер притормаживается и с удалением которого
+    //  снимается; без него таймер притормаживается, когда скрыты все окна приложения
+    uint64_t Add(TimerKind kind, int intervalMs, QWidget* owner, TimerFunction run,
+        TimerReleaseFunction release, void* context);
+    bool Remove(uint64_t id);
+    bool GetTimerStats(uint64_t id, TimerStats* stats) const;
+    SchedulerStats GetStats() const;
+
+protected:
+    bool eventFilter(QObject* watched, QEvent* event) override;
+
+private:
+    typedef std::multimap<int64_t, uint64_t> Queue;
+
+    struct Entry {
+        TimerKind kind;
+        int64_t intervalNs;
+        bool hasOwner;
+        QPointer<QWidget> owner;
+        TimerFunction run;
+        TimerReleaseFunction release;
+        void* context;
+        int64_t nominalNs;      // срок без выравнивания, от него считается следующий период
+        int64_t lastRunNs;
+        bool isThrottled;
+        bool isRemoved;         // снят из собственного вызова
+        Queue::iterator slot;
+        TimerStats stats;
+    };
+
+    int64_t GetNowNs() const;
+    int64_t AlignToFrame(int64_t ns) const;
+    void Schedule(uint64_t id, Entry& entry, int64_t nominalNs, int64_t deadlineNs);
+    void SetThrottled(Entry& entry, bool isThrottled);
+    void Finish(uint64_t id);
+    bool AreWindowsHidden() const;
+    void Arm();
+    void Tick();
+
+    std::unordered_map<uint64_t, Entry> timers;
+    Queue queue;                // срок -> номер
+    QTimer* timer;
+    std::chrono::steady_clock::time_point origin;
+    int64_t frameNs;
+    uint64_t nextId;
+    uint64_t runningId;         // чей вызов идет, 0 вне прохода
+    size_t throttledCount;
+    TimerBatchEnterFunction enterBatch;
+    TimerBatchLeaveFunction leaveBatch;
+    SchedulerStats stats;
+};
+
+inline uint64_t Scheduler_Add(Application* app, TimerKind kind, int intervalMs, QWidget* owner,
+    TimerFunction run, TimerReleaseFunction release, void* context)
+{
+    return app->scheduler->Add(kind, intervalMs, owner, run, release, context);
+}
+
+inline bool Scheduler_Remove(Application* app, uint64_t id) {
+    return app->scheduler->Remove(id);
+}
+
+inline void Scheduler_SetBatchHooks(Application* app, TimerBatchEnterFunction enter, TimerBatchLeaveFunction leave) {
+    app->scheduler->SetBatchHooks(enter, leave);
+}
+
+inline bool Scheduler_GetTimerStats(Application* app, uint64_t id, TimerStats* stats) {
+    return app->scheduler->GetTimerStats(id, stats);
+}
+
+inline SchedulerStats Scheduler_GetStats(Application* app) {
+    return app->scheduler->GetStats();
+}
+
 #endif // WIDGETS_H